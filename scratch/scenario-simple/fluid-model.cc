@@ -0,0 +1,246 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "fluid-model.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FluidModel");
+NS_OBJECT_ENSURE_REGISTERED (FluidModel);
+
+FluidModel::FluidModel ()
+  : m_lastUpdate (Time (0))
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FluidModel::~FluidModel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+FluidModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FluidModel")
+    .SetParent<Object> ()
+    .AddConstructor<FluidModel> ()
+    .AddTraceSource ("FlowRate", "Fluid flow rate trace source.",
+                     MakeTraceSourceAccessor (&FluidModel::m_flowRateTrace),
+                     "ns3::FluidModel::FlowRateTracedCallback")
+  ;
+  return tid;
+}
+
+uint32_t
+FluidModel::AddLink (DataRate capacity)
+{
+  NS_LOG_FUNCTION (this << capacity);
+
+  m_linkCapacity.push_back (static_cast<double> (capacity.GetBitRate ()));
+  m_linkLoad.push_back (0);
+  return m_linkCapacity.size () - 1;
+}
+
+void
+FluidModel::AddFlow (uint32_t flowId, DataRate rate, Path_t path,
+                     double outScale, Time startTime, Time stopTime)
+{
+  NS_LOG_FUNCTION (this << flowId << rate << outScale << startTime << stopTime);
+
+  FluidFlow flow;
+  flow.demand = static_cast<double> (rate.GetBitRate ());
+  flow.path = path;
+  flow.outScale = outScale;
+  flow.active = false;
+  flow.throughput = 0;
+  flow.rxBytes = 0;
+  for (auto const &hop : flow.path)
+    {
+      NS_ABORT_MSG_IF (hop.first >= m_linkCapacity.size (), "Invalid link ID.");
+    }
+
+  auto ret = m_flows.insert (std::make_pair (flowId, flow));
+  NS_ABORT_MSG_IF (ret.second == false, "Existing fluid flow with this ID.");
+
+  Simulator::Schedule (startTime - Simulator::Now (),
+                       &FluidModel::SetFlowActive, this, flowId, true);
+  Simulator::Schedule (stopTime - Simulator::Now (),
+                       &FluidModel::SetFlowActive, this, flowId, false);
+}
+
+DataRate
+FluidModel::GetFlowRate (uint32_t flowId) const
+{
+  NS_LOG_FUNCTION (this << flowId);
+
+  auto it = m_flows.find (flowId);
+  NS_ABORT_MSG_IF (it == m_flows.end (), "Fluid flow not found.");
+  return DataRate (static_cast<uint64_t> (it->second.throughput * it->second.outScale));
+}
+
+uint64_t
+FluidModel::GetFlowRxBytes (uint32_t flowId) const
+{
+  NS_LOG_FUNCTION (this << flowId);
+
+  auto it = m_flows.find (flowId);
+  NS_ABORT_MSG_IF (it == m_flows.end (), "Fluid flow not found.");
+
+  // Include the bytes delivered since the last update.
+  double elapsed = (Simulator::Now () - m_lastUpdate).GetSeconds ();
+  double bytes = it->second.rxBytes +
+    it->second.throughput * it->second.outScale * elapsed / 8;
+  return static_cast<uint64_t> (bytes);
+}
+
+double
+FluidModel::GetLinkUsage (uint32_t linkId) const
+{
+  NS_LOG_FUNCTION (this << linkId);
+
+  NS_ABORT_MSG_IF (linkId >= m_linkCapacity.size (), "Invalid link ID.");
+  return m_linkCapacity.at (linkId) ?
+         m_linkLoad.at (linkId) / m_linkCapacity.at (linkId) : 0;
+}
+
+void
+FluidModel::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+
+  m_flows.clear ();
+  Object::DoDispose ();
+}
+
+void
+FluidModel::SetFlowActive (uint32_t flowId, bool active)
+{
+  NS_LOG_FUNCTION (this << flowId << active);
+
+  UpdateRxBytes ();
+  m_flows.at (flowId).active = active;
+  UpdateAllocation ();
+}
+
+void
+FluidModel::UpdateRxBytes (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  double elapsed = (Simulator::Now () - m_lastUpdate).GetSeconds ();
+  for (auto &it : m_flows)
+    {
+      it.second.rxBytes += it.second.throughput * it.second.outScale * elapsed / 8;
+    }
+  m_lastUpdate = Simulator::Now ();
+}
+
+void
+FluidModel::UpdateAllocation (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // Save the current allocation so we can report only the changed flows.
+  std::map<uint32_t, double> oldThroughput;
+  for (auto const &it : m_flows)
+    {
+      oldThroughput[it.first] = it.second.throughput;
+    }
+
+  // Progressive filling: the throughput of all unfrozen flows grows together
+  // (each link consuming the throughput times the hop multiplier) until either
+  // the flow reaches its demand or a link in its path gets saturated.
+  std::vector<FluidFlow*> unfrozen;
+  for (auto &it : m_flows)
+    {
+      it.second.throughput = 0;
+      if (it.second.active && it.second.demand > 0)
+        {
+          unfrozen.push_back (&it.second);
+        }
+    }
+  std::vector<double> residual (m_linkCapacity);
+  std::vector<double> weight (m_linkCapacity.size ());
+  double level = 0;
+  while (!unfrozen.empty ())
+    {
+      // Compute the fill increment limited by demands and links.
+      std::fill (weight.begin (), weight.end (), 0);
+      double delta = std::numeric_limits<double>::max ();
+      for (auto flow : unfrozen)
+        {
+          delta = std::min (delta, flow->demand - level);
+          for (auto const &hop : flow->path)
+            {
+              weight[hop.first] += hop.second;
+            }
+        }
+      for (size_t l = 0; l < residual.size (); l++)
+        {
+          if (weight[l] > 0)
+            {
+              delta = std::min (delta, residual[l] / weight[l]);
+            }
+        }
+      delta = std::max (delta, 0.0);
+      level += delta;
+      for (size_t l = 0; l < residual.size (); l++)
+        {
+          residual[l] -= weight[l] * delta;
+        }
+
+      // Freeze flows that reached their demand or a saturated link.
+      const double epsilon = 1e-6;
+      auto it = unfrozen.begin ();
+      while (it != unfrozen.end ())
+        {
+          FluidFlow *flow = *it;
+          bool freeze = (flow->demand - level <= epsilon);
+          for (auto const &hop : flow->path)
+            {
+              freeze |= (residual[hop.first] <= epsilon * m_linkCapacity[hop.first]);
+            }
+          if (freeze)
+            {
+              flow->throughput = std::min (level, flow->demand);
+              it = unfrozen.erase (it);
+            }
+          else
+            {
+              ++it;
+            }
+        }
+    }
+
+  // Update link loads and fire trace sources for the changed flows.
+  std::fill (m_linkLoad.begin (), m_linkLoad.end (), 0);
+  for (auto const &it : m_flows)
+    {
+      for (auto const &hop : it.second.path)
+        {
+          m_linkLoad[hop.first] += it.second.throughput * hop.second;
+        }
+      if (it.second.throughput != oldThroughput[it.first])
+        {
+          DataRate rate (static_cast<uint64_t> (it.second.throughput * it.second.outScale));
+          NS_LOG_INFO ("Fluid flow " << it.first << " rate changed to " << rate);
+          m_flowRateTrace (it.first, rate);
+        }
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,149 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLUID_MODEL_H
+#define FLUID_MODEL_H
+
+#include <ns3/core-module.h>
+#include <ns3/network-module.h>
+
+namespace ns3 {
+
+/**
+ * Rate-based (fluid) traffic model for the SDN network. Instead of sending
+ * individual packets, each fluid flow is described by its source data rate
+ * and by the list of links it traverses. The VNFs in the chain are accounted
+ * for analytically: each link on the path carries the source rate multiplied
+ * by the scaling factors of the VNFs already traversed. Links are shared-rate
+ * resources, and the throughput of active flows is computed with a max-min
+ * fair allocation. The allocation is only recomputed when a flow starts or
+ * stops, so the number of simulation events doesn't depend on the flow rates.
+ *
+ * Fluid flows don't interact with the packet-level traffic: the links here are
+ * only used to share capacity among fluid flows.
+ */
+class FluidModel : public Object
+{
+public:
+  FluidModel ();            //!< Default constructor.
+  virtual ~FluidModel ();   //!< Dummy destructor, see DoDispose.
+
+  /**
+   * Register this type.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** A link in the flow path and the rate multiplier for this link. */
+  typedef std::pair<uint32_t, double> Hop_t;
+
+  /** The list of links traversed by a flow. */
+  typedef std::vector<Hop_t> Path_t;
+
+  /**
+   * Create a new unidirectional shared-rate link.
+   * \param capacity The link capacity.
+   * \return The link ID.
+   */
+  uint32_t AddLink (DataRate capacity);
+
+  /**
+   * Create a new fluid flow.
+   * \param flowId The flow ID.
+   * \param rate The flow source data rate.
+   * \param path The links traversed by this flow.
+   * \param outScale The rate multiplier at the flow destination.
+   * \param startTime The flow start time.
+   * \param stopTime The flow stop time.
+   */
+  void AddFlow (uint32_t flowId, DataRate rate, Path_t path, double outScale,
+                Time startTime, Time stopTime);
+
+  /**
+   * Get the current data rate delivered to the flow destination.
+   * \param flowId The flow ID.
+   * \return The data rate.
+   */
+  DataRate GetFlowRate (uint32_t flowId) const;
+
+  /**
+   * Get the total number of bytes delivered to the flow destination so far.
+   * \param flowId The flow ID.
+   * \return The number of bytes.
+   */
+  uint64_t GetFlowRxBytes (uint32_t flowId) const;
+
+  /**
+   * Get the current link usage ratio by the fluid flows.
+   * \param linkId The link ID.
+   * \return The usage ratio in the [0, 1] interval.
+   */
+  double GetLinkUsage (uint32_t linkId) const;
+
+  /**
+   * TracedCallback signature for flow rate changes.
+   * \param flowId The flow ID.
+   * \param rate The data rate delivered to the flow destination.
+   */
+  typedef void (*FlowRateTracedCallback)(uint32_t flowId, DataRate rate);
+
+protected:
+  /** Destructor implementation. */
+  virtual void DoDispose ();
+
+private:
+  /** Metadata associated to a fluid flow. */
+  struct FluidFlow
+  {
+    double    demand;             //!< Source data rate (bps).
+    Path_t    path;               //!< Links traversed by this flow.
+    double    outScale;           //!< Rate multiplier at the destination.
+    bool      active;             //!< Flow active status.
+    double    throughput;         //!< Allocated source throughput (bps).
+    double    rxBytes;            //!< Bytes delivered to the destination.
+  };
+
+  /**
+   * Start or stop a fluid flow and update the rate allocation.
+   * \param flowId The flow ID.
+   * \param active The new flow status.
+   */
+  void SetFlowActive (uint32_t flowId, bool active);
+
+  /**
+   * Account the bytes delivered by active flows since the last update.
+   */
+  void UpdateRxBytes (void);
+
+  /**
+   * Compute the max-min fair rate allocation for all active flows and fire
+   * the trace source for flows with new rates.
+   */
+  void UpdateAllocation (void);
+
+  /** Trace source fired when the rate delivered to a flow changes. */
+  TracedCallback<uint32_t, DataRate> m_flowRateTrace;
+
+  /** Map saving flow ID / fluid flow metadata. */
+  typedef std::map<uint32_t, FluidFlow> FlowMap_t;
+  FlowMap_t             m_flows;            //!< Fluid flows.
+  std::vector<double>   m_linkCapacity;     //!< Link capacities (bps).
+  std::vector<double>   m_linkLoad;         //!< Link loads (bps).
+  Time                  m_lastUpdate;       //!< Last rx bytes update time.
+};
+
+} // namespace ns3
+#endif // FLUID_MODEL_H
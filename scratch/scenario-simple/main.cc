@@ -19,6 +19,7 @@
 #include <ns3/core-module.h>
 #include <ns3/internet-module.h>
 #include <ns3/ofswitch13-module.h>
+#include "pipeline-model.h"
 #include "sdn-network.h"
 #include "vnf-info.h"
 
@@ -27,6 +28,10 @@ using namespace ns3;
 void EnableProgress (int);
 void EnableLibLog  (bool);
 void EnableVerbose (bool);
+void EnableRuleReport (bool);
+void EnableLatencyReport (bool);
+void ReportPipelineLatency (void);
+void ReportShards (Ptr<SdnNetwork>);
 void ForceDefaults (void);
 
 int
@@ -38,6 +43,12 @@ main (int argc, char *argv[])
   bool  verbose  = false;
   bool  libLog   = false;
   bool  pcapLog  = false;
+  bool  aggregate = false;
+  bool  ruleReport = false;
+  bool  latencyReport = false;
+  bool  shardReport = false;
+  int   controllers = 1;
+  bool  unitTests = false;
 
   // Parse the command line arguments and force default attributes.
   CommandLine cmd;
@@ -46,8 +57,21 @@ main (int argc, char *argv[])
   cmd.AddValue ("SimTime",  "Simulation time (sec)", simTime);
   cmd.AddValue ("Verbose",  "Enable verbose output.", verbose);
   cmd.AddValue ("Pcap",     "Enable PCAP output.", pcapLog);
+  cmd.AddValue ("AggregateRoutes", "Route traffics to hosts with per-host rules.", aggregate);
+  cmd.AddValue ("RuleReport", "Report the rule count of the switches.", ruleReport);
+  cmd.AddValue ("LatencyReport", "Report the pipeline latency of the switches.", latencyReport);
+  cmd.AddValue ("Controllers", "Number of controller shards.", controllers);
+  cmd.AddValue ("ShardReport", "Report the control plane metrics of each shard.", shardReport);
+  cmd.AddValue ("UnitTests", "Run the scenario unit tests and exit.", unitTests);
   cmd.Parse (argc, argv);
+
+  // The scenario test suites are only linked into this program.
+  if (unitTests)
+    {
+      return TestRunner::Run (1, argv);
+    }
   ForceDefaults ();
+  Config::SetDefault ("ns3::SdnController::AggregateRoutes", BooleanValue (aggregate));
 
   // Enable verbose output, library log, and progress report for debug purposes.
   EnableLibLog (libLog);
@@ -57,8 +81,11 @@ main (int argc, char *argv[])
   // ------------------------------------------------------------------------ //
   // Create the SDN network.
   Ptr<SdnNetwork> sdnNetwork = CreateObjectWithAttributes<SdnNetwork> (
-    "NumberVnfs", UintegerValue (6), "NumberNodes", UintegerValue (3));
+    "NumberVnfs", UintegerValue (6), "NumberNodes", UintegerValue (3),
+    "NumberControllers", UintegerValue (controllers));
   sdnNetwork->EnablePcap (pcapLog);
+  EnableRuleReport (ruleReport);
+  EnableLatencyReport (latencyReport);
 
   // Configure VNFs
   // VNFs 0 and 1: network service
@@ -81,6 +108,10 @@ main (int argc, char *argv[])
   sdnNetwork->NewServiceTraffic (
     2, 2, {4, 5}, Seconds (25), Seconds (40));
 
+  // Replay the packets of flow 10001 from a captured trace file.
+  // sdnNetwork->NewServiceTraffic (
+  //   0, 1, {0, 2}, Seconds (5), Seconds (40), "traffic.pcap", 10001);
+
   // sdnNetwork->NewBackgroundTraffic (
   //   1, 0, Seconds (10), Seconds (25),
   //   "ns3::ConstantRandomVariable[Constant=1000]",
@@ -98,6 +129,9 @@ main (int argc, char *argv[])
   //   "ns3::ConstantRandomVariable[Constant=512]",
   //   "ns3::ConstantRandomVariable[Constant=0.01]");
 
+  // Background traffic using the fluid (rate-based) model.
+  // sdnNetwork->NewFluidBackgroundTraffic (
+  //   1, 2, Seconds (10), Seconds (25), DataRate ("4Mbps"));
 
   // ------------------------------------------------------------------------ //
 
@@ -109,6 +143,14 @@ main (int argc, char *argv[])
   Simulator::Stop (Seconds (simTime) + MilliSeconds (100));
   Simulator::Run ();
   std::cout << "Done!" << std::endl;
+  if (latencyReport)
+    {
+      ReportPipelineLatency ();
+    }
+  if (shardReport)
+    {
+      ReportShards (sdnNetwork);
+    }
   Simulator::Destroy ();
   sdnNetwork->Dispose ();
   sdnNetwork = 0;
@@ -135,6 +177,76 @@ EnableProgress (int interval)
     }
 }
 
+void
+ReportRuleCount (uint64_t dpId, uint32_t rules, uint32_t traffics)
+{
+  std::cout << Simulator::Now ().As (Time::S) << " switch " << dpId << ": "
+            << rules << " rules, " << traffics << " active traffics" << std::endl;
+}
+
+void
+EnableRuleReport (bool enable)
+{
+  if (enable)
+    {
+      Config::Set ("/NodeList/*/ApplicationList/*/$ns3::SdnController/StatsPollInterval",
+                   TimeValue (Seconds (1)));
+      Config::ConnectWithoutContext (
+        "/NodeList/*/ApplicationList/*/$ns3::SdnController/RuleCount",
+        MakeCallback (&ReportRuleCount));
+    }
+}
+
+void
+EnableLatencyReport (bool enable)
+{
+  if (enable)
+    {
+      Config::Set ("/NodeList/*/ApplicationList/*/$ns3::SdnController/StatsPollInterval",
+                   TimeValue (Seconds (1)));
+    }
+}
+
+void
+ReportPipelineLatency (void)
+{
+  Config::MatchContainer matches =
+    Config::LookupMatches ("/NodeList/*/DeviceList/*/$ns3::PipelineModel");
+  for (uint32_t i = 0; i < matches.GetN (); i++)
+    {
+      Ptr<PipelineModel> pipeline = matches.Get (i)->GetObject<PipelineModel> ();
+      std::cout << matches.GetMatchingPath (i) << ": mean lookup latency "
+                << pipeline->GetMeanDelay ().As (Time::US) << std::endl;
+      for (uint32_t bin = 0; bin < pipeline->GetNBins (); bin++)
+        {
+          if (pipeline->GetBinCount (bin))
+            {
+              std::cout << "  " << std::setw (12)
+                        << pipeline->GetBinStart (bin).As (Time::US) << " "
+                        << pipeline->GetBinCount (bin) << " packets" << std::endl;
+            }
+        }
+    }
+}
+
+void
+ReportShards (Ptr<SdnNetwork> sdnNetwork)
+{
+  Config::MatchContainer matches =
+    Config::LookupMatches ("/NodeList/*/ApplicationList/*/$ns3::SdnController");
+  for (uint32_t i = 0; i < matches.GetN (); i++)
+    {
+      Ptr<SdnController> controller = matches.Get (i)->GetObject<SdnController> ();
+      std::cout << "shard " << controller->GetShardId () << ": mean packet-in delay "
+                << controller->GetAveragePacketInDelay ().As (Time::US) << ", "
+                << controller->GetCrossShardRequests () << " cross-shard messages"
+                << std::endl;
+    }
+  Ptr<SharedRegistry> registry = sdnNetwork->GetRegistry ();
+  std::cout << "registry: " << registry->GetUpdates () << " replica updates, "
+            << registry->GetStaleReads () << " stale reads" << std::endl;
+}
+
 void
 EnableVerbose (bool enable)
 {
@@ -162,6 +274,7 @@ EnableVerbose (bool enable)
 
       LogComponentEnable ("SdnController",            logLevelWarnInfo);
       LogComponentEnable ("SdnNetwork",               logLevelWarnInfo);
+      LogComponentEnable ("SharedRegistry",           logLevelWarnInfo);
       LogComponentEnable ("SourceApp",                logLevelWarnInfo);
       LogComponentEnable ("SinkApp",                  logLevelWarnInfo);
       LogComponentEnable ("VnfApp",                   logLevelWarnInfoDebug);
@@ -0,0 +1,195 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ns3/ofswitch13-module.h>
+#include "pipeline-model.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PipelineModel");
+NS_OBJECT_ENSURE_REGISTERED (PipelineModel);
+
+PipelineModel::PipelineModel ()
+  : m_packets (0),
+    m_delaySum (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+PipelineModel::~PipelineModel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+PipelineModel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PipelineModel")
+    .SetParent<Object> ()
+    .AddConstructor<PipelineModel> ()
+    .AddAttribute ("TcamDelay",
+                   "The time of a TCAM search in a table fitting in a "
+                   "single TCAM block.",
+                   TimeValue (MicroSeconds (15)),
+                   MakeTimeAccessor (&PipelineModel::m_tcamDelay),
+                   MakeTimeChecker (Time (0)))
+    .AddAttribute ("TcamBlockSize",
+                   "The number of entries in a TCAM block.",
+                   UintegerValue (256),
+                   MakeUintegerAccessor (&PipelineModel::m_tcamBlockSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("TcamBlockDelay",
+                   "The extra search time for each additional TCAM block "
+                   "spanned by a table.",
+                   TimeValue (MicroSeconds (1)),
+                   MakeTimeAccessor (&PipelineModel::m_tcamBlockDelay),
+                   MakeTimeChecker (Time (0)))
+    .AddAttribute ("SramDelay",
+                   "The time to fetch the instructions of the matched entry "
+                   "from SRAM, for each table visited.",
+                   TimeValue (MicroSeconds (5)),
+                   MakeTimeAccessor (&PipelineModel::m_sramDelay),
+                   MakeTimeChecker (Time (0)))
+    .AddAttribute ("HistogramBinWidth",
+                   "The width of the lookup latency histogram bins.",
+                   TimeValue (MicroSeconds (1)),
+                   MakeTimeAccessor (&PipelineModel::m_binWidth),
+                   MakeTimeChecker (NanoSeconds (1)))
+    .AddTraceSource ("PipelineDelay", "Pipeline delay of the switch updated.",
+                     MakeTraceSourceAccessor (&PipelineModel::m_delayTrace),
+                     "ns3::PipelineModel::DelayTracedCallback")
+  ;
+  return tid;
+}
+
+Time
+PipelineModel::GetTableDelay (uint32_t entries) const
+{
+  uint32_t blocks = (entries + m_tcamBlockSize - 1) / m_tcamBlockSize;
+  Time delay = m_tcamDelay + m_sramDelay;
+  if (blocks > 1)
+    {
+      delay += m_tcamBlockDelay * (blocks - 1);
+    }
+  return delay;
+}
+
+Time
+PipelineModel::GetPipelineDelay (const std::vector<uint32_t> &entries,
+                                 size_t tables) const
+{
+  Time delay = Time (0);
+  for (size_t t = 0; t < tables; t++)
+    {
+      delay += GetTableDelay (t < entries.size () ? entries [t] : 0);
+    }
+  return delay;
+}
+
+void
+PipelineModel::Update (const std::vector<uint32_t> &entries,
+                       const std::vector<uint64_t> &packets)
+{
+  NS_LOG_FUNCTION (this);
+
+  // The packets matched in a table and not sent on to the next one leave
+  // the pipeline there, after visiting all the previous tables.
+  uint64_t totalPackets = 0;
+  double totalDelay = 0;
+  for (size_t t = 0; t < packets.size (); t++)
+    {
+      uint64_t next = (t + 1 < packets.size ()) ? packets [t + 1] : 0;
+      uint64_t leaving = packets [t] > next ? packets [t] - next : 0;
+      if (leaving)
+        {
+          Time delay = GetPipelineDelay (entries, t + 1);
+          RecordLookups (delay, leaving);
+          totalPackets += leaving;
+          totalDelay += delay.GetSeconds () * leaving;
+        }
+    }
+
+  // The switch device applies a single delay to all packets, so it gets the
+  // mean delay of the last interval. Idle switches get the first table one.
+  Time delay = totalPackets ? Seconds (totalDelay / totalPackets)
+                            : GetPipelineDelay (entries, 1);
+  Ptr<OFSwitch13Device> device = GetObject<OFSwitch13Device> ();
+  if (device)
+    {
+      device->SetAttribute ("TcamDelay", TimeValue (delay));
+    }
+  NS_LOG_DEBUG ("Pipeline delay " << delay.As (Time::US) << " for " <<
+                totalPackets << " packets");
+  m_delayTrace (delay);
+}
+
+Time
+PipelineModel::GetMeanDelay (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  return m_packets ? Seconds (m_delaySum / m_packets) : Time (0);
+}
+
+uint32_t
+PipelineModel::GetNBins (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  return m_histogram.size ();
+}
+
+Time
+PipelineModel::GetBinStart (uint32_t bin) const
+{
+  NS_LOG_FUNCTION (this << bin);
+
+  return m_binWidth * bin;
+}
+
+uint64_t
+PipelineModel::GetBinCount (uint32_t bin) const
+{
+  NS_LOG_FUNCTION (this << bin);
+
+  return bin < m_histogram.size () ? m_histogram [bin] : 0;
+}
+
+void
+PipelineModel::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+
+  m_histogram.clear ();
+  Object::DoDispose ();
+}
+
+void
+PipelineModel::RecordLookups (Time delay, uint64_t packets)
+{
+  NS_LOG_FUNCTION (this << delay << packets);
+
+  uint32_t bin = delay.GetTimeStep () / m_binWidth.GetTimeStep ();
+  if (bin >= m_histogram.size ())
+    {
+      m_histogram.resize (bin + 1, 0);
+    }
+  m_histogram [bin] += packets;
+  m_packets += packets;
+  m_delaySum += delay.GetSeconds () * packets;
+}
+
+} // namespace ns3
@@ -0,0 +1,125 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PIPELINE_MODEL_H
+#define PIPELINE_MODEL_H
+
+#include <ns3/core-module.h>
+
+namespace ns3 {
+
+/**
+ * Analytic lookup latency model for the pipeline of an OpenFlow switch. Each
+ * flow table visited by a packet costs one TCAM search, which gets slower as
+ * the table spans more TCAM blocks, plus one SRAM access to fetch the
+ * instructions of the matched entry. A packet sent to table 1 by a goto
+ * instruction thus pays for both tables.
+ *
+ * The model is aggregated to the switch device. It is fed with the number of
+ * entries and the number of matched packets in each table, as seen by the
+ * controller statistics poller, and sets the TcamDelay attribute of the
+ * device to the mean pipeline delay of the packets in the last interval. The
+ * lookup latencies are also accumulated in a histogram, weighted by the
+ * number of packets.
+ */
+class PipelineModel : public Object
+{
+public:
+  PipelineModel ();           //!< Default constructor.
+  virtual ~PipelineModel ();  //!< Dummy destructor, see DoDispose.
+
+  /**
+   * Register this type.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * Get the lookup delay of a single flow table.
+   * \param entries The number of entries in the table.
+   * \return The lookup delay.
+   */
+  Time GetTableDelay (uint32_t entries) const;
+
+  /**
+   * Get the lookup delay of a packet visiting the first tables of the
+   * pipeline.
+   * \param entries The number of entries in each table.
+   * \param tables The number of tables visited.
+   * \return The pipeline delay.
+   */
+  Time GetPipelineDelay (const std::vector<uint32_t> &entries,
+                         size_t tables) const;
+
+  /**
+   * Update the model with the flow table usage of the switch in the last
+   * interval, and set the delay of the switch device.
+   * \param entries The number of entries in each table.
+   * \param packets The number of packets matched in each table.
+   */
+  void Update (const std::vector<uint32_t> &entries,
+               const std::vector<uint64_t> &packets);
+
+  /**
+   * Get the mean pipeline delay of all the packets accounted so far.
+   * \return The mean pipeline delay.
+   */
+  Time GetMeanDelay (void) const;
+
+  /**
+   * \name Lookup latency histogram accessors.
+   * \param bin The bin index.
+   */
+  //\{
+  uint32_t GetNBins     (void) const;
+  Time     GetBinStart  (uint32_t bin) const;
+  uint64_t GetBinCount  (uint32_t bin) const;
+  //\}
+
+  /**
+   * TracedCallback signature for pipeline delay updates.
+   * \param delay The mean pipeline delay in the last interval.
+   */
+  typedef void (*DelayTracedCallback)(Time delay);
+
+protected:
+  /** Destructor implementation. */
+  virtual void DoDispose ();
+
+private:
+  /**
+   * Account packets in the lookup latency histogram.
+   * \param delay The pipeline delay of the packets.
+   * \param packets The number of packets.
+   */
+  void RecordLookups (Time delay, uint64_t packets);
+
+  Time                  m_tcamDelay;      //!< TCAM search time.
+  uint32_t              m_tcamBlockSize;  //!< Entries per TCAM block.
+  Time                  m_tcamBlockDelay; //!< Extra search time per block.
+  Time                  m_sramDelay;      //!< SRAM instruction fetch time.
+  Time                  m_binWidth;       //!< Histogram bin width.
+
+  std::vector<uint64_t> m_histogram;      //!< Packets per latency bin.
+  uint64_t              m_packets;        //!< Packets accounted.
+  double                m_delaySum;       //!< Sum of packet delays (s).
+
+  /** Trace source fired when the pipeline delay is updated. */
+  TracedCallback<Time>  m_delayTrace;
+};
+
+} // namespace ns3
+#endif /* PIPELINE_MODEL_H */
@@ -0,0 +1,494 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <chrono>
+#include "placement-engine.h"
+#include "vnf-info.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("PlacementEngine");
+NS_OBJECT_ENSURE_REGISTERED (PlacementEngine);
+NS_OBJECT_ENSURE_REGISTERED (CorePlacement);
+NS_OBJECT_ENSURE_REGISTERED (GreedyPlacement);
+
+// -------------------------------------------------------------------------- //
+PlacementEngine::PlacementEngine ()
+  : m_numNodes (0),
+    m_numVnfs (0),
+    m_decisions (0),
+    m_solverNs (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+PlacementEngine::~PlacementEngine ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+PlacementEngine::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::PlacementEngine")
+    .SetParent<Object> ()
+    .AddTraceSource ("Placement", "VNF placement decision trace source.",
+                     MakeTraceSourceAccessor (&PlacementEngine::m_placementTrace),
+                     "ns3::PlacementEngine::PlacementTracedCallback")
+  ;
+  return tid;
+}
+
+void
+PlacementEngine::SetTopology (uint32_t numNodes, uint32_t numVnfs)
+{
+  NS_LOG_FUNCTION (this << numNodes << numVnfs);
+
+  m_numNodes = numNodes;
+  m_numVnfs = numVnfs;
+  m_netCapacity.assign (numNodes * numNodes, 0);
+  m_netLoad.assign (numNodes * numNodes, 0);
+  m_vnfCapacity.assign (numNodes * numVnfs, 0);
+  m_vnfLoad.assign (numNodes * numVnfs, 0);
+  m_srvCapacity.assign (numNodes, 0);
+  m_srvLoad.assign (numNodes, 0);
+  m_placements.clear ();
+}
+
+void
+PlacementEngine::SetNetworkLinkCapacity (uint32_t srcNodeId, uint32_t dstNodeId,
+                                         DataRate capacity)
+{
+  NS_LOG_FUNCTION (this << srcNodeId << dstNodeId << capacity);
+
+  NS_ABORT_MSG_IF (srcNodeId >= m_numNodes || dstNodeId >= m_numNodes,
+                   "Invalid network node ID.");
+  m_netCapacity.at (srcNodeId * m_numNodes + dstNodeId) =
+    static_cast<double> (capacity.GetBitRate ());
+}
+
+void
+PlacementEngine::SetVnfLinkCapacity (uint32_t serverId, uint8_t vnfId,
+                                     DataRate capacity)
+{
+  NS_LOG_FUNCTION (this << serverId << (uint16_t)vnfId << capacity);
+
+  NS_ABORT_MSG_IF (serverId >= m_numNodes || vnfId >= m_numVnfs,
+                   "Invalid server or VNF ID.");
+  double &linkCapacity = m_vnfCapacity.at (serverId * m_numVnfs + vnfId);
+  m_srvCapacity.at (serverId) -= linkCapacity;
+  linkCapacity = static_cast<double> (capacity.GetBitRate ());
+  m_srvCapacity.at (serverId) += linkCapacity;
+}
+
+std::vector<uint32_t>
+PlacementEngine::Place (uint16_t trafficId, uint32_t srcHostId,
+                        uint32_t dstHostId, std::vector<uint8_t> vnfList,
+                        DataRate rate)
+{
+  NS_LOG_FUNCTION (this << trafficId << srcHostId << dstHostId << rate);
+
+  Placement placement;
+  placement.request.srcHostId = srcHostId;
+  placement.request.dstHostId = dstHostId;
+  placement.request.vnfList = vnfList;
+  placement.request.rate = static_cast<double> (rate.GetBitRate ());
+
+  // The solver time is the wall-clock time, as the simulation clock doesn't
+  // advance during the decision.
+  auto solverStart = std::chrono::steady_clock::now ();
+  if (!vnfList.empty ())
+    {
+      placement.serverList = DoPlace (placement.request);
+    }
+  auto solverStop = std::chrono::steady_clock::now ();
+  Time solverTime = NanoSeconds (
+    std::chrono::duration_cast<std::chrono::nanoseconds> (
+      solverStop - solverStart).count ());
+
+  AddPlacement (trafficId, placement);
+  m_decisions++;
+  m_solverNs += solverTime.GetNanoSeconds ();
+
+  NS_LOG_INFO ("Traffic " << trafficId << " placed in " <<
+               solverTime.As (Time::US));
+  m_placementTrace (trafficId, placement.serverList, solverTime);
+  return placement.serverList;
+}
+
+void
+PlacementEngine::Commit (uint16_t trafficId, uint32_t srcHostId,
+                         uint32_t dstHostId, std::vector<uint8_t> vnfList,
+                         DataRate rate, std::vector<uint32_t> serverList)
+{
+  NS_LOG_FUNCTION (this << trafficId << srcHostId << dstHostId << rate);
+
+  Placement placement;
+  placement.request.srcHostId = srcHostId;
+  placement.request.dstHostId = dstHostId;
+  placement.request.vnfList = vnfList;
+  placement.request.rate = static_cast<double> (rate.GetBitRate ());
+  placement.serverList = serverList;
+  AddPlacement (trafficId, placement);
+}
+
+void
+PlacementEngine::Update (uint16_t trafficId, std::vector<uint32_t> serverList)
+{
+  NS_LOG_FUNCTION (this << trafficId);
+
+  // The traffic may have already been released.
+  auto it = m_placements.find (trafficId);
+  if (it == m_placements.end ())
+    {
+      return;
+    }
+  NS_ABORT_MSG_IF (serverList.size () != it->second.serverList.size (),
+                   "Invalid placement for traffic " << trafficId);
+
+  ApplyLoad (it->second, -1);
+  it->second.serverList = serverList;
+  ApplyLoad (it->second, 1);
+}
+
+void
+PlacementEngine::Release (uint16_t trafficId)
+{
+  NS_LOG_FUNCTION (this << trafficId);
+
+  auto it = m_placements.find (trafficId);
+  if (it != m_placements.end ())
+    {
+      ApplyLoad (it->second, -1);
+      m_placements.erase (it);
+    }
+}
+
+double
+PlacementEngine::GetNetworkLinkUsage (uint32_t srcNodeId, uint32_t dstNodeId) const
+{
+  NS_LOG_FUNCTION (this << srcNodeId << dstNodeId);
+
+  double capacity = GetNetworkLinkCapacity (srcNodeId, dstNodeId);
+  return capacity ? GetNetworkLinkLoad (srcNodeId, dstNodeId) / capacity : 0;
+}
+
+double
+PlacementEngine::GetVnfLinkUsage (uint32_t serverId, uint8_t vnfId) const
+{
+  NS_LOG_FUNCTION (this << serverId << (uint16_t)vnfId);
+
+  double capacity = GetVnfLinkCapacity (serverId, vnfId);
+  return capacity ? GetVnfLinkLoad (serverId, vnfId) / capacity : 0;
+}
+
+double
+PlacementEngine::GetServerUsage (uint32_t serverId) const
+{
+  NS_LOG_FUNCTION (this << serverId);
+
+  double capacity = GetServerCapacity (serverId);
+  return capacity ? GetServerLoad (serverId) / capacity : 0;
+}
+
+uint64_t
+PlacementEngine::GetDecisions (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  return m_decisions;
+}
+
+Time
+PlacementEngine::GetAverageSolverTime (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  return m_decisions ? NanoSeconds (m_solverNs / m_decisions) : Time (0);
+}
+
+void
+PlacementEngine::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+
+  m_placements.clear ();
+  Object::DoDispose ();
+}
+
+double
+PlacementEngine::GetNetworkLinkLoad (uint32_t srcNodeId, uint32_t dstNodeId) const
+{
+  return m_netLoad.at (srcNodeId * m_numNodes + dstNodeId);
+}
+
+double
+PlacementEngine::GetNetworkLinkCapacity (uint32_t srcNodeId, uint32_t dstNodeId) const
+{
+  return m_netCapacity.at (srcNodeId * m_numNodes + dstNodeId);
+}
+
+double
+PlacementEngine::GetVnfLinkLoad (uint32_t serverId, uint8_t vnfId) const
+{
+  return m_vnfLoad.at (serverId * m_numVnfs + vnfId);
+}
+
+double
+PlacementEngine::GetVnfLinkCapacity (uint32_t serverId, uint8_t vnfId) const
+{
+  return m_vnfCapacity.at (serverId * m_numVnfs + vnfId);
+}
+
+double
+PlacementEngine::GetServerLoad (uint32_t serverId) const
+{
+  return m_srvLoad.at (serverId);
+}
+
+double
+PlacementEngine::GetServerCapacity (uint32_t serverId) const
+{
+  return m_srvCapacity.at (serverId);
+}
+
+void
+PlacementEngine::AddPlacement (uint16_t trafficId, const Placement &placement)
+{
+  NS_LOG_FUNCTION (this << trafficId);
+
+  NS_ABORT_MSG_IF (m_placements.find (trafficId) != m_placements.end (),
+                   "Existing placement for traffic " << trafficId);
+  NS_ABORT_MSG_IF (placement.request.srcHostId >= m_numNodes
+                   || placement.request.dstHostId >= m_numNodes,
+                   "Invalid host node ID.");
+  NS_ABORT_MSG_IF (placement.serverList.size () != placement.request.vnfList.size (),
+                   "Invalid placement for traffic " << trafficId);
+  for (auto serverId : placement.serverList)
+    {
+      NS_ABORT_MSG_IF (serverId >= m_numNodes, "Invalid server ID.");
+    }
+
+  ApplyLoad (placement, 1);
+  m_placements.insert (std::make_pair (trafficId, placement));
+}
+
+void
+PlacementEngine::ApplyLoad (const Placement &placement, double sign)
+{
+  NS_LOG_FUNCTION (this << sign);
+
+  const Request &request = placement.request;
+  double rate = sign * request.rate;
+  uint32_t nodeId = request.srcHostId;
+  for (size_t k = 0; k < request.vnfList.size (); k++)
+    {
+      uint8_t vnfId = request.vnfList.at (k);
+      uint32_t serverId = placement.serverList.at (k);
+      if (nodeId != serverId)
+        {
+          m_netLoad.at (nodeId * m_numNodes + serverId) += rate;
+          nodeId = serverId;
+        }
+
+      Ptr<VnfInfo> vnfInfo = VnfInfo::GetPointer (vnfId);
+      m_vnfLoad.at (serverId * m_numVnfs + vnfId) += rate * vnfInfo->GetCsf ();
+      m_srvLoad.at (serverId) += rate * vnfInfo->GetCsf ();
+      rate *= vnfInfo->GetNsf ();
+    }
+  if (nodeId != request.dstHostId)
+    {
+      m_netLoad.at (nodeId * m_numNodes + request.dstHostId) += rate;
+    }
+}
+
+// -------------------------------------------------------------------------- //
+CorePlacement::CorePlacement ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+CorePlacement::~CorePlacement ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+CorePlacement::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CorePlacement")
+    .SetParent<PlacementEngine> ()
+    .AddConstructor<CorePlacement> ()
+  ;
+  return tid;
+}
+
+std::vector<uint32_t>
+CorePlacement::DoPlace (const Request &request)
+{
+  NS_LOG_FUNCTION (this);
+
+  return std::vector<uint32_t> (request.vnfList.size (), 0);
+}
+
+// -------------------------------------------------------------------------- //
+GreedyPlacement::GreedyPlacement ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+GreedyPlacement::~GreedyPlacement ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+GreedyPlacement::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::GreedyPlacement")
+    .SetParent<PlacementEngine> ()
+    .AddConstructor<GreedyPlacement> ()
+    .AddAttribute ("HopCost",
+                   "The fixed cost for each network hop.",
+                   DoubleValue (0.001),
+                   MakeDoubleAccessor (&GreedyPlacement::m_hopCost),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("MaxUsage",
+                   "The usage ratio above which a resource is overloaded.",
+                   DoubleValue (0.95),
+                   MakeDoubleAccessor (&GreedyPlacement::m_maxUsage),
+                   MakeDoubleChecker<double> (0, 0.999))
+  ;
+  return tid;
+}
+
+std::vector<uint32_t>
+GreedyPlacement::DoPlace (const Request &request)
+{
+  NS_LOG_FUNCTION (this);
+
+  // The input rate of each VNF only depends on the previous VNFs in the chain,
+  // not on their placement, so it can be computed in advance.
+  size_t numStages = request.vnfList.size ();
+  std::vector<double> inRate (numStages + 1);
+  inRate[0] = request.rate;
+  for (size_t k = 0; k < numStages; k++)
+    {
+      inRate[k + 1] = inRate[k] * VnfInfo::GetPointer (request.vnfList[k])->GetNsf ();
+    }
+
+  // Lambda function for the cost of moving traffic between network nodes.
+  auto netCost = [this] (uint32_t srcNodeId, uint32_t dstNodeId, double rate)
+    {
+      if (srcNodeId == dstNodeId)
+        {
+          return 0.0;
+        }
+      return m_hopCost + GetCost (GetNetworkLinkLoad (srcNodeId, dstNodeId),
+                                  GetNetworkLinkCapacity (srcNodeId, dstNodeId),
+                                  rate);
+    };
+
+  // Dynamic programming: cost[k][p] is the minimum cost to deliver the traffic
+  // to the VNF k on server p, and from[k][p] is the server of VNF k-1 on this
+  // minimum cost placement.
+  std::vector<std::vector<double>> cost (
+    numStages, std::vector<double> (m_numNodes));
+  std::vector<std::vector<uint32_t>> from (
+    numStages, std::vector<uint32_t> (m_numNodes));
+  for (size_t k = 0; k < numStages; k++)
+    {
+      uint8_t vnfId = request.vnfList[k];
+      double vnfRate = inRate[k] * VnfInfo::GetPointer (vnfId)->GetCsf ();
+      for (uint32_t p = 0; p < m_numNodes; p++)
+        {
+          double vnfCost =
+            GetCost (GetVnfLinkLoad (p, vnfId), GetVnfLinkCapacity (p, vnfId), vnfRate) +
+            GetCost (GetServerLoad (p), GetServerCapacity (p), vnfRate);
+          if (k == 0)
+            {
+              from[k][p] = request.srcHostId;
+              cost[k][p] = vnfCost + netCost (request.srcHostId, p, inRate[k]);
+              continue;
+            }
+
+          cost[k][p] = std::numeric_limits<double>::max ();
+          for (uint32_t q = 0; q < m_numNodes; q++)
+            {
+              double total = cost[k - 1][q] + netCost (q, p, inRate[k]) + vnfCost;
+              if (total < cost[k][p])
+                {
+                  cost[k][p] = total;
+                  from[k][p] = q;
+                }
+            }
+        }
+    }
+
+  // Select the best server for the last VNF, including the path to the
+  // destination, and walk back the chain.
+  uint32_t best = 0;
+  double bestCost = std::numeric_limits<double>::max ();
+  for (uint32_t p = 0; p < m_numNodes; p++)
+    {
+      double total = cost[numStages - 1][p] +
+        netCost (p, request.dstHostId, inRate[numStages]);
+      if (total < bestCost)
+        {
+          bestCost = total;
+          best = p;
+        }
+    }
+
+  std::vector<uint32_t> serverList (numStages);
+  for (size_t k = numStages; k > 0; k--)
+    {
+      serverList[k - 1] = best;
+      best = from[k - 1][best];
+    }
+  NS_LOG_DEBUG ("Best placement cost " << bestCost);
+  return serverList;
+}
+
+double
+GreedyPlacement::GetCost (double load, double capacity, double delta) const
+{
+  if (delta <= 0)
+    {
+      return 0;
+    }
+  if (capacity <= 0)
+    {
+      // Unavailable resource.
+      return std::numeric_limits<double>::max () / 4;
+    }
+
+  // The function u/(1-u) grows without bound as the usage ratio u approaches
+  // 1, so we extend it linearly (with a steep slope) from the maximum usage.
+  auto usageCost = [this] (double usage)
+    {
+      if (usage <= m_maxUsage)
+        {
+          return usage / (1 - usage);
+        }
+      double maxCost = m_maxUsage / (1 - m_maxUsage);
+      double slope = 1 / ((1 - m_maxUsage) * (1 - m_maxUsage));
+      return maxCost + (usage - m_maxUsage) * slope * 1000;
+    };
+  return usageCost ((load + delta) / capacity) - usageCost (load / capacity);
+}
+
+} // namespace ns3
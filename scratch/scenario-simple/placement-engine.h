@@ -0,0 +1,282 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PLACEMENT_ENGINE_H
+#define PLACEMENT_ENGINE_H
+
+#include <ns3/core-module.h>
+#include <ns3/network-module.h>
+
+namespace ns3 {
+
+/**
+ * Base class for VNF placement engines. The engine keeps the estimated load
+ * on the network-to-network links and on the network-to-VNF uplinks (the
+ * server load is the sum of its VNF uplink loads). For each new traffic, the
+ * subclass selects the server for each VNF in the chain, and the engine
+ * commits the load of this placement until the traffic is released.
+ *
+ * The load of a traffic follows the VNF scaling factors: the uplink to the
+ * server carries the input rate multiplied by the CSF, and the traffic
+ * leaving the server is the input rate multiplied by the NSF.
+ */
+class PlacementEngine : public Object
+{
+public:
+  PlacementEngine ();           //!< Default constructor.
+  virtual ~PlacementEngine ();  //!< Dummy destructor, see DoDispose.
+
+  /**
+   * Register this type.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * Set the network dimensions, clearing any load state.
+   * \param numNodes The number of network nodes (and servers).
+   * \param numVnfs The number of VNFs.
+   */
+  void SetTopology (uint32_t numNodes, uint32_t numVnfs);
+
+  /**
+   * Set the capacity of the link between two network nodes (one direction).
+   * \param srcNodeId The source network node ID.
+   * \param dstNodeId The destination network node ID.
+   * \param capacity The link capacity.
+   */
+  void SetNetworkLinkCapacity (uint32_t srcNodeId, uint32_t dstNodeId,
+                               DataRate capacity);
+
+  /**
+   * Set the capacity of the uplink from the network node to a VNF server.
+   * \param serverId The server ID.
+   * \param vnfId The VNF ID.
+   * \param capacity The link capacity.
+   */
+  void SetVnfLinkCapacity (uint32_t serverId, uint8_t vnfId, DataRate capacity);
+
+  /**
+   * Select the server for each VNF in the chain of a new traffic and commit
+   * the estimated load of this placement.
+   * \param trafficId The traffic ID.
+   * \param srcHostId The source host node ID.
+   * \param dstHostId The destination host node ID.
+   * \param vnfList The list of VNF IDs for this traffic (may be empty).
+   * \param rate The estimated source data rate.
+   * \return The server ID for each VNF in the chain.
+   */
+  std::vector<uint32_t> Place (uint16_t trafficId, uint32_t srcHostId,
+                               uint32_t dstHostId, std::vector<uint8_t> vnfList,
+                               DataRate rate);
+
+  /**
+   * Commit the load of a placement selected elsewhere (i.e. by the engine of
+   * another controller shard), without any decision of this engine.
+   * \param trafficId The traffic ID.
+   * \param srcHostId The source host node ID.
+   * \param dstHostId The destination host node ID.
+   * \param vnfList The list of VNF IDs for this traffic (may be empty).
+   * \param rate The estimated source data rate.
+   * \param serverList The server ID for each VNF in the chain.
+   */
+  void Commit (uint16_t trafficId, uint32_t srcHostId, uint32_t dstHostId,
+               std::vector<uint8_t> vnfList, DataRate rate,
+               std::vector<uint32_t> serverList);
+
+  /**
+   * Change the placement of an existing traffic (i.e. after a VNF migration).
+   * Released traffics are ignored.
+   * \param trafficId The traffic ID.
+   * \param serverList The new server ID for each VNF in the chain.
+   */
+  void Update (uint16_t trafficId, std::vector<uint32_t> serverList);
+
+  /**
+   * Remove the load of a traffic from the network.
+   * \param trafficId The traffic ID.
+   */
+  void Release (uint16_t trafficId);
+
+  /**
+   * \name Load state accessors.
+   * \return The usage ratio (may exceed 1 when overloaded).
+   */
+  //\{
+  double GetNetworkLinkUsage (uint32_t srcNodeId, uint32_t dstNodeId) const;
+  double GetVnfLinkUsage (uint32_t serverId, uint8_t vnfId) const;
+  double GetServerUsage (uint32_t serverId) const;
+  //\}
+
+  /**
+   * Get the number of placement decisions so far.
+   * \return The number of decisions.
+   */
+  uint64_t GetDecisions (void) const;
+
+  /**
+   * Get the average wall-clock time spent by the solver per decision.
+   * \return The average solver time.
+   */
+  Time GetAverageSolverTime (void) const;
+
+  /**
+   * TracedCallback signature for placement decisions.
+   * \param trafficId The traffic ID.
+   * \param serverList The server ID for each VNF in the chain.
+   * \param solverTime The wall-clock time spent by the solver.
+   */
+  typedef void (*PlacementTracedCallback)(
+    uint16_t trafficId, const std::vector<uint32_t> &serverList,
+    Time solverTime);
+
+protected:
+  /** Destructor implementation. */
+  virtual void DoDispose ();
+
+  /** A placement request for a new traffic. */
+  struct Request
+  {
+    uint32_t              srcHostId;  //!< Source host node ID.
+    uint32_t              dstHostId;  //!< Destination host node ID.
+    std::vector<uint8_t>  vnfList;    //!< VNF IDs for this traffic.
+    double                rate;       //!< Estimated source rate (bps).
+  };
+
+  /**
+   * Select the server for each VNF in the chain. The load state must not be
+   * changed here, as the engine commits the load after this call.
+   * \param request The placement request.
+   * \return The server ID for each VNF in the chain.
+   */
+  virtual std::vector<uint32_t> DoPlace (const Request &request) = 0;
+
+  /**
+   * \name Raw load state for subclasses.
+   * \return The load or capacity in bps.
+   */
+  //\{
+  double GetNetworkLinkLoad (uint32_t srcNodeId, uint32_t dstNodeId) const;
+  double GetNetworkLinkCapacity (uint32_t srcNodeId, uint32_t dstNodeId) const;
+  double GetVnfLinkLoad (uint32_t serverId, uint8_t vnfId) const;
+  double GetVnfLinkCapacity (uint32_t serverId, uint8_t vnfId) const;
+  double GetServerLoad (uint32_t serverId) const;
+  double GetServerCapacity (uint32_t serverId) const;
+  //\}
+
+  uint32_t              m_numNodes;     //!< Number of network nodes.
+  uint32_t              m_numVnfs;      //!< Number of VNFs.
+
+private:
+  /** Metadata associated to a placed traffic. */
+  struct Placement
+  {
+    Request               request;    //!< The placement request.
+    std::vector<uint32_t> serverList; //!< Server ID for each VNF.
+  };
+
+  /**
+   * Check a placement and add its load to the load state.
+   * \param trafficId The traffic ID.
+   * \param placement The traffic placement.
+   */
+  void AddPlacement (uint16_t trafficId, const Placement &placement);
+
+  /**
+   * Add (or remove) the load of a placement to the load state.
+   * \param placement The traffic placement.
+   * \param sign +1 to add the load, -1 to remove it.
+   */
+  void ApplyLoad (const Placement &placement, double sign);
+
+  /** Trace source fired for each placement decision. */
+  TracedCallback<uint16_t, const std::vector<uint32_t>&, Time> m_placementTrace;
+
+  /** Map saving traffic ID / placement metadata. */
+  typedef std::map<uint16_t, Placement> PlacementMap_t;
+  PlacementMap_t        m_placements;   //!< Placed traffics.
+
+  std::vector<double>   m_netCapacity;  //!< Network link capacities (bps).
+  std::vector<double>   m_netLoad;      //!< Network link loads (bps).
+  std::vector<double>   m_vnfCapacity;  //!< VNF uplink capacities (bps).
+  std::vector<double>   m_vnfLoad;      //!< VNF uplink loads (bps).
+  std::vector<double>   m_srvCapacity;  //!< Server capacities (bps).
+  std::vector<double>   m_srvLoad;      //!< Server loads (bps).
+  uint64_t              m_decisions;    //!< Number of decisions.
+  int64_t               m_solverNs;     //!< Total solver time (ns).
+};
+
+/**
+ * Placement engine activating all VNFs on the server of node 0 (core).
+ */
+class CorePlacement : public PlacementEngine
+{
+public:
+  CorePlacement ();           //!< Default constructor.
+  virtual ~CorePlacement ();  //!< Dummy destructor.
+
+  /**
+   * Register this type.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+protected:
+  // Inherited from PlacementEngine.
+  std::vector<uint32_t> DoPlace (const Request &request);
+};
+
+/**
+ * Incremental load-aware placement engine. Each new traffic is placed over the
+ * current load state without moving the existing ones. The chain placement
+ * with minimum cost is found by dynamic programming over the VNFs in the
+ * chain (one stage per VNF, one state per server), in O(K.N^2) for K VNFs and
+ * N servers. The cost of each resource is the increase of the M/M/1-like
+ * function u/(1-u) of its usage ratio u, so loaded resources are avoided, plus
+ * a fixed cost for each network hop.
+ */
+class GreedyPlacement : public PlacementEngine
+{
+public:
+  GreedyPlacement ();           //!< Default constructor.
+  virtual ~GreedyPlacement ();  //!< Dummy destructor.
+
+  /**
+   * Register this type.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+protected:
+  // Inherited from PlacementEngine.
+  std::vector<uint32_t> DoPlace (const Request &request);
+
+private:
+  /**
+   * Get the cost of adding some load to a resource.
+   * \param load The current resource load.
+   * \param capacity The resource capacity.
+   * \param delta The additional load.
+   * \return The cost.
+   */
+  double GetCost (double load, double capacity, double delta) const;
+
+  double    m_hopCost;        //!< Fixed cost for each network hop.
+  double    m_maxUsage;       //!< Usage ratio considered as overload.
+};
+
+} // namespace ns3
+#endif // PLACEMENT_ENGINE_H
@@ -16,6 +16,8 @@
 
 #include <ns3/network-module.h>
 #include <ns3/internet-module.h>
+#include <ns3/hash.h>
+#include "placement-engine.h"
 #include "sdn-controller.h"
 #include "sdn-network.h"
 #include "vnf-info.h"
@@ -31,10 +33,40 @@ SdnController::IpMacMap_t SdnController::m_arpTable;
 // OpenFlow flow-mod flags.
 #define FLAGS_OVERLAP_RESET ((OFPFF_CHECK_OVERLAP | OFPFF_RESET_COUNTS))
 
-SdnController::SdnController (Ptr<SdnNetwork> sdnNetwork)
-  : m_network (sdnNetwork)
+SdnController::SdnController (Ptr<SdnNetwork> sdnNetwork, uint16_t shardId)
+  : m_network (sdnNetwork),
+    m_drainTime (Time (0)),
+    m_placement (0),
+    m_activeTraffics (0),
+    m_statsRound (0),
+    m_packetInDpId (0),
+    m_packetInQueued (0),
+    m_packetOutUsed (0),
+    m_packetInCount (0),
+    m_packetInDelaySum (0),
+    m_shardId (shardId),
+    m_crossShardRequests (0),
+    m_nextCookie (1)
 {
   NS_LOG_FUNCTION (this);
+
+  // The statistics requests never change, so they are built only once.
+  struct ofl_match *match = (struct ofl_match*)xmalloc (sizeof (struct ofl_match));
+  ofl_structs_match_init (match);
+  m_flowStatsRequest.header.header.type = OFPT_MULTIPART_REQUEST;
+  m_flowStatsRequest.header.type = OFPMP_FLOW;
+  m_flowStatsRequest.header.flags = 0;
+  m_flowStatsRequest.table_id = OFPTT_ALL;
+  m_flowStatsRequest.out_port = OFPP_ANY;
+  m_flowStatsRequest.out_group = OFPG_ANY;
+  m_flowStatsRequest.cookie = 0;
+  m_flowStatsRequest.cookie_mask = 0;
+  m_flowStatsRequest.match = (struct ofl_match_header*)match;
+
+  m_portStatsRequest.header.header.type = OFPT_MULTIPART_REQUEST;
+  m_portStatsRequest.header.type = OFPMP_PORT_STATS;
+  m_portStatsRequest.header.flags = 0;
+  m_portStatsRequest.port_no = OFPP_ANY;
 }
 
 SdnController::~SdnController ()
@@ -47,6 +79,108 @@ SdnController::GetTypeId (void)
 {
   static TypeId tid = TypeId ("ns3::SdnController")
     .SetParent<OFSwitch13Controller> ()
+    .AddAttribute ("MigrationDrainTime",
+                   "The time to wait for in-flight packets before removing "
+                   "the rules from the source server in VNF migrations.",
+                   TimeValue (MilliSeconds (50)),
+                   MakeTimeAccessor (&SdnController::m_drainTime),
+                   MakeTimeChecker (Time (0)))
+    .AddAttribute ("PlacementEngine",
+                   "The VNF placement engine type.",
+                   TypeId::ATTR_GET | TypeId::ATTR_CONSTRUCT,
+                   TypeIdValue (GreedyPlacement::GetTypeId ()),
+                   MakeTypeIdAccessor (&SdnController::m_placementType),
+                   MakeTypeIdChecker ())
+    .AddAttribute ("ServiceFlowRate",
+                   "The estimated data rate of packet-level flows, used "
+                   "as the flow load by the placement engine.",
+                   DataRateValue (DataRate ("1Mbps")),
+                   MakeDataRateAccessor (&SdnController::m_flowRate),
+                   MakeDataRateChecker ())
+    .AddAttribute ("AggregateRoutes",
+                   "Forward the traffic addressed to hosts with one rule per "
+                   "destination host in each switch, installed with the "
+                   "topology, instead of one exact-match rule per traffic. "
+                   "Exact-match rules are kept for the traffic steered "
+                   "through VNFs.",
+                   TypeId::ATTR_GET | TypeId::ATTR_CONSTRUCT,
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&SdnController::m_aggregateRoutes),
+                   MakeBooleanChecker ())
+    .AddAttribute ("StatsPollInterval",
+                   "The interval between polls of the flow and port "
+                   "statistics of the switches (zero disables the poller).",
+                   TimeValue (Time (0)),
+                   MakeTimeAccessor (&SdnController::m_statsInterval),
+                   MakeTimeChecker (Time (0)))
+    .AddAttribute ("PacketInRate",
+                   "The number of packet-in messages the controller "
+                   "processes per second (zero processes each message "
+                   "immediately when it arrives).",
+                   DoubleValue (0),
+                   MakeDoubleAccessor (&SdnController::m_packetInRate),
+                   MakeDoubleChecker<double> (0))
+    .AddAttribute ("PacketInBatchSize",
+                   "The maximum number of packet-in messages from the same "
+                   "switch processed together.",
+                   UintegerValue (16),
+                   MakeUintegerAccessor (&SdnController::m_packetInBatchSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("PacketInQueueSize",
+                   "The maximum number of packet-in messages waiting for "
+                   "the controller. Further messages are dropped.",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&SdnController::m_packetInQueueSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("FlowTableCapacity",
+                   "The number of per-traffic rules each flow table of a "
+                   "switch can hold, besides the rules installed with the "
+                   "topology (zero for unlimited tables). Installing a rule "
+                   "in a full table evicts another one.",
+                   TypeId::ATTR_GET | TypeId::ATTR_CONSTRUCT,
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&SdnController::m_tableCapacity),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("EvictionPolicy",
+                   "The policy choosing the rule to evict from a full table.",
+                   EnumValue (SdnController::LRU),
+                   MakeEnumAccessor (&SdnController::m_evictionPolicy),
+                   MakeEnumChecker (SdnController::LRU, "LRU",
+                                    SdnController::IMPORTANCE, "Importance"))
+    .AddAttribute ("ShardSyncDelay",
+                   "The time for a request to reach the controller of "
+                   "another shard, when installing rules or confirming "
+                   "migrations on switches owned by that shard.",
+                   TimeValue (MilliSeconds (5)),
+                   MakeTimeAccessor (&SdnController::m_shardDelay),
+                   MakeTimeChecker (Time (0)))
+    .AddTraceSource ("VnfMigration", "VNF migration trace source.",
+                     MakeTraceSourceAccessor (&SdnController::m_migrationTrace),
+                     "ns3::SdnController::MigrationTracedCallback")
+    .AddTraceSource ("FlowStats", "Flow statistics of a switch updated.",
+                     MakeTraceSourceAccessor (&SdnController::m_flowStatsTrace),
+                     "ns3::SdnController::StatsTracedCallback")
+    .AddTraceSource ("PortStats", "Port statistics of a switch updated.",
+                     MakeTraceSourceAccessor (&SdnController::m_portStatsTrace),
+                     "ns3::SdnController::StatsTracedCallback")
+    .AddTraceSource ("RuleCount", "Rule count of a switch at each poll.",
+                     MakeTraceSourceAccessor (&SdnController::m_ruleCountTrace),
+                     "ns3::SdnController::RuleCountTracedCallback")
+    .AddTraceSource ("PacketIn", "Packet-in message processed.",
+                     MakeTraceSourceAccessor (&SdnController::m_packetInTrace),
+                     "ns3::SdnController::PacketInTracedCallback")
+    .AddTraceSource ("PacketInDrop", "Packet-in message dropped.",
+                     MakeTraceSourceAccessor (&SdnController::m_packetInDropTrace),
+                     "ns3::SdnController::PacketInDropTracedCallback")
+    .AddTraceSource ("TableFull", "Rule installed in a full flow table.",
+                     MakeTraceSourceAccessor (&SdnController::m_tableFullTrace),
+                     "ns3::SdnController::TableFullTracedCallback")
+    .AddTraceSource ("EvictionMiss", "Packet missing an evicted rule.",
+                     MakeTraceSourceAccessor (&SdnController::m_evictionMissTrace),
+                     "ns3::SdnController::EvictionMissTracedCallback")
+    .AddTraceSource ("CrossShard", "Message sent to another shard.",
+                     MakeTraceSourceAccessor (&SdnController::m_crossShardTrace),
+                     "ns3::SdnController::CrossShardTracedCallback")
   ;
   return tid;
 }
@@ -62,6 +196,8 @@ SdnController::NotifyHostAttach (
   Ipv4Address hostIpAddress = Ipv4AddressHelper::GetAddress (hostDevice);
   Mac48Address hostMacAddress = Mac48Address::ConvertFrom (hostDevice->GetAddress ());
   SaveArpEntry (hostIpAddress, hostMacAddress);
+  m_network->m_registry->SetArpEntry (m_shardId, hostIpAddress, hostMacAddress);
+  m_hostAddresses.insert (hostIpAddress);
 
   // Foward IP packets addressed to this host to the right output port.
   std::ostringstream cmd;
@@ -88,6 +224,10 @@ SdnController::NotifyVnfAttach (
   // Thus, to de/activate the VNF in a server, it is enough to install a flow
   // rule in table 0 sending the packet addressed to the VNF to the table 1.
 
+  // Share the VNF address with the other shards for ARP resolution.
+  m_network->m_registry->SetArpEntry (
+    m_shardId, vnfInfo->GetIpAddr (), vnfInfo->GetMacAddr ());
+
   // Packets addressed to the VNF entering the table 1 on network switch:
   // -> send to the logical port connected to the 1st app
   {
@@ -137,6 +277,75 @@ SdnController::NotifyVnfAttach (
   }
 }
 
+void
+SdnController::NotifyTopologyBuilt (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // Create the placement engine and load the capacities of network links
+  // (one for each direction) and VNF uplinks. Each shard has its own engine,
+  // kept consistent with the other ones through the shared registry.
+  uint32_t numNodes = m_network->m_numNodes;
+  uint32_t numVnfs = m_network->m_numVnfs;
+  ObjectFactory factory;
+  factory.SetTypeId (m_placementType);
+  m_placement = factory.Create<PlacementEngine> ();
+  m_placement->SetTopology (numNodes, numVnfs);
+  for (uint32_t i = 0; i < numNodes; i++)
+    {
+      for (uint32_t j = 0; j < numNodes; j++)
+        {
+          if (i != j)
+            {
+              m_placement->SetNetworkLinkCapacity (
+                i, j, m_network->m_networkToNetworkChannels[i][j]->GetDataRate ());
+            }
+        }
+      for (uint32_t v = 0; v < numVnfs; v++)
+        {
+          m_placement->SetVnfLinkCapacity (
+            i, v, m_network->m_networkToVnfUlinkChannels[i][v]->GetDataRate ());
+        }
+    }
+  m_network->m_registry->SetPlacementEngine (m_shardId, m_placement);
+  m_network->m_registry->SetArpEntryCallback (
+    m_shardId, MakeCallback (&SdnController::NotifyArpEntry, this));
+
+  // With aggregated routes, each switch forwards the traffic addressed to the
+  // hosts of the other switches with a single rule per host. Hosts share the
+  // 10.0.0.0/8 network, so the destination prefixes are host addresses.
+  if (m_aggregateRoutes)
+    {
+      for (uint32_t i = 0; i < numNodes; i++)
+        {
+          if (!OwnsDatapath (m_network->GetNetworkSwitchDpId (i)))
+            {
+              continue;
+            }
+          for (uint32_t j = 0; j < numNodes; j++)
+            {
+              if (i != j)
+                {
+                  std::ostringstream cmd;
+                  cmd << "flow-mod cmd=add,prio=64,table=0"
+                      << ",flags="        << FLAGS_OVERLAP_RESET
+                      << " eth_type="     << Ipv4L3Protocol::PROT_NUMBER
+                      << ",ip_dst="       << m_network->m_hostIfaces.GetAddress (j)
+                      << " apply:output=" << m_network->GetNetworkPortNo (i, j);
+                  DpctlExecute (m_network->GetNetworkSwitchDpId (i), cmd.str ());
+                }
+            }
+        }
+    }
+
+  // The ARP table is complete now: resolve all addresses at the hosts
+  // without ARP requests through packet-in messages.
+  if (m_shardId == 0)
+    {
+      PreloadArpCaches (m_network->m_hostNodes);
+    }
+}
+
 void
 SdnController::NotifyNewServiceTraffic (
   InetSocketAddress srcAddress, InetSocketAddress dstAddress,
@@ -146,17 +355,40 @@ SdnController::NotifyNewServiceTraffic (
   NS_LOG_FUNCTION (this << srcAddress << dstAddress << srcHostId <<
                    dstHostId << startTime << stopTime);
 
+  // Place the VNFs and save the traffic metadata for further VNF migrations.
+  uint16_t trafficId = srcAddress.GetPort ();
+  std::vector<uint32_t> serverList = m_network->m_registry->Place (
+    m_shardId, trafficId, srcHostId, dstHostId, vnfList, m_flowRate);
+  ServiceTraffic traffic = {srcAddress, dstAddress, srcHostId, dstHostId,
+                            vnfList, serverList};
+  auto ret = m_traffics.insert (std::make_pair (trafficId, traffic));
+  NS_ABORT_MSG_IF (ret.second == false, "Existing traffic with this ID.");
+  Simulator::Schedule (stopTime - Simulator::Now (),
+                       &SharedRegistry::ReleasePlacement, m_network->m_registry,
+                       m_shardId, trafficId);
+  Simulator::Schedule (startTime - Simulator::Now (),
+                       &SdnController::CountActiveTraffics, this, 1);
+  Simulator::Schedule (stopTime - Simulator::Now (),
+                       &SdnController::CountActiveTraffics, this, -1);
 
-  // FIXME: Just for testing....
-  // Activate all VNFs in the core for this traffic
-  for (auto vnfId : vnfList)
+  // Activate each VNF on its server and forward the traffic along the chain.
+  uint32_t nodeId = srcHostId;
+  for (size_t k = 0; k < vnfList.size (); k++)
     {
-      SetUpVnf (vnfId, 0, srcAddress);
+      SetUpVnf (vnfList.at (k), serverList.at (k), srcAddress);
+      if (nodeId != serverList.at (k))
+        {
+          RouteTraffic (srcAddress, VnfInfo::GetPointer (vnfList.at (k))->GetInetAddr (),
+                        nodeId, serverList.at (k));
+          nodeId = serverList.at (k);
+        }
     }
-  // Forward input traffic to the core switch.
-  RouteTraffic (srcAddress, VnfInfo::GetPointer (vnfList.front ())->GetInetAddr (), srcHostId, 0);
+
   // Forward output traffic to the edge switch.
-  RouteTraffic (srcAddress, dstAddress, 0, dstHostId);
+  if (nodeId != dstHostId)
+    {
+      RouteTraffic (srcAddress, dstAddress, nodeId, dstHostId);
+    }
 }
 
 void
@@ -168,11 +400,84 @@ SdnController::NotifyNewBackgroundTraffic (
   NS_LOG_FUNCTION (this << srcAddress << dstAddress << srcHostId <<
                    dstHostId << startTime << stopTime);
 
+  // Account the estimated load of this traffic in the placement engine.
+  uint16_t trafficId = srcAddress.GetPort ();
+  m_network->m_registry->Place (m_shardId, trafficId, srcHostId, dstHostId,
+                                std::vector<uint8_t> (), m_flowRate);
+  Simulator::Schedule (stopTime - Simulator::Now (),
+                       &SharedRegistry::ReleasePlacement, m_network->m_registry,
+                       m_shardId, trafficId);
+  Simulator::Schedule (startTime - Simulator::Now (),
+                       &SdnController::CountActiveTraffics, this, 1);
+  Simulator::Schedule (stopTime - Simulator::Now (),
+                       &SdnController::CountActiveTraffics, this, -1);
+
+  // With aggregated routes, the background traffic needs no rule of its own.
+  if (m_aggregateRoutes)
+    {
+      return;
+    }
+
   // FIXME Just for testing...
   Simulator::Schedule (startTime - Seconds (1), &SdnController::RouteTraffic,
                        this, srcAddress, dstAddress, srcHostId, dstHostId);
 }
 
+void
+SdnController::NotifyNewFluidTraffic (
+  uint16_t trafficId, uint32_t srcHostId, uint32_t dstHostId,
+  std::vector<uint8_t> vnfList, DataRate rate,
+  Time startTime, Time stopTime)
+{
+  NS_LOG_FUNCTION (this << trafficId << srcHostId << dstHostId << rate <<
+                   startTime << stopTime);
+
+  // Fluid flows don't need any flow rule, but we must describe the path with
+  // the rate multiplier for each link, following the scaling factors of the
+  // VNFs already traversed. The 1st app scales the traffic on the uplink to the
+  // server by the CSF, and the traffic leaving the server is scaled by the NSF.
+  std::vector<uint32_t> serverList = m_network->m_registry->Place (
+    m_shardId, trafficId, srcHostId, dstHostId, vnfList, rate);
+  Simulator::Schedule (stopTime - Simulator::Now (),
+                       &SharedRegistry::ReleasePlacement, m_network->m_registry,
+                       m_shardId, trafficId);
+
+  FluidModel::Path_t path;
+  double scale = 1;
+  uint32_t nodeId = srcHostId;
+  for (size_t k = 0; k < vnfList.size (); k++)
+    {
+      uint32_t serverId = serverList.at (k);
+      if (nodeId != serverId)
+        {
+          path.push_back (std::make_pair (
+                            m_network->m_networkToNetworkFluidLinks[nodeId][serverId], scale));
+          nodeId = serverId;
+        }
+      Ptr<VnfInfo> vnfInfo = VnfInfo::GetPointer (vnfList.at (k));
+      path.push_back (std::make_pair (
+                        m_network->m_networkToVnfFluidLinks[serverId][vnfList.at (k)],
+                        scale * vnfInfo->GetCsf ()));
+      scale *= vnfInfo->GetNsf ();
+    }
+  if (nodeId != dstHostId)
+    {
+      path.push_back (std::make_pair (
+                        m_network->m_networkToNetworkFluidLinks[nodeId][dstHostId], scale));
+    }
+
+  m_network->GetFluidModel ()->AddFlow (
+    trafficId, rate, path, scale, startTime, stopTime);
+}
+
+Ptr<PlacementEngine>
+SdnController::GetPlacementEngine (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  return m_placement;
+}
+
 void
 SdnController::SetUpVnf (
   uint8_t vnfId, uint32_t serverId, InetSocketAddress srcAddress)
@@ -180,15 +485,14 @@ SdnController::SetUpVnf (
   NS_LOG_FUNCTION (this << (uint16_t)vnfId << serverId << srcAddress);
 
   // Sends the packets addressed to the VNF to the pipeline table 1.
-  std::ostringstream cmd;
-  cmd << "flow-mod cmd=add,prio=1024,idle=30,table=0"
-      << " eth_type="     << Ipv4L3Protocol::PROT_NUMBER
-      << ",ip_proto="     << (uint16_t)UdpL4Protocol::PROT_NUMBER
-      << ",ip_dst="       << VnfInfo::GetPointer (vnfId)->GetIpAddr ()
-      << ",ip_src="       << srcAddress.GetIpv4 ()
-      << ",udp_src="      << srcAddress.GetPort ()
-      << " goto:1";
-  DpctlExecute (m_network->GetNetworkSwitchDpId (serverId), cmd.str ());
+  std::ostringstream match;
+  match << "eth_type="    << Ipv4L3Protocol::PROT_NUMBER
+        << ",ip_proto="   << (uint16_t)UdpL4Protocol::PROT_NUMBER
+        << ",ip_dst="     << VnfInfo::GetPointer (vnfId)->GetIpAddr ()
+        << ",ip_src="     << srcAddress.GetIpv4 ()
+        << ",udp_src="    << srcAddress.GetPort ();
+  InstallRule (m_network->GetNetworkSwitchDpId (serverId), 0, 1024, 30,
+               match.str (), "goto:1", srcAddress.GetPort ());
 }
 
 void
@@ -197,208 +501,1462 @@ SdnController::MoveVnf (
 {
   NS_LOG_FUNCTION (this << (uint16_t)vnfId << srcServerId << dstServerId << srcAddress);
 
-  // Set up the VNF on the destination server.
-  SetUpVnf (vnfId, dstServerId, srcAddress);
+  MoveVnf (vnfId, srcServerId, dstServerId, std::vector<InetSocketAddress> (1, srcAddress));
+}
 
-  // Remove the rule that was sending the packets addressed to the VNF
-  // to the pipeline table 1 from the source server.
-  std::ostringstream cmd;
-  cmd << "flow-mod cmd=del,prio=1024,table=0"
-      << " eth_type="     << Ipv4L3Protocol::PROT_NUMBER
-      << ",ip_proto="     << (uint16_t)UdpL4Protocol::PROT_NUMBER
-      << ",ip_dst="       << VnfInfo::GetPointer (vnfId)->GetIpAddr ()
-      << ",ip_src="       << srcAddress.GetIpv4 ()
-      << ",udp_src="      << srcAddress.GetPort ();
-  DpctlExecute (m_network->GetNetworkSwitchDpId (srcServerId), cmd.str ());
+void
+SdnController::MoveVnf (
+  uint8_t vnfId, uint32_t srcServerId, uint32_t dstServerId,
+  std::vector<InetSocketAddress> srcAddresses)
+{
+  NS_LOG_FUNCTION (this << (uint16_t)vnfId << srcServerId << dstServerId);
+
+  static uint32_t migrationCounter = 0;
+
+  Migration migration;
+  migration.vnfId = vnfId;
+  migration.srcServerId = srcServerId;
+  migration.dstServerId = dstServerId;
+  migration.phase = INSTALL;
+  migration.pendingBarriers = 0;
+  migration.startTime = Simulator::Now ();
+
+  for (auto const &srcAddress : srcAddresses)
+    {
+      uint16_t trafficId = srcAddress.GetPort ();
+      auto it = m_traffics.find (trafficId);
+      NS_ABORT_MSG_IF (it == m_traffics.end (), "Unknown traffic " << srcAddress);
+      size_t vnfIdx = GetVnfIndex (trafficId, vnfId);
+      if (it->second.serverList.at (vnfIdx) != srcServerId)
+        {
+          NS_LOG_WARN ("VNF " << (uint16_t)vnfId << " for traffic " << trafficId <<
+                       " is not active on server " << srcServerId);
+          continue;
+        }
+      if (m_accounts.find (std::make_pair (vnfId, trafficId)) != m_accounts.end ())
+        {
+          NS_LOG_WARN ("VNF " << (uint16_t)vnfId << " for traffic " << trafficId <<
+                       " is already being migrated.");
+          continue;
+        }
+      migration.trafficIds.push_back (trafficId);
+    }
+
+  if (migration.trafficIds.empty () || srcServerId == dstServerId)
+    {
+      NS_LOG_INFO ("No traffic to migrate.");
+      return;
+    }
+
+  uint32_t migrationId = ++migrationCounter;
+  m_migrations.insert (std::make_pair (migrationId, migration));
+  MigrationInstall (migrationId);
 }
 
 void
-SdnController::RouteTraffic (
-  InetSocketAddress srcAddress, InetSocketAddress dstAddress,
-  uint32_t srcNodeId, uint32_t dstNodeId)
+SdnController::MoveVnf (uint8_t vnfId, uint32_t srcServerId, uint32_t dstServerId)
 {
-  NS_LOG_FUNCTION (this << srcAddress << dstAddress << srcNodeId << dstNodeId);
+  NS_LOG_FUNCTION (this << (uint16_t)vnfId << srcServerId << dstServerId);
 
-  std::ostringstream cmd;
-  cmd << "flow-mod cmd=add,prio=128,idle=30,table=0"
-      << " eth_type="     << Ipv4L3Protocol::PROT_NUMBER
-      << ",ip_proto="     << (uint16_t)UdpL4Protocol::PROT_NUMBER
-      << ",ip_src="       << srcAddress.GetIpv4 ()
-      << ",ip_dst="       << dstAddress.GetIpv4 ()
-      << ",udp_src="      << srcAddress.GetPort ()
-      << ",udp_dst="      << dstAddress.GetPort ()
-      << " apply:output=" << m_network->GetNetworkPortNo (srcNodeId, dstNodeId);
-  DpctlExecute (m_network->GetNetworkSwitchDpId (srcNodeId), cmd.str ());
+  std::vector<InetSocketAddress> srcAddresses;
+  for (auto const &it : m_traffics)
+    {
+      const ServiceTraffic &traffic = it.second;
+      for (size_t i = 0; i < traffic.vnfList.size (); i++)
+        {
+          if (traffic.vnfList.at (i) == vnfId && traffic.serverList.at (i) == srcServerId)
+            {
+              srcAddresses.push_back (traffic.srcAddress);
+              break;
+            }
+        }
+    }
+  MoveVnf (vnfId, srcServerId, dstServerId, srcAddresses);
 }
 
 void
-SdnController::DoDispose ()
+SdnController::NotifyVnfRx (
+  uint8_t vnfId, uint32_t vnfCopy, uint16_t trafficId, uint32_t seqNum)
 {
-  NS_LOG_FUNCTION (this);
+  auto it = m_accounts.find (std::make_pair (vnfId, trafficId));
+  if (it == m_accounts.end ())
+    {
+      return;
+    }
 
-  m_network = 0;
-  OFSwitch13Controller::DoDispose ();
+  // The packets of a traffic are numbered sequentially at each hop, the same
+  // way at all copies of the upstream VNF, so any packet arriving after a
+  // higher sequence number (at any VNF copy) is reordered.
+  MigrationAccount &account = it->second;
+  if (!account.seqNums.empty () && seqNum < account.maxSeqNum)
+    {
+      account.reorderedPkts++;
+    }
+  account.seqNums.insert (seqNum);
+  account.maxSeqNum = std::max (account.maxSeqNum, seqNum);
+
+  // Track the switchover: the last packet at the source copy and the first
+  // one at the destination copy.
+  if (vnfCopy == account.srcServerId)
+    {
+      account.srcLastSeqNum = account.srcRx ?
+        std::max (account.srcLastSeqNum, seqNum) : seqNum;
+      account.srcRx = true;
+    }
+  else if (vnfCopy == account.dstServerId)
+    {
+      account.dstFirstSeqNum = account.dstRx ?
+        std::min (account.dstFirstSeqNum, seqNum) : seqNum;
+      account.dstRx = true;
+    }
 }
 
-ofl_err
-SdnController::HandlePacketIn (
-  struct ofl_msg_packet_in *msg, Ptr<const RemoteSwitch> swtch, uint32_t xid)
+uint32_t
+SdnController::GetMigrationLostPkts (uint16_t trafficId) const
 {
-  NS_LOG_FUNCTION (this << swtch << xid);
+  NS_LOG_FUNCTION (this << trafficId);
+
+  auto it = m_migrationCounters.find (trafficId);
+  return it != m_migrationCounters.end () ? it->second.first : 0;
+}
 
-  char *msgStr = ofl_structs_match_to_string ((struct ofl_match_header*)msg->match, 0);
-  NS_LOG_DEBUG ("Packet in match: " << msgStr);
-  free (msgStr);
+uint32_t
+SdnController::GetMigrationReorderedPkts (uint16_t trafficId) const
+{
+  NS_LOG_FUNCTION (this << trafficId);
 
-  if (msg->reason == OFPR_ACTION)
+  auto it = m_migrationCounters.find (trafficId);
+  return it != m_migrationCounters.end () ? it->second.second : 0;
+}
+
+DataRate
+SdnController::GetPortRxRate (uint64_t dpId, uint32_t portNo) const
+{
+  NS_LOG_FUNCTION (this << dpId << portNo);
+
+  auto it = m_stats.find (dpId);
+  if (it != m_stats.end ())
     {
-      // Get Ethernet frame type
-      uint16_t ethType;
-      struct ofl_match_tlv *tlv;
-      tlv = oxm_match_lookup (OXM_OF_ETH_TYPE, (struct ofl_match*)msg->match);
-      memcpy (&ethType, tlv->value, OXM_LENGTH (OXM_OF_ETH_TYPE));
+      auto port = it->second.ports.find (portNo);
+      if (port != it->second.ports.end ())
+        {
+          return DataRate (static_cast<uint64_t> (port->second.rx.byteRate * 8));
+        }
+    }
+  return DataRate (0);
+}
 
-      if (ethType == ArpL3Protocol::PROT_NUMBER)
+DataRate
+SdnController::GetPortTxRate (uint64_t dpId, uint32_t portNo) const
+{
+  NS_LOG_FUNCTION (this << dpId << portNo);
+
+  auto it = m_stats.find (dpId);
+  if (it != m_stats.end ())
+    {
+      auto port = it->second.ports.find (portNo);
+      if (port != it->second.ports.end ())
         {
-          return HandleArpPacketIn (msg, swtch, xid);
+          return DataRate (static_cast<uint64_t> (port->second.tx.byteRate * 8));
         }
     }
+  return DataRate (0);
+}
 
-  // All handlers must free the message when everything is ok
-  ofl_msg_free ((struct ofl_msg_header*)msg, 0);
-  return 0;
+DataRate
+SdnController::GetTrafficRate (uint64_t dpId, uint16_t trafficId) const
+{
+  NS_LOG_FUNCTION (this << dpId << trafficId);
+
+  auto it = m_stats.find (dpId);
+  if (it != m_stats.end ())
+    {
+      auto traffic = it->second.trafficRates.find (trafficId);
+      if (traffic != it->second.trafficRates.end ())
+        {
+          return DataRate (static_cast<uint64_t> (traffic->second * 8));
+        }
+    }
+  return DataRate (0);
 }
 
-void
-SdnController::HandshakeSuccessful (Ptr<const RemoteSwitch> swtch)
+uint32_t
+SdnController::GetRuleCount (uint64_t dpId) const
 {
-  NS_LOG_FUNCTION (this << swtch);
+  NS_LOG_FUNCTION (this << dpId);
 
-  // Get the switch datapath ID
-  uint64_t swDpId = swtch->GetDpId ();
+  auto it = m_stats.find (dpId);
+  return it != m_stats.end () ? it->second.flows.size () : 0;
+}
 
-  // For packet-in messages, send only the first 128 bytes to the controller
-  DpctlExecute (swDpId, "set-config miss=128");
+uint32_t
+SdnController::GetActiveTrafficCount (void) const
+{
+  NS_LOG_FUNCTION (this);
 
-  // Send ARP requests to the controller
-  DpctlExecute (swDpId, "flow-mod cmd=add,table=0,prio=20 "
-                "eth_type=0x0806,arp_op=1 apply:output=ctrl");
+  return m_activeTraffics;
 }
 
-ofl_err
-SdnController::HandleArpPacketIn (
-  struct ofl_msg_packet_in *msg, Ptr<const RemoteSwitch> swtch, uint32_t xid)
+uint32_t
+SdnController::GetEvictionCount (uint64_t dpId) const
 {
-  NS_LOG_FUNCTION (this << swtch << xid);
+  NS_LOG_FUNCTION (this << dpId);
 
-  struct ofl_match_tlv *tlv;
+  auto it = m_rules.find (dpId);
+  return it != m_rules.end () ? it->second.evictions : 0;
+}
 
-  // Get ARP operation
-  uint16_t arpOp;
-  tlv = oxm_match_lookup (OXM_OF_ARP_OP, (struct ofl_match*)msg->match);
-  memcpy (&arpOp, tlv->value, OXM_LENGTH (OXM_OF_ARP_OP));
+uint32_t
+SdnController::GetEvictionMissCount (uint64_t dpId) const
+{
+  NS_LOG_FUNCTION (this << dpId);
 
-  // Get input port
-  uint32_t inPort;
-  tlv = oxm_match_lookup (OXM_OF_IN_PORT, (struct ofl_match*)msg->match);
-  memcpy (&inPort, tlv->value, OXM_LENGTH (OXM_OF_IN_PORT));
+  auto it = m_rules.find (dpId);
+  return it != m_rules.end () ? it->second.misses : 0;
+}
 
-  // Get source and target IP address
-  Ipv4Address srcIp, dstIp;
-  srcIp = ExtractIpv4Address (OXM_OF_ARP_SPA, (struct ofl_match*)msg->match);
-  dstIp = ExtractIpv4Address (OXM_OF_ARP_TPA, (struct ofl_match*)msg->match);
+uint32_t
+SdnController::GetPacketInQueueLength (void) const
+{
+  NS_LOG_FUNCTION (this);
 
-  // Get Source MAC address
-  Mac48Address srcMac, dstMac;
-  tlv = oxm_match_lookup (OXM_OF_ARP_SHA, (struct ofl_match*)msg->match);
-  srcMac.CopyFrom (tlv->value);
-  tlv = oxm_match_lookup (OXM_OF_ARP_THA, (struct ofl_match*)msg->match);
-  dstMac.CopyFrom (tlv->value);
+  return m_packetInQueued + m_packetInBatch.size ();
+}
 
-  // Check for ARP request
-  if (arpOp == ArpHeader::ARP_TYPE_REQUEST)
-    {
-      uint8_t replyData[64];
+uint16_t
+SdnController::GetShardId (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  return m_shardId;
+}
+
+bool
+SdnController::OwnsDatapath (uint64_t dpId) const
+{
+  NS_LOG_FUNCTION (this << dpId);
+
+  return m_network->GetShardId (dpId) == m_shardId;
+}
+
+Time
+SdnController::GetAveragePacketInDelay (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  return m_packetInCount ? Seconds (m_packetInDelaySum / m_packetInCount) : Time (0);
+}
 
-      // Check for existing IP information
-      Mac48Address replyMac = GetArpEntry (dstIp);
-      Ptr<Packet> pkt = CreateArpReply (replyMac, dstIp, srcMac, srcIp);
-      NS_ASSERT_MSG (pkt->GetSize () == 64, "Invalid packet size.");
-      pkt->CopyData (replyData, 64);
+uint32_t
+SdnController::GetCrossShardRequests (void) const
+{
+  NS_LOG_FUNCTION (this);
 
-      // Send the ARP replay back to the input port
-      struct ofl_action_output *action =
-        (struct ofl_action_output*)xmalloc (sizeof (struct ofl_action_output));
-      action->header.type = OFPAT_OUTPUT;
-      action->port = OFPP_IN_PORT;
-      action->max_len = 0;
+  return m_crossShardRequests;
+}
 
-      // Send the ARP reply within an OpenFlow PacketOut message
-      struct ofl_msg_packet_out reply;
-      reply.header.type = OFPT_PACKET_OUT;
-      reply.buffer_id = OFP_NO_BUFFER;
-      reply.in_port = inPort;
-      reply.data_length = 64;
-      reply.data = &replyData[0];
-      reply.actions_num = 1;
-      reply.actions = (struct ofl_action_header**)&action;
+void
+SdnController::RouteTraffic (
+  InetSocketAddress srcAddress, InetSocketAddress dstAddress,
+  uint32_t srcNodeId, uint32_t dstNodeId)
+{
+  NS_LOG_FUNCTION (this << srcAddress << dstAddress << srcNodeId << dstNodeId);
 
-      SendToSwitch (swtch, (struct ofl_msg_header*)&reply, xid);
-      free (action);
+  // With aggregated routes, the rules installed with the topology already
+  // forward the traffic addressed to hosts. Only the traffic addressed to
+  // VNFs, which have a copy on every server, is routed per traffic.
+  if (m_aggregateRoutes && m_hostAddresses.count (dstAddress.GetIpv4 ()))
+    {
+      return;
     }
 
-  // All handlers must free the message when everything is ok
-  ofl_msg_free ((struct ofl_msg_header*)msg, 0);
-  return 0;
+  std::ostringstream match, instructions;
+  match << "eth_type="    << Ipv4L3Protocol::PROT_NUMBER
+        << ",ip_proto="   << (uint16_t)UdpL4Protocol::PROT_NUMBER
+        << ",ip_src="     << srcAddress.GetIpv4 ()
+        << ",ip_dst="     << dstAddress.GetIpv4 ()
+        << ",udp_src="    << srcAddress.GetPort ()
+        << ",udp_dst="    << dstAddress.GetPort ();
+  instructions << "apply:output=" << m_network->GetNetworkPortNo (srcNodeId, dstNodeId);
+  InstallRule (m_network->GetNetworkSwitchDpId (srcNodeId), 0, 128, 30,
+               match.str (), instructions.str (), srcAddress.GetPort ());
 }
 
-Ipv4Address
-SdnController::ExtractIpv4Address (uint32_t oxm_of, struct ofl_match* match)
+void
+SdnController::DoDispose ()
 {
-  switch (oxm_of)
+  NS_LOG_FUNCTION (this);
+
+  m_network = 0;
+  m_statsEvent.Cancel ();
+  m_stats.clear ();
+  m_packetInEvent.Cancel ();
+  for (auto &pending : m_packetInBatch)
     {
-      case OXM_OF_ARP_SPA:
-      case OXM_OF_ARP_TPA:
-      case OXM_OF_IPV4_DST:
-      case OXM_OF_IPV4_SRC:
+      ofl_msg_free ((struct ofl_msg_header*)pending.msg, 0);
+    }
+  m_packetInBatch.clear ();
+  for (auto &it : m_packetInQueues)
+    {
+      for (auto &pending : it.second)
         {
-          uint32_t ip;
-          int size = OXM_LENGTH (oxm_of);
-          struct ofl_match_tlv *tlv = oxm_match_lookup (oxm_of, match);
-          memcpy (&ip, tlv->value, size);
-          return Ipv4Address (ntohl (ip));
+          ofl_msg_free ((struct ofl_msg_header*)pending.msg, 0);
         }
-      default:
-        NS_ABORT_MSG ("Invalid IP field.");
     }
+  m_packetInQueues.clear ();
+  m_packetInQueued = 0;
+  m_packetOutPool.clear ();
+  m_rules.clear ();
+  m_ruleCookies.clear ();
+  if (m_flowStatsRequest.match)
+    {
+      ofl_structs_free_match (m_flowStatsRequest.match, 0);
+      m_flowStatsRequest.match = 0;
+    }
+  if (m_placement)
+    {
+      m_placement->Dispose ();
+    }
+  m_placement = 0;
+  m_pendingArpRequests.clear ();
+  m_relayedBarriers.clear ();
+  OFSwitch13Controller::DoDispose ();
 }
 
-Ptr<Packet>
-SdnController::CreateArpReply (Mac48Address srcMac, Ipv4Address srcIp,
-                               Mac48Address dstMac, Ipv4Address dstIp)
+ofl_err
+SdnController::HandleBarrierReply (
+  struct ofl_msg_header *msg, Ptr<const RemoteSwitch> swtch, uint32_t xid)
 {
-  NS_LOG_FUNCTION (this << srcMac << srcIp << dstMac << dstIp);
-
-  Ptr<Packet> packet = Create<Packet> ();
-
-  // ARP header
-  ArpHeader arp;
-  arp.SetReply (srcMac, srcIp, dstMac, dstIp);
-  packet->AddHeader (arp);
+  NS_LOG_FUNCTION (this << swtch << xid);
 
-  // Ethernet header
-  EthernetHeader eth (false);
-  eth.SetSource (srcMac);
-  eth.SetDestination (dstMac);
-  if (packet->GetSize () < 46)
+  auto it = m_barrierXids.find (xid);
+  if (it != m_barrierXids.end ())
     {
-      uint8_t buffer[46];
-      memset (buffer, 0, 46);
-      Ptr<Packet> padd = Create<Packet> (buffer, 46 - packet->GetSize ());
-      packet->AddAtEnd (padd);
+      uint32_t migrationId = it->second;
+      m_barrierXids.erase (it);
+      CompleteBarrier (migrationId);
     }
-  eth.SetLengthType (ArpL3Protocol::PROT_NUMBER);
-  packet->AddHeader (eth);
+
+  // Barriers confirmed for the migrations of other shards go back to them.
+  auto relayIt = m_relayedBarriers.find (xid);
+  if (relayIt != m_relayedBarriers.end ())
+    {
+      Ptr<SdnController> requester = relayIt->second.first;
+      m_crossShardRequests++;
+      m_crossShardTrace (m_shardId, requester->GetShardId ());
+      Simulator::Schedule (m_shardDelay, &SdnController::CompleteBarrier,
+                           requester, relayIt->second.second);
+      m_relayedBarriers.erase (relayIt);
+    }
+
+  // All handlers must free the message when everything is ok
+  ofl_msg_free (msg, 0);
+  return 0;
+}
+
+ofl_err
+SdnController::HandleFlowRemoved (
+  struct ofl_msg_flow_removed *msg, Ptr<const RemoteSwitch> swtch,
+  uint32_t xid)
+{
+  NS_LOG_FUNCTION (this << swtch << xid);
+
+  // Forget the per-traffic rules expired in the switch. The rules deleted by
+  // the controller were already handled when deleted.
+  auto it = m_ruleCookies.find (msg->stats->cookie);
+  if (it != m_ruleCookies.end () && msg->reason != OFPRR_DELETE)
+    {
+      DatapathRules &dpRules = m_rules.at (it->second.first);
+      auto ruleIt = dpRules.rules.find (it->second.second);
+      if (!ruleIt->second.evicted)
+        {
+          dpRules.tableRules [ruleIt->second.tableId]--;
+        }
+      dpRules.rules.erase (ruleIt);
+      m_ruleCookies.erase (it);
+    }
+
+  // All handlers must free the message when everything is ok
+  ofl_msg_free_flow_removed (msg, true, 0);
+  return 0;
+}
+
+ofl_err
+SdnController::HandleMultipartReply (
+  struct ofl_msg_multipart_reply_header *msg, Ptr<const RemoteSwitch> swtch,
+  uint32_t xid)
+{
+  NS_LOG_FUNCTION (this << swtch << xid);
+
+  uint64_t dpId = swtch->GetDpId ();
+  auto it = m_stats.find (dpId);
+  if (it != m_stats.end ())
+    {
+      switch (msg->type)
+        {
+          case OFPMP_FLOW:
+            HandleFlowStats (it->second, (struct ofl_msg_multipart_reply_flow*)msg, dpId);
+            break;
+          case OFPMP_PORT_STATS:
+            HandlePortStats (it->second, (struct ofl_msg_multipart_reply_port*)msg, dpId);
+            break;
+          default:
+            break;
+        }
+    }
+
+  // All handlers must free the message when everything is ok
+  ofl_msg_free ((struct ofl_msg_header*)msg, 0);
+  return 0;
+}
+
+ofl_err
+SdnController::HandlePacketIn (
+  struct ofl_msg_packet_in *msg, Ptr<const RemoteSwitch> swtch, uint32_t xid)
+{
+  NS_LOG_FUNCTION (this << swtch << xid);
+
+  // Without a processing rate, the controller is infinitely fast.
+  if (m_packetInRate == 0)
+    {
+      m_packetInCount++;
+      m_packetInTrace (swtch->GetDpId (), Time (0));
+      ProcessPacketIn (msg, swtch->GetDpId (), xid);
+      SendPacketOuts (swtch);
+      return 0;
+    }
+
+  // Otherwise the message waits in the queue of its switch. Under flash
+  // crowds the queues fill up and further messages are dropped.
+  uint64_t dpId = swtch->GetDpId ();
+  if (m_packetInQueued >= m_packetInQueueSize)
+    {
+      NS_LOG_WARN ("Packet-in queue full. Dropping message from " << dpId);
+      m_packetInDropTrace (dpId);
+      ofl_msg_free ((struct ofl_msg_header*)msg, 0);
+      return 0;
+    }
+
+  PendingPacketIn pending;
+  pending.msg = msg;
+  pending.xid = xid;
+  pending.arrival = Simulator::Now ();
+  m_packetInQueues[dpId].push_back (pending);
+  m_packetInQueued++;
+
+  if (!m_packetInEvent.IsRunning ())
+    {
+      StartPacketInBatch ();
+    }
+
+  // The message is freed once it is processed.
+  return 0;
+}
+
+void
+SdnController::HandshakeSuccessful (Ptr<const RemoteSwitch> swtch)
+{
+  NS_LOG_FUNCTION (this << swtch);
+
+  // Get the switch datapath ID
+  uint64_t swDpId = swtch->GetDpId ();
+
+  // With several shards, each switch is managed by the master controller of
+  // its shard only. The other controllers remain connected as slaves, so
+  // they get no asynchronous messages and cannot modify the switch.
+  if (m_network->m_numControllers > 1)
+    {
+      bool owner = OwnsDatapath (swDpId);
+      struct ofl_msg_role_request msg;
+      msg.header.type = OFPT_ROLE_REQUEST;
+      msg.role = owner ? OFPCR_ROLE_MASTER : OFPCR_ROLE_SLAVE;
+      msg.generation_id = 0;
+      SendToSwitch (swtch, (struct ofl_msg_header*)&msg, GetNextXid ());
+      if (!owner)
+        {
+          return;
+        }
+    }
+
+  // For packet-in messages, send only the first 128 bytes to the controller
+  DpctlExecute (swDpId, "set-config miss=128");
+
+  // Send ARP requests to the controller
+  DpctlExecute (swDpId, "flow-mod cmd=add,table=0,prio=20 "
+                "eth_type=0x0806,arp_op=1 apply:output=ctrl");
+
+  // With limited flow tables, send the packets missing the tables to the
+  // controller, to account for the misses caused by evicted rules.
+  if (m_tableCapacity)
+    {
+      DpctlExecute (swDpId, "flow-mod cmd=add,table=0,prio=0 apply:output=ctrl");
+    }
+
+  // Poll the statistics of this switch along with the other ones.
+  m_stats.insert (std::make_pair (swDpId, DatapathStats ()));
+  if (!m_statsInterval.IsZero () && !m_statsEvent.IsRunning ())
+    {
+      m_statsEvent = Simulator::Schedule (m_statsInterval, &SdnController::PollStats, this);
+    }
+}
+
+void
+SdnController::CountActiveTraffics (int32_t delta)
+{
+  NS_LOG_FUNCTION (this << delta);
+
+  m_activeTraffics += delta;
+}
+
+void
+SdnController::PollStats (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // A single flow and port statistics request for each switch, covering all
+  // its tables and ports, so the number of requests and poll events does not
+  // depend on the number of rules.
+  m_statsRound++;
+  for (auto const &it : m_stats)
+    {
+      Ptr<const RemoteSwitch> swtch = GetRemoteSwitch (it.first);
+      SendToSwitch (swtch, (struct ofl_msg_header*)&m_flowStatsRequest, GetNextXid ());
+      SendToSwitch (swtch, (struct ofl_msg_header*)&m_portStatsRequest, GetNextXid ());
+    }
+  m_statsEvent = Simulator::Schedule (m_statsInterval, &SdnController::PollStats, this);
+}
+
+void
+SdnController::UpdateStats (StatsEntry &entry, uint64_t bytes, Time duration)
+{
+  if (entry.round != 0 && duration > entry.duration && bytes >= entry.bytes)
+    {
+      entry.byteRate = (bytes - entry.bytes) / (duration - entry.duration).GetSeconds ();
+    }
+  else if (duration.IsStrictlyPositive ())
+    {
+      // New entry, or counters reset by a flow-mod with OFPFF_RESET_COUNTS.
+      entry.byteRate = bytes / duration.GetSeconds ();
+    }
+  entry.bytes = bytes;
+  entry.duration = duration;
+  entry.round = m_statsRound;
+}
+
+void
+SdnController::HandleFlowStats (
+  DatapathStats &stats, struct ofl_msg_multipart_reply_flow *msg, uint64_t dpId)
+{
+  NS_LOG_FUNCTION (this << dpId << msg->stats_num);
+
+  for (size_t i = 0; i < msg->stats_num; i++)
+    {
+      struct ofl_flow_stats *flow = msg->stats[i];
+      struct ofl_match *match = (struct ofl_match*)flow->match;
+
+      // A rule is identified by its table, priority, cookie and match fields.
+      // The hash of the fields does not depend on their order in the match.
+      uint8_t buffer[sizeof (uint32_t) + 256];
+      memcpy (buffer, &flow->cookie, sizeof flow->cookie);
+      memcpy (buffer + 8, &flow->priority, sizeof flow->priority);
+      buffer[10] = flow->table_id;
+      uint64_t key = Hash64 ((const char*)buffer, 11);
+      struct ofl_match_tlv *tlv;
+      HMAP_FOR_EACH (tlv, struct ofl_match_tlv, hmap_node, &match->match_fields)
+        {
+          size_t length = OXM_LENGTH (tlv->header);
+          memcpy (buffer, &tlv->header, sizeof (uint32_t));
+          memcpy (buffer + sizeof (uint32_t), tlv->value, length);
+          key ^= Hash64 ((const char*)buffer, sizeof (uint32_t) + length);
+        }
+
+      auto ret = stats.flows.insert (std::make_pair (key, StatsEntry ()));
+      StatsEntry &entry = ret.first->second;
+      if (ret.second)
+        {
+          // The traffic rules match the traffic ID as UDP source port.
+          tlv = oxm_match_lookup (OXM_OF_UDP_SRC, match);
+          if (tlv)
+            {
+              memcpy (&entry.trafficId, tlv->value, OXM_LENGTH (OXM_OF_UDP_SRC));
+            }
+        }
+
+      // Count the rules and the packets matched since the last poll in each
+      // table, for the pipeline latency model.
+      if (stats.tableEntries.size () <= flow->table_id)
+        {
+          stats.tableEntries.resize (flow->table_id + 1, 0);
+          stats.tablePackets.resize (flow->table_id + 1, 0);
+        }
+      stats.tableEntries [flow->table_id]++;
+      if (entry.round != 0 && flow->packet_count >= entry.packets)
+        {
+          stats.tablePackets [flow->table_id] += flow->packet_count - entry.packets;
+        }
+      else
+        {
+          stats.tablePackets [flow->table_id] += flow->packet_count;
+        }
+      entry.packets = flow->packet_count;
+
+      // Per-traffic rules matching packets since the last poll were used.
+      auto cookieIt = m_ruleCookies.find (flow->cookie);
+      if (cookieIt != m_ruleCookies.end ())
+        {
+          FlowRule &rule = m_rules.at (dpId).rules.at (cookieIt->second.second);
+          if (flow->packet_count != rule.packets)
+            {
+              rule.packets = flow->packet_count;
+              rule.lastUsed = Simulator::Now ();
+            }
+        }
+
+      UpdateStats (entry, flow->byte_count,
+                   Seconds (flow->duration_sec) + NanoSeconds (flow->duration_nsec));
+    }
+
+  if (msg->header.flags & OFPMPF_REPLY_MORE)
+    {
+      return;
+    }
+
+  // The reply is complete: forget the rules removed from the switch, and
+  // take the rate of each traffic from its busiest rule, as the rules
+  // chained by goto instructions see the same packets.
+  stats.trafficRates.clear ();
+  for (auto it = stats.flows.begin (); it != stats.flows.end (); )
+    {
+      if (it->second.round != m_statsRound)
+        {
+          it = stats.flows.erase (it);
+          continue;
+        }
+      if (it->second.trafficId != 0)
+        {
+          double &rate = stats.trafficRates [it->second.trafficId];
+          rate = std::max (rate, it->second.byteRate);
+        }
+      ++it;
+    }
+  m_flowStatsTrace (dpId);
+
+  Ptr<PipelineModel> pipeline = m_network->GetPipelineModel (dpId);
+  if (pipeline)
+    {
+      pipeline->Update (stats.tableEntries, stats.tablePackets);
+    }
+  stats.tableEntries.clear ();
+  stats.tablePackets.clear ();
+
+  // The rule count is what the pipeline lookup cost grows with.
+  NS_LOG_INFO ("Switch " << dpId << " has " << stats.flows.size () <<
+               " rules for " << m_activeTraffics << " active traffics");
+  m_ruleCountTrace (dpId, stats.flows.size (), m_activeTraffics);
+}
+
+void
+SdnController::HandlePortStats (
+  DatapathStats &stats, struct ofl_msg_multipart_reply_port *msg, uint64_t dpId)
+{
+  NS_LOG_FUNCTION (this << dpId << msg->stats_num);
+
+  for (size_t i = 0; i < msg->stats_num; i++)
+    {
+      struct ofl_port_stats *port = msg->stats[i];
+      Time duration = Seconds (port->duration_sec) + NanoSeconds (port->duration_nsec);
+      if (duration.IsZero ())
+        {
+          duration = Simulator::Now ();
+        }
+      PortStats &entry = stats.ports [port->port_no];
+      UpdateStats (entry.rx, port->rx_bytes, duration);
+      UpdateStats (entry.tx, port->tx_bytes, duration);
+    }
+
+  if (!(msg->header.flags & OFPMPF_REPLY_MORE))
+    {
+      m_portStatsTrace (dpId);
+    }
+}
+
+void
+SdnController::StartPacketInBatch (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_packetInQueues.empty ())
+    {
+      return;
+    }
+
+  // Serve the switches in round robin, so a single switch under a flash
+  // crowd does not starve the other ones. Empty queues are removed.
+  auto it = m_packetInQueues.upper_bound (m_packetInDpId);
+  if (it == m_packetInQueues.end ())
+    {
+      it = m_packetInQueues.begin ();
+    }
+  m_packetInDpId = it->first;
+
+  std::deque<PendingPacketIn> &queue = it->second;
+  while (!queue.empty () && m_packetInBatch.size () < m_packetInBatchSize)
+    {
+      m_packetInBatch.push_back (queue.front ());
+      queue.pop_front ();
+    }
+  m_packetInQueued -= m_packetInBatch.size ();
+  if (queue.empty ())
+    {
+      m_packetInQueues.erase (it);
+    }
+
+  Time processing = Seconds (m_packetInBatch.size () / m_packetInRate);
+  m_packetInEvent = Simulator::Schedule (
+      processing, &SdnController::FinishPacketInBatch, this);
+}
+
+void
+SdnController::FinishPacketInBatch (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  NS_LOG_DEBUG ("Processing " << m_packetInBatch.size () <<
+                " packet-in messages from " << m_packetInDpId);
+  for (auto &pending : m_packetInBatch)
+    {
+      Time delay = Simulator::Now () - pending.arrival;
+      m_packetInCount++;
+      m_packetInDelaySum += delay.GetSeconds ();
+      m_packetInTrace (m_packetInDpId, delay);
+      ProcessPacketIn (pending.msg, m_packetInDpId, pending.xid);
+    }
+  m_packetInBatch.clear ();
+  SendPacketOuts (GetRemoteSwitch (m_packetInDpId));
+
+  StartPacketInBatch ();
+}
+
+void
+SdnController::ProcessPacketIn (
+  struct ofl_msg_packet_in *msg, uint64_t dpId, uint32_t xid)
+{
+  NS_LOG_FUNCTION (this << dpId << xid);
+
+  if (g_log.IsEnabled (LOG_DEBUG))
+    {
+      char *msgStr = ofl_structs_match_to_string ((struct ofl_match_header*)msg->match, 0);
+      NS_LOG_DEBUG ("Packet in match: " << msgStr);
+      free (msgStr);
+    }
+
+  if (msg->reason == OFPR_ACTION)
+    {
+      // Get Ethernet frame type
+      uint16_t ethType;
+      struct ofl_match_tlv *tlv;
+      tlv = oxm_match_lookup (OXM_OF_ETH_TYPE, (struct ofl_match*)msg->match);
+      memcpy (&ethType, tlv->value, OXM_LENGTH (OXM_OF_ETH_TYPE));
+
+      if (ethType == ArpL3Protocol::PROT_NUMBER)
+        {
+          HandleArpPacketIn (msg, dpId, xid);
+        }
+    }
+  else if (msg->reason == OFPR_NO_MATCH)
+    {
+      HandleMissPacketIn (msg, dpId);
+    }
+
+  ofl_msg_free ((struct ofl_msg_header*)msg, 0);
+}
+
+SdnController::PacketOutBuffer &
+SdnController::AllocPacketOut (uint32_t xid)
+{
+  NS_LOG_FUNCTION (this << xid);
+
+  if (m_packetOutUsed == m_packetOutPool.size ())
+    {
+      m_packetOutPool.push_back (PacketOutBuffer ());
+    }
+  PacketOutBuffer &buffer = m_packetOutPool[m_packetOutUsed++];
+  buffer.xid = xid;
+  buffer.msg.header.type = OFPT_PACKET_OUT;
+  buffer.msg.actions_num = 1;
+  return buffer;
+}
+
+void
+SdnController::SendPacketOuts (Ptr<const RemoteSwitch> swtch)
+{
+  NS_LOG_FUNCTION (this << swtch);
+
+  // The pool may have been reallocated while the buffers were filled, so
+  // each message is pointed to the action and the data of its own buffer
+  // only now. The messages are serialized when sent, so the buffers are
+  // free again afterwards.
+  for (uint32_t i = 0; i < m_packetOutUsed; i++)
+    {
+      PacketOutBuffer &buffer = m_packetOutPool[i];
+      buffer.action = (struct ofl_action_header*)&buffer.output;
+      buffer.msg.actions = &buffer.action;
+      buffer.msg.data = &buffer.data[0];
+      SendToSwitch (swtch, (struct ofl_msg_header*)&buffer.msg, buffer.xid);
+    }
+  m_packetOutUsed = 0;
+}
+
+void
+SdnController::HandleArpPacketIn (
+  struct ofl_msg_packet_in *msg, uint64_t dpId, uint32_t xid)
+{
+  NS_LOG_FUNCTION (this << dpId << xid);
+
+  struct ofl_match_tlv *tlv;
+
+  // Get ARP operation
+  uint16_t arpOp;
+  tlv = oxm_match_lookup (OXM_OF_ARP_OP, (struct ofl_match*)msg->match);
+  memcpy (&arpOp, tlv->value, OXM_LENGTH (OXM_OF_ARP_OP));
+
+  // Get input port
+  uint32_t inPort;
+  tlv = oxm_match_lookup (OXM_OF_IN_PORT, (struct ofl_match*)msg->match);
+  memcpy (&inPort, tlv->value, OXM_LENGTH (OXM_OF_IN_PORT));
+
+  // Get source and target IP address
+  Ipv4Address srcIp, dstIp;
+  srcIp = ExtractIpv4Address (OXM_OF_ARP_SPA, (struct ofl_match*)msg->match);
+  dstIp = ExtractIpv4Address (OXM_OF_ARP_TPA, (struct ofl_match*)msg->match);
+
+  // Get Source MAC address
+  Mac48Address srcMac, dstMac;
+  tlv = oxm_match_lookup (OXM_OF_ARP_SHA, (struct ofl_match*)msg->match);
+  srcMac.CopyFrom (tlv->value);
+  tlv = oxm_match_lookup (OXM_OF_ARP_THA, (struct ofl_match*)msg->match);
+  dstMac.CopyFrom (tlv->value);
+
+  // Check for ARP request
+  if (arpOp == ArpHeader::ARP_TYPE_REQUEST)
+    {
+      // Check for existing IP information in the replica of this shard. An
+      // address registered by another shard may not have arrived yet, so
+      // the request waits for the replica to catch up.
+      Mac48Address replyMac;
+      if (!m_network->m_registry->GetArpEntry (m_shardId, dstIp, replyMac))
+        {
+          if (!m_network->m_registry->HasArpEntry (dstIp))
+            {
+              NS_LOG_WARN ("No ARP entry for " << dstIp);
+              return;
+            }
+          NS_LOG_INFO ("Queueing ARP request for " << dstIp << " in shard " << m_shardId);
+          PendingArpRequest request = {dpId, xid, inPort, srcIp, srcMac};
+          m_pendingArpRequests[dstIp].push_back (request);
+          return;
+        }
+      FillArpReply (AllocPacketOut (xid), inPort, replyMac, dstIp, srcMac, srcIp);
+    }
+}
+
+void
+SdnController::FillArpReply (
+  PacketOutBuffer &reply, uint32_t inPort, Mac48Address srcMac,
+  Ipv4Address srcIp, Mac48Address dstMac, Ipv4Address dstIp)
+{
+  NS_LOG_FUNCTION (this << inPort << srcMac << srcIp << dstMac << dstIp);
+
+  Ptr<Packet> pkt = CreateArpReply (srcMac, srcIp, dstMac, dstIp);
+  NS_ASSERT_MSG (pkt->GetSize () == 64, "Invalid packet size.");
+  pkt->CopyData (reply.data, 64);
+
+  // Send the ARP replay back to the input port
+  reply.output.header.type = OFPAT_OUTPUT;
+  reply.output.port = OFPP_IN_PORT;
+  reply.output.max_len = 0;
+
+  // Send the ARP reply within an OpenFlow PacketOut message
+  reply.msg.buffer_id = OFP_NO_BUFFER;
+  reply.msg.in_port = inPort;
+  reply.msg.data_length = 64;
+}
+
+void
+SdnController::NotifyArpEntry (Ipv4Address ipAddr, Mac48Address macAddr)
+{
+  NS_LOG_FUNCTION (this << ipAddr << macAddr);
+
+  auto it = m_pendingArpRequests.find (ipAddr);
+  if (it == m_pendingArpRequests.end ())
+    {
+      return;
+    }
+
+  // Reply to the requests waiting for this entry, one switch at a time.
+  for (auto const &request : it->second)
+    {
+      FillArpReply (AllocPacketOut (request.xid), request.inPort, macAddr,
+                    ipAddr, request.srcMac, request.srcIp);
+      SendPacketOuts (GetRemoteSwitch (request.dpId));
+    }
+  m_pendingArpRequests.erase (it);
+}
+
+void
+SdnController::TearDownVnf (
+  uint8_t vnfId, uint32_t serverId, InetSocketAddress srcAddress)
+{
+  NS_LOG_FUNCTION (this << (uint16_t)vnfId << serverId << srcAddress);
+
+  // Remove the rule that was sending the packets addressed to the VNF
+  // to the pipeline table 1 from the server.
+  std::ostringstream match;
+  match << "eth_type="    << Ipv4L3Protocol::PROT_NUMBER
+        << ",ip_proto="   << (uint16_t)UdpL4Protocol::PROT_NUMBER
+        << ",ip_dst="     << VnfInfo::GetPointer (vnfId)->GetIpAddr ()
+        << ",ip_src="     << srcAddress.GetIpv4 ()
+        << ",udp_src="    << srcAddress.GetPort ();
+  RemoveRule (m_network->GetNetworkSwitchDpId (serverId), 0, 1024, match.str ());
+}
+
+void
+SdnController::UnrouteTraffic (
+  InetSocketAddress srcAddress, InetSocketAddress dstAddress, uint32_t srcNodeId)
+{
+  NS_LOG_FUNCTION (this << srcAddress << dstAddress << srcNodeId);
+
+  // Traffics addressed to hosts have no rule of their own with aggregated
+  // routes, see RouteTraffic.
+  if (m_aggregateRoutes && m_hostAddresses.count (dstAddress.GetIpv4 ()))
+    {
+      return;
+    }
+
+  std::ostringstream match;
+  match << "eth_type="    << Ipv4L3Protocol::PROT_NUMBER
+        << ",ip_proto="   << (uint16_t)UdpL4Protocol::PROT_NUMBER
+        << ",ip_src="     << srcAddress.GetIpv4 ()
+        << ",ip_dst="     << dstAddress.GetIpv4 ()
+        << ",udp_src="    << srcAddress.GetPort ()
+        << ",udp_dst="    << dstAddress.GetPort ();
+  RemoveRule (m_network->GetNetworkSwitchDpId (srcNodeId), 0, 128, match.str ());
+}
+
+void
+SdnController::InstallRule (
+  uint64_t dpId, uint8_t tableId, uint16_t priority, uint16_t idleTimeout,
+  std::string match, std::string instructions, uint16_t trafficId)
+{
+  NS_LOG_FUNCTION (this << dpId << (uint16_t)tableId << priority << match);
+
+  // Rules for switches of other shards are installed by their controller.
+  if (!OwnsDatapath (dpId))
+    {
+      Simulator::Schedule (m_shardDelay, &SdnController::InstallRule,
+                           GetShardOwner (dpId), dpId, tableId, priority,
+                           idleTimeout, match, instructions, trafficId);
+      return;
+    }
+
+  std::ostringstream cmd;
+  cmd << "flow-mod cmd=add,prio=" << priority << ",idle=" << idleTimeout
+      << ",table=" << (uint16_t)tableId;
+
+  // With unlimited flow tables there is nothing to keep track of.
+  if (m_tableCapacity == 0)
+    {
+      cmd << " " << match << " " << instructions;
+      DpctlExecute (dpId, cmd.str ());
+      return;
+    }
+
+  // A rule not yet in the switch takes a table entry, and a full table
+  // evicts another rule first. Adding a rule already in the switch only
+  // replaces its instructions.
+  std::ostringstream key;
+  key << (uint16_t)tableId << "/" << priority << "/" << match;
+  DatapathRules &dpRules = m_rules [dpId];
+  auto it = dpRules.rules.find (key.str ());
+  if (it == dpRules.rules.end () || it->second.evicted)
+    {
+      if (dpRules.tableRules [tableId] >= m_tableCapacity)
+        {
+          NS_LOG_INFO ("Table " << (uint16_t)tableId << " full on switch " << dpId);
+          m_tableFullTrace (dpId, tableId);
+          EvictRule (dpId, tableId);
+
+          // The eviction may forget this rule too, if it was evicted before
+          // and idle for longer than its timeout.
+          it = dpRules.rules.find (key.str ());
+        }
+      dpRules.tableRules [tableId]++;
+
+      if (it == dpRules.rules.end ())
+        {
+          FlowRule rule;
+          rule.tableId = tableId;
+          rule.priority = priority;
+          rule.idleTimeout = idleTimeout;
+          rule.match = match;
+          rule.trafficId = trafficId;
+          rule.cookie = m_nextCookie++;
+          rule.evictions = 0;
+          it = dpRules.rules.insert (std::make_pair (key.str (), rule)).first;
+          m_ruleCookies [rule.cookie] = std::make_pair (dpId, key.str ());
+        }
+      it->second.evicted = false;
+    }
+
+  // The switch reports the removal of the rule, and resets its counters.
+  FlowRule &rule = it->second;
+  rule.instructions = instructions;
+  rule.packets = 0;
+  rule.lastUsed = Simulator::Now ();
+  cmd << ",cookie=" << rule.cookie
+      << ",flags="  << (OFPFF_SEND_FLOW_REM | OFPFF_RESET_COUNTS)
+      << " " << match << " " << instructions;
+  DpctlExecute (dpId, cmd.str ());
+}
+
+void
+SdnController::RemoveRule (
+  uint64_t dpId, uint8_t tableId, uint16_t priority, std::string match)
+{
+  NS_LOG_FUNCTION (this << dpId << (uint16_t)tableId << priority << match);
+
+  if (!OwnsDatapath (dpId))
+    {
+      Simulator::Schedule (m_shardDelay, &SdnController::RemoveRule,
+                           GetShardOwner (dpId), dpId, tableId, priority, match);
+      return;
+    }
+
+  // We use the strict delete command to avoid removing any (more specific)
+  // rule for this traffic.
+  std::ostringstream cmd;
+  cmd << "flow-mod cmd=dels,prio=" << priority << ",table=" << (uint16_t)tableId
+      << " " << match;
+  DpctlExecute (dpId, cmd.str ());
+
+  auto dpIt = m_rules.find (dpId);
+  if (dpIt == m_rules.end ())
+    {
+      return;
+    }
+  std::ostringstream key;
+  key << (uint16_t)tableId << "/" << priority << "/" << match;
+  auto it = dpIt->second.rules.find (key.str ());
+  if (it != dpIt->second.rules.end ())
+    {
+      if (!it->second.evicted)
+        {
+          dpIt->second.tableRules [tableId]--;
+        }
+      m_ruleCookies.erase (it->second.cookie);
+      dpIt->second.rules.erase (it);
+    }
+}
+
+void
+SdnController::EvictRule (uint64_t dpId, uint8_t tableId)
+{
+  NS_LOG_FUNCTION (this << dpId << (uint16_t)tableId);
+
+  // Look for the rule to evict, and forget the evicted rules whose traffic
+  // was idle for longer than their timeout, as they would have expired.
+  DatapathRules &dpRules = m_rules.at (dpId);
+  auto victim = dpRules.rules.end ();
+  for (auto it = dpRules.rules.begin (); it != dpRules.rules.end (); )
+    {
+      const FlowRule &rule = it->second;
+      if (rule.evicted)
+        {
+          if (Simulator::Now () - rule.lastUsed > Seconds (rule.idleTimeout))
+            {
+              m_ruleCookies.erase (rule.cookie);
+              it = dpRules.rules.erase (it);
+              continue;
+            }
+        }
+      else if (rule.tableId == tableId)
+        {
+          if (victim == dpRules.rules.end ())
+            {
+              victim = it;
+            }
+          else
+            {
+              const FlowRule &best = victim->second;
+              bool byPriority = m_evictionPolicy == IMPORTANCE
+                && rule.priority != best.priority;
+              if (byPriority ? rule.priority < best.priority
+                             : rule.lastUsed < best.lastUsed)
+                {
+                  victim = it;
+                }
+            }
+        }
+      ++it;
+    }
+  NS_ASSERT_MSG (victim != dpRules.rules.end (), "No rule to evict.");
+
+  // The evicted rule is kept, so the packets missing it can be accounted
+  // for and the rule reinstalled.
+  FlowRule &rule = victim->second;
+  NS_LOG_INFO ("Evicting rule " << rule.match << " from switch " << dpId);
+  std::ostringstream cmd;
+  cmd << "flow-mod cmd=dels,prio=" << rule.priority << ",table=" << (uint16_t)tableId
+      << " " << rule.match;
+  DpctlExecute (dpId, cmd.str ());
+  rule.evicted = true;
+  rule.evictions++;
+  dpRules.tableRules [tableId]--;
+  dpRules.evictions++;
+}
+
+void
+SdnController::HandleMissPacketIn (struct ofl_msg_packet_in *msg, uint64_t dpId)
+{
+  NS_LOG_FUNCTION (this << dpId);
+
+  // The traffic rules match the traffic ID as UDP source port.
+  auto dpIt = m_rules.find (dpId);
+  struct ofl_match_tlv *tlv = oxm_match_lookup (OXM_OF_UDP_SRC, (struct ofl_match*)msg->match);
+  if (dpIt == m_rules.end () || !tlv)
+    {
+      return;
+    }
+  uint16_t trafficId;
+  memcpy (&trafficId, tlv->value, OXM_LENGTH (OXM_OF_UDP_SRC));
+
+  // Packets of a traffic with rules evicted from this switch missed the
+  // tables because of the eviction, even when they were already sent to the
+  // controller before the rules were reinstalled.
+  bool evictedTraffic = false;
+  std::vector<FlowRule> reinstall;
+  for (auto &it : dpIt->second.rules)
+    {
+      FlowRule &rule = it.second;
+      if (rule.trafficId == trafficId && rule.evictions)
+        {
+          evictedTraffic = true;
+          if (rule.evicted)
+            {
+              rule.lastUsed = Simulator::Now ();
+              reinstall.push_back (rule);
+            }
+        }
+    }
+  if (!evictedTraffic)
+    {
+      return;
+    }
+
+  NS_LOG_INFO ("Traffic " << trafficId << " missed an evicted rule on switch " << dpId);
+  dpIt->second.misses++;
+  m_evictionMissTrace (dpId, trafficId);
+  for (auto const &rule : reinstall)
+    {
+      InstallRule (dpId, rule.tableId, rule.priority, rule.idleTimeout,
+                   rule.match, rule.instructions, rule.trafficId);
+    }
+}
+
+std::pair<uint32_t, InetSocketAddress>
+SdnController::GetChainHop (uint16_t trafficId, size_t vnfIdx, bool upstream) const
+{
+  const ServiceTraffic &traffic = m_traffics.at (trafficId);
+  if (upstream)
+    {
+      if (vnfIdx == 0)
+        {
+          return std::make_pair (traffic.srcHostId, traffic.srcAddress);
+        }
+      Ptr<VnfInfo> vnfInfo = VnfInfo::GetPointer (traffic.vnfList.at (vnfIdx - 1));
+      return std::make_pair (traffic.serverList.at (vnfIdx - 1), vnfInfo->GetInetAddr ());
+    }
+  else
+    {
+      if (vnfIdx + 1 == traffic.vnfList.size ())
+        {
+          return std::make_pair (traffic.dstHostId, traffic.dstAddress);
+        }
+      Ptr<VnfInfo> vnfInfo = VnfInfo::GetPointer (traffic.vnfList.at (vnfIdx + 1));
+      return std::make_pair (traffic.serverList.at (vnfIdx + 1), vnfInfo->GetInetAddr ());
+    }
+}
+
+size_t
+SdnController::GetVnfIndex (uint16_t trafficId, uint8_t vnfId) const
+{
+  const std::vector<uint8_t> &vnfList = m_traffics.at (trafficId).vnfList;
+  auto it = std::find (vnfList.begin (), vnfList.end (), vnfId);
+  NS_ABORT_MSG_IF (it == vnfList.end (), "VNF not in the chain of traffic " << trafficId);
+  return it - vnfList.begin ();
+}
+
+void
+SdnController::SendMigrationBarrier (uint64_t dpId, uint32_t migrationId)
+{
+  NS_LOG_FUNCTION (this << dpId << migrationId);
+
+  m_migrations.at (migrationId).pendingBarriers++;
+
+  // The controller of another shard sends the barrier after the rules it
+  // got from us, and relays the reply back.
+  if (!OwnsDatapath (dpId))
+    {
+      Simulator::Schedule (m_shardDelay, &SdnController::RelayBarrier,
+                           GetShardOwner (dpId), dpId,
+                           Ptr<SdnController> (this), migrationId);
+      return;
+    }
+
+  uint32_t xid = GetNextXid ();
+  m_barrierXids [xid] = migrationId;
+
+  struct ofl_msg_header msg;
+  msg.type = OFPT_BARRIER_REQUEST;
+  SendToSwitch (GetRemoteSwitch (dpId), &msg, xid);
+}
+
+void
+SdnController::RelayBarrier (uint64_t dpId, Ptr<SdnController> requester,
+                             uint32_t migrationId)
+{
+  NS_LOG_FUNCTION (this << dpId << requester << migrationId);
+
+  uint32_t xid = GetNextXid ();
+  m_relayedBarriers [xid] = std::make_pair (requester, migrationId);
+
+  struct ofl_msg_header msg;
+  msg.type = OFPT_BARRIER_REQUEST;
+  SendToSwitch (GetRemoteSwitch (dpId), &msg, xid);
+}
+
+void
+SdnController::CompleteBarrier (uint32_t migrationId)
+{
+  NS_LOG_FUNCTION (this << migrationId);
+
+  // Move to the next phase when all switches confirmed the rules.
+  Migration &migration = m_migrations.at (migrationId);
+  if (--migration.pendingBarriers == 0)
+    {
+      if (migration.phase == INSTALL)
+        {
+          MigrationRedirect (migrationId);
+        }
+      else if (migration.phase == REDIRECT)
+        {
+          MigrationDrain (migrationId);
+        }
+    }
+}
+
+Ptr<SdnController>
+SdnController::GetShardOwner (uint64_t dpId)
+{
+  NS_LOG_FUNCTION (this << dpId);
+
+  uint16_t shardId = m_network->GetShardId (dpId);
+  m_crossShardRequests++;
+  m_crossShardTrace (m_shardId, shardId);
+  return m_network->GetController (shardId);
+}
+
+void
+SdnController::MigrationInstall (uint32_t migrationId)
+{
+  NS_LOG_FUNCTION (this << migrationId);
+
+  // Make: activate the VNF on the destination server and route the traffic
+  // from there to the next hop in the chain. The packet accounting starts now,
+  // as the new rules may already catch some packets.
+  Migration &migration = m_migrations.at (migrationId);
+  migration.phase = INSTALL;
+  for (auto trafficId : migration.trafficIds)
+    {
+      MigrationAccount account;
+      account.srcServerId = migration.srcServerId;
+      account.dstServerId = migration.dstServerId;
+      account.maxSeqNum = 0;
+      account.reorderedPkts = 0;
+      account.srcRx = false;
+      account.srcLastSeqNum = 0;
+      account.dstRx = false;
+      account.dstFirstSeqNum = 0;
+      m_accounts.insert (std::make_pair (std::make_pair (migration.vnfId, trafficId), account));
+
+      const ServiceTraffic &traffic = m_traffics.at (trafficId);
+      size_t vnfIdx = GetVnfIndex (trafficId, migration.vnfId);
+      SetUpVnf (migration.vnfId, migration.dstServerId, traffic.srcAddress);
+
+      std::pair<uint32_t, InetSocketAddress> next = GetChainHop (trafficId, vnfIdx, false);
+      if (next.first != migration.dstServerId)
+        {
+          RouteTraffic (traffic.srcAddress, next.second, migration.dstServerId, next.first);
+        }
+    }
+  SendMigrationBarrier (m_network->GetNetworkSwitchDpId (migration.dstServerId), migrationId);
+}
+
+void
+SdnController::MigrationRedirect (uint32_t migrationId)
+{
+  NS_LOG_FUNCTION (this << migrationId);
+
+  // Redirect the traffic at the upstream switch to the destination server.
+  // When the upstream switch is the source server itself, the VNF rule there
+  // must be removed so the new routing rule takes effect.
+  Migration &migration = m_migrations.at (migrationId);
+  migration.phase = REDIRECT;
+  std::set<uint64_t> dpIds;
+  for (auto trafficId : migration.trafficIds)
+    {
+      ServiceTraffic &traffic = m_traffics.at (trafficId);
+      size_t vnfIdx = GetVnfIndex (trafficId, migration.vnfId);
+      InetSocketAddress vnfAddress = VnfInfo::GetPointer (migration.vnfId)->GetInetAddr ();
+
+      uint32_t prevNodeId = GetChainHop (trafficId, vnfIdx, true).first;
+      if (prevNodeId != migration.dstServerId)
+        {
+          RouteTraffic (traffic.srcAddress, vnfAddress, prevNodeId, migration.dstServerId);
+          if (prevNodeId == migration.srcServerId)
+            {
+              TearDownVnf (migration.vnfId, migration.srcServerId, traffic.srcAddress);
+            }
+          dpIds.insert (m_network->GetNetworkSwitchDpId (prevNodeId));
+        }
+      traffic.serverList.at (vnfIdx) = migration.dstServerId;
+      m_network->m_registry->UpdatePlacement (m_shardId, trafficId,
+                                              traffic.serverList);
+    }
+
+  if (dpIds.empty ())
+    {
+      MigrationDrain (migrationId);
+      return;
+    }
+  for (auto dpId : dpIds)
+    {
+      SendMigrationBarrier (dpId, migrationId);
+    }
+}
+
+void
+SdnController::MigrationDrain (uint32_t migrationId)
+{
+  NS_LOG_FUNCTION (this << migrationId);
+
+  // Break: wait for the in-flight packets on the old path before removing
+  // the VNF rules from the source server.
+  m_migrations.at (migrationId).phase = DRAIN;
+  Simulator::Schedule (m_drainTime, &SdnController::MigrationFinish, this, migrationId);
+}
+
+void
+SdnController::MigrationFinish (uint32_t migrationId)
+{
+  NS_LOG_FUNCTION (this << migrationId);
+
+  const Migration &migration = m_migrations.at (migrationId);
+  Time duration = Simulator::Now () - migration.startTime;
+  for (auto trafficId : migration.trafficIds)
+    {
+      // Remove the VNF and the route to the next hop from the source server,
+      // whatever the chain looks like now.
+      const ServiceTraffic &traffic = m_traffics.at (trafficId);
+      size_t vnfIdx = GetVnfIndex (trafficId, migration.vnfId);
+      TearDownVnf (migration.vnfId, migration.srcServerId, traffic.srcAddress);
+      UnrouteTraffic (traffic.srcAddress, GetChainHop (trafficId, vnfIdx, false).second,
+                      migration.srcServerId);
+
+      // Only the sequence numbers around the switchover, between the last
+      // packet at the source copy and the first one at the destination copy,
+      // were lost by the migration. The gaps elsewhere are ordinary drops.
+      auto key = std::make_pair (migration.vnfId, trafficId);
+      const MigrationAccount &account = m_accounts.at (key);
+      uint32_t lostPkts = 0;
+      if (account.srcRx && account.dstRx)
+        {
+          int64_t srcLast = account.srcLastSeqNum;
+          int64_t dstFirst = account.dstFirstSeqNum;
+          int64_t first = std::min (srcLast + 1, dstFirst);
+          int64_t last = std::max (srcLast, dstFirst - 1);
+          if (first <= last)
+            {
+              size_t received = std::distance (account.seqNums.lower_bound (first),
+                                               account.seqNums.upper_bound (last));
+              lostPkts = last - first + 1 - received;
+            }
+        }
+      uint32_t reorderedPkts = account.reorderedPkts;
+      m_accounts.erase (key);
+
+      std::pair<uint32_t, uint32_t> &counters = m_migrationCounters [trafficId];
+      counters.first += lostPkts;
+      counters.second += reorderedPkts;
+
+      NS_LOG_INFO ("VNF " << (uint16_t)migration.vnfId << " for traffic " <<
+                   trafficId << " moved from server " << migration.srcServerId <<
+                   " to server " << migration.dstServerId << " in " <<
+                   duration.As (Time::MS) << " with " << lostPkts <<
+                   " lost and " << reorderedPkts << " reordered packets");
+      m_migrationTrace (migration.vnfId, trafficId, migration.srcServerId,
+                        migration.dstServerId, duration, lostPkts, reorderedPkts);
+    }
+  m_migrations.erase (migrationId);
+}
+
+Ipv4Address
+SdnController::ExtractIpv4Address (uint32_t oxm_of, struct ofl_match* match)
+{
+  switch (oxm_of)
+    {
+      case OXM_OF_ARP_SPA:
+      case OXM_OF_ARP_TPA:
+      case OXM_OF_IPV4_DST:
+      case OXM_OF_IPV4_SRC:
+        {
+          uint32_t ip;
+          int size = OXM_LENGTH (oxm_of);
+          struct ofl_match_tlv *tlv = oxm_match_lookup (oxm_of, match);
+          memcpy (&ip, tlv->value, size);
+          return Ipv4Address (ntohl (ip));
+        }
+      default:
+        NS_ABORT_MSG ("Invalid IP field.");
+    }
+}
+
+Ptr<Packet>
+SdnController::CreateArpReply (Mac48Address srcMac, Ipv4Address srcIp,
+                               Mac48Address dstMac, Ipv4Address dstIp)
+{
+  NS_LOG_FUNCTION (this << srcMac << srcIp << dstMac << dstIp);
+
+  Ptr<Packet> packet = Create<Packet> ();
+
+  // ARP header
+  ArpHeader arp;
+  arp.SetReply (srcMac, srcIp, dstMac, dstIp);
+  packet->AddHeader (arp);
+
+  // Ethernet header
+  EthernetHeader eth (false);
+  eth.SetSource (srcMac);
+  eth.SetDestination (dstMac);
+  if (packet->GetSize () < 46)
+    {
+      uint8_t buffer[46];
+      memset (buffer, 0, 46);
+      Ptr<Packet> padd = Create<Packet> (buffer, 46 - packet->GetSize ());
+      packet->AddAtEnd (padd);
+    }
+  eth.SetLengthType (ArpL3Protocol::PROT_NUMBER);
+  packet->AddHeader (eth);
 
   // Ethernet trailer
   EthernetTrailer trailer;
@@ -412,6 +1970,32 @@ SdnController::CreateArpReply (Mac48Address srcMac, Ipv4Address srcIp,
   return packet;
 }
 
+void
+SdnController::PreloadArpCaches (NodeContainer nodes) const
+{
+  NS_LOG_FUNCTION (this);
+
+  for (NodeContainer::Iterator n = nodes.Begin (); n != nodes.End (); ++n)
+    {
+      Ptr<Ipv4L3Protocol> ipv4 = (*n)->GetObject<Ipv4L3Protocol> ();
+      for (uint32_t i = 0; i < ipv4->GetNInterfaces (); i++)
+        {
+          Ptr<ArpCache> cache = ipv4->GetInterface (i)->GetArpCache ();
+          if (!cache)
+            {
+              continue; // Loopback interface.
+            }
+          for (auto const &entry : m_arpTable)
+            {
+              if (ipv4->GetInterfaceForAddress (entry.first) == -1)
+                {
+                  cache->AddPermanent (entry.first, entry.second);
+                }
+            }
+        }
+    }
+}
+
 void
 SdnController::SaveArpEntry (Ipv4Address ipAddr, Mac48Address macAddr)
 {
@@ -18,9 +18,12 @@
 #define SDN_CONTROLLER_H
 
 #include <ns3/ofswitch13-module.h>
+#include <deque>
+#include <unordered_map>
 
 namespace ns3 {
 
+class PlacementEngine;
 class SdnNetwork;
 class VnfInfo;
 
@@ -31,8 +34,9 @@ public:
   /**
    * Complete constructor.
    * \param sdnNetwork The SDN network.
+   * \param shardId The shard of datapaths owned by this controller.
    */
-  SdnController (Ptr<SdnNetwork> sdnNetwork);
+  SdnController (Ptr<SdnNetwork> sdnNetwork, uint16_t shardId = 0);
   virtual ~SdnController (); //!< Dummy destructor.
 
   /**
@@ -67,8 +71,15 @@ public:
     uint32_t switchToServerPortNo, uint32_t serverToSwitchPortNo,
     Ptr<VnfInfo> vnfInfo);
 
+  /**
+   * Notify this controller that the network topology is complete, so it can
+   * load the link capacities into the placement engine.
+   */
+  void NotifyTopologyBuilt (void);
+
   /**
    * Notify this controller about a new service traffic flow in the network.
+   * The VNFs in the chain are placed by the placement engine.
    * \param srcAddress The source socket address (traffic ID).
    * \param dstAddress The destination socket address.
    * \param srcHostId The source host node ID.
@@ -96,6 +107,27 @@ public:
     uint32_t srcHostId, uint32_t dstHostId,
     Time startTime, Time stopTime);
 
+  /**
+   * Notify this controller about a new fluid traffic flow in the network.
+   * \param trafficId The traffic ID.
+   * \param srcHostId The source host node ID.
+   * \param dstHostId The destination host node ID.
+   * \param vnfList The list of VNF IDs for this traffic (may be empty).
+   * \param rate The flow source data rate.
+   * \param startTime The flow start time.
+   * \param stopTime The flow stop time.
+   */
+  void NotifyNewFluidTraffic (
+    uint16_t trafficId, uint32_t srcHostId, uint32_t dstHostId,
+    std::vector<uint8_t> vnfList, DataRate rate,
+    Time startTime, Time stopTime);
+
+  /**
+   * Get the VNF placement engine of this shard.
+   * \return The placement engine.
+   */
+  Ptr<PlacementEngine> GetPlacementEngine (void) const;
+
   /**
    * Activate the VNF on a given server for a specific traffic.
    * \param vnfId The VNF ID
@@ -106,6 +138,9 @@ public:
 
   /**
    * Move the active VNF from one server to the other for a specific traffic.
+   * The migration uses make-before-break ordering: the new rules are installed
+   * and confirmed by a barrier before the traffic is redirected, and the old
+   * rules are only removed after the in-flight packets are drained.
    * \param vnfId The VNF ID
    * \param srcServerId The source server ID
    * \param dstServerId The destination server ID
@@ -114,6 +149,193 @@ public:
   void MoveVnf (uint8_t vnfId, uint32_t srcServerId, uint32_t dstServerId,
                 InetSocketAddress srcAddress);
 
+  /**
+   * Move the active VNF from one server to the other for a batch of traffics.
+   * All traffics are migrated together, sharing the barriers in each phase.
+   * \param vnfId The VNF ID
+   * \param srcServerId The source server ID
+   * \param dstServerId The destination server ID
+   * \param srcAddresses The source socket addresses (traffic IDs)
+   */
+  void MoveVnf (uint8_t vnfId, uint32_t srcServerId, uint32_t dstServerId,
+                std::vector<InetSocketAddress> srcAddresses);
+
+  /**
+   * Move the active VNF from one server to the other for all service traffics
+   * using it in the source server.
+   * \param vnfId The VNF ID
+   * \param srcServerId The source server ID
+   * \param dstServerId The destination server ID
+   */
+  void MoveVnf (uint8_t vnfId, uint32_t srcServerId, uint32_t dstServerId);
+
+  /**
+   * Notify this controller of a packet received by a VNF application in the
+   * network switch. This is used to account for lost and reordered packets
+   * during VNF migrations.
+   * \param vnfId The VNF ID.
+   * \param vnfCopy The VNF copy number (the server ID).
+   * \param trafficId The traffic ID.
+   * \param seqNum The packet sequence number.
+   */
+  void NotifyVnfRx (uint8_t vnfId, uint32_t vnfCopy, uint16_t trafficId,
+                    uint32_t seqNum);
+
+  /**
+   * \name Migration counters accessors.
+   * \param trafficId The traffic ID.
+   * \return The total number of packets lost at the switchover or reordered
+   *         while migrating VNFs for this traffic.
+   */
+  //\{
+  uint32_t GetMigrationLostPkts      (uint16_t trafficId) const;
+  uint32_t GetMigrationReorderedPkts (uint16_t trafficId) const;
+  //\}
+
+  /**
+   * TracedCallback signature for completed VNF migrations.
+   * \param vnfId The VNF ID.
+   * \param trafficId The traffic ID.
+   * \param srcServerId The source server ID.
+   * \param dstServerId The destination server ID.
+   * \param duration The migration duration.
+   * \param lostPkts The number of packets lost at the switchover, between the
+   *        last packet at the source and the first one at the destination.
+   * \param reorderedPkts The number of packets reordered during the migration.
+   */
+  typedef void (*MigrationTracedCallback)(
+    uint8_t vnfId, uint16_t trafficId, uint32_t srcServerId,
+    uint32_t dstServerId, Time duration, uint32_t lostPkts,
+    uint32_t reorderedPkts);
+
+  /**
+   * \name Statistics accessors.
+   * The rates are measured by the statistics poller between its last two
+   * polls of the switch, and are zero when unknown.
+   * \param dpId The datapath ID.
+   * \param portNo The port number.
+   * \param trafficId The traffic ID.
+   * \return The data rate.
+   */
+  //\{
+  DataRate GetPortRxRate  (uint64_t dpId, uint32_t portNo) const;
+  DataRate GetPortTxRate  (uint64_t dpId, uint32_t portNo) const;
+  DataRate GetTrafficRate (uint64_t dpId, uint16_t trafficId) const;
+  //\}
+
+  /**
+   * Get the number of flow rules in a switch, as seen by the last complete
+   * poll of its flow statistics.
+   * \param dpId The datapath ID.
+   * \return The number of flow rules.
+   */
+  uint32_t GetRuleCount (uint64_t dpId) const;
+
+  /**
+   * Get the number of packet-level traffics currently active in the network.
+   * \return The number of active traffics.
+   */
+  uint32_t GetActiveTrafficCount (void) const;
+
+  /**
+   * TracedCallback signature for statistics updates.
+   * \param dpId The datapath ID.
+   */
+  typedef void (*StatsTracedCallback)(uint64_t dpId);
+
+  /**
+   * TracedCallback signature for the rule count of a switch.
+   * \param dpId The datapath ID.
+   * \param rules The number of flow rules in the switch.
+   * \param traffics The number of active traffics in the network.
+   */
+  typedef void (*RuleCountTracedCallback)(
+    uint64_t dpId, uint32_t rules, uint32_t traffics);
+
+  /**
+   * Get the number of packet-in messages waiting for the controller.
+   * \return The number of queued packet-in messages.
+   */
+  uint32_t GetPacketInQueueLength (void) const;
+
+  /**
+   * TracedCallback signature for packet-in messages processed by the
+   * controller.
+   * \param dpId The datapath ID.
+   * \param delay The time since the message arrived at the controller.
+   */
+  typedef void (*PacketInTracedCallback)(uint64_t dpId, Time delay);
+
+  /**
+   * TracedCallback signature for packet-in messages dropped by the
+   * controller.
+   * \param dpId The datapath ID.
+   */
+  typedef void (*PacketInDropTracedCallback)(uint64_t dpId);
+
+  /** The rule eviction policies for full flow tables. */
+  enum EvictionPolicy
+  {
+    LRU,          //!< Evict the least recently used rule.
+    IMPORTANCE    //!< Evict the lowest priority rule, least recently used first.
+  };
+
+  /**
+   * \name Flow table eviction counters accessors.
+   * \param dpId The datapath ID.
+   * \return The number of rules evicted from the switch, or the number of
+   *         packets that missed the flow tables of the switch because the
+   *         rule for their traffic was evicted.
+   */
+  //\{
+  uint32_t GetEvictionCount     (uint64_t dpId) const;
+  uint32_t GetEvictionMissCount (uint64_t dpId) const;
+  //\}
+
+  /**
+   * TracedCallback signature for full flow tables.
+   * \param dpId The datapath ID.
+   * \param tableId The flow table ID.
+   */
+  typedef void (*TableFullTracedCallback)(uint64_t dpId, uint8_t tableId);
+
+  /**
+   * TracedCallback signature for packets missing an evicted rule.
+   * \param dpId The datapath ID.
+   * \param trafficId The traffic ID.
+   */
+  typedef void (*EvictionMissTracedCallback)(uint64_t dpId, uint16_t trafficId);
+
+  /**
+   * Get the shard of datapaths owned by this controller.
+   * \return The shard ID.
+   */
+  uint16_t GetShardId (void) const;
+
+  /**
+   * Check if a switch belongs to the shard of this controller.
+   * \param dpId The datapath ID.
+   * \return True if this controller manages the switch.
+   */
+  bool OwnsDatapath (uint64_t dpId) const;
+
+  /**
+   * \name Shard control plane metrics accessors.
+   * \return The mean time packet-in messages waited for this controller, or
+   *         the number of messages this controller sent to other shards.
+   */
+  //\{
+  Time     GetAveragePacketInDelay  (void) const;
+  uint32_t GetCrossShardRequests    (void) const;
+  //\}
+
+  /**
+   * TracedCallback signature for messages sent to another shard.
+   * \param srcShardId The sending shard.
+   * \param dstShardId The receiving shard.
+   */
+  typedef void (*CrossShardTracedCallback)(uint16_t srcShardId, uint16_t dstShardId);
+
   /**
    * Route network traffic from source to destination switches,
    * considering source and destination addresses.
@@ -146,18 +368,278 @@ protected:
   // Inherited from OFSwitch13Controller
   ofl_err HandlePacketIn (
     struct ofl_msg_packet_in *msg, Ptr<const RemoteSwitch> swtch, uint32_t xid);
+  ofl_err HandleBarrierReply (
+    struct ofl_msg_header *msg, Ptr<const RemoteSwitch> swtch, uint32_t xid);
+  ofl_err HandleFlowRemoved (
+    struct ofl_msg_flow_removed *msg, Ptr<const RemoteSwitch> swtch,
+    uint32_t xid);
+  ofl_err HandleMultipartReply (
+    struct ofl_msg_multipart_reply_header *msg, Ptr<const RemoteSwitch> swtch,
+    uint32_t xid);
   void HandshakeSuccessful (Ptr<const RemoteSwitch> swtch);
 
 private:
   /**
-   * Handle ARP request messages.
+   * Remove the rule activating the VNF on a given server for a specific
+   * traffic.
+   * \param vnfId The VNF ID
+   * \param serverId The server ID
+   * \param srcAddress The source socket address (traffic ID)
+   */
+  void TearDownVnf (uint8_t vnfId, uint32_t serverId, InetSocketAddress srcAddress);
+
+  /**
+   * Remove the rule routing the traffic from a network node.
+   * \param srcAddress The source socket address (traffic ID)
+   * \param dstAddress The destination socket address
+   * \param srcNodeId The source node ID
+   */
+  void UnrouteTraffic (InetSocketAddress srcAddress, InetSocketAddress dstAddress,
+                       uint32_t srcNodeId);
+
+  /**
+   * Install a per-traffic rule in a switch. When the flow tables have a
+   * limited capacity, the rule is tracked by the controller, and a rule is
+   * evicted from a full table to make room for it.
+   * \param dpId The datapath ID.
+   * \param tableId The flow table ID.
+   * \param priority The rule priority.
+   * \param idleTimeout The rule idle timeout (sec).
+   * \param match The dpctl match fields.
+   * \param instructions The dpctl instructions.
+   * \param trafficId The traffic ID matched by the rule.
+   */
+  void InstallRule (uint64_t dpId, uint8_t tableId, uint16_t priority,
+                    uint16_t idleTimeout, std::string match,
+                    std::string instructions, uint16_t trafficId);
+
+  /**
+   * Remove a per-traffic rule from a switch.
+   * \param dpId The datapath ID.
+   * \param tableId The flow table ID.
+   * \param priority The rule priority.
+   * \param match The dpctl match fields.
+   */
+  void RemoveRule (uint64_t dpId, uint8_t tableId, uint16_t priority,
+                   std::string match);
+
+  /**
+   * Evict a rule from a full flow table, according to the eviction policy.
+   * \param dpId The datapath ID.
+   * \param tableId The flow table ID.
+   */
+  void EvictRule (uint64_t dpId, uint8_t tableId);
+
+  /**
+   * Handle the packets missing the flow tables, and reinstall the rules of
+   * their traffic when they were evicted.
    * \param msg The packet-in message.
-   * \param swtch The switch information.
+   * \param dpId The datapath ID.
+   */
+  void HandleMissPacketIn (struct ofl_msg_packet_in *msg, uint64_t dpId);
+
+  /**
+   * Get the network node and the socket address before (upstream) or after
+   * (downstream) a VNF in the service traffic chain.
+   * \param trafficId The traffic ID.
+   * \param vnfIdx The VNF index in the chain.
+   * \param upstream True for the previous hop, false for the next hop.
+   * \return The network node ID and the socket address for this hop.
+   */
+  std::pair<uint32_t, InetSocketAddress> GetChainHop (
+    uint16_t trafficId, size_t vnfIdx, bool upstream) const;
+
+  /**
+   * Get the index of the VNF in the service traffic chain.
+   * \param trafficId The traffic ID.
+   * \param vnfId The VNF ID.
+   * \return The VNF index.
+   */
+  size_t GetVnfIndex (uint16_t trafficId, uint8_t vnfId) const;
+
+  /**
+   * Send a barrier request to the switch on behalf of a VNF migration.
+   * \param dpId The datapath ID.
+   * \param migrationId The migration ID.
+   */
+  void SendMigrationBarrier (uint64_t dpId, uint32_t migrationId);
+
+  /**
+   * Send a barrier request to a switch of this shard on behalf of a VNF
+   * migration of another shard.
+   * \param dpId The datapath ID.
+   * \param requester The controller running the migration.
+   * \param migrationId The migration ID at the requester.
+   */
+  void RelayBarrier (uint64_t dpId, Ptr<SdnController> requester,
+                     uint32_t migrationId);
+
+  /**
+   * Account a barrier reply for a VNF migration, moving the migration to its
+   * next phase when all the switches confirmed the rules.
+   * \param migrationId The migration ID.
+   */
+  void CompleteBarrier (uint32_t migrationId);
+
+  /**
+   * Get the controller owning a switch of another shard, accounting the
+   * request sent to it.
+   * \param dpId The datapath ID.
+   * \return The owner controller.
+   */
+  Ptr<SdnController> GetShardOwner (uint64_t dpId);
+
+  /**
+   * \name VNF migration phases.
+   * \param migrationId The migration ID.
+   */
+  //\{
+  void MigrationInstall  (uint32_t migrationId);
+  void MigrationRedirect (uint32_t migrationId);
+  void MigrationDrain    (uint32_t migrationId);
+  void MigrationFinish   (uint32_t migrationId);
+  //\}
+
+  /**
+   * Update the number of active traffics.
+   * \param delta The traffics started (positive) or stopped (negative).
+   */
+  void CountActiveTraffics (int32_t delta);
+
+  /**
+   * Send the flow and port statistics requests to all switches, and schedule
+   * the next poll.
+   */
+  void PollStats (void);
+
+  /** Counters and rate of a flow rule or a port direction. */
+  struct StatsEntry
+  {
+    uint64_t              bytes;      //!< Byte counter at the last poll.
+    uint64_t              packets;    //!< Packet counter of a flow rule.
+    Time                  duration;   //!< Duration counter at the last poll.
+    double                byteRate;   //!< Rate between the last two polls (bytes/s).
+    uint32_t              round;      //!< Last poll round updating this entry.
+    uint16_t              trafficId;  //!< Traffic ID matched by a flow rule.
+  };
+
+  /**
+   * Update the counters and the rate of a statistics entry.
+   * \param entry The statistics entry.
+   * \param bytes The byte counter reported by the switch.
+   * \param duration The duration counter reported by the switch.
+   */
+  void UpdateStats (StatsEntry &entry, uint64_t bytes, Time duration);
+
+  /** Statistics of a switch port. */
+  struct PortStats
+  {
+    StatsEntry            rx;         //!< Received traffic.
+    StatsEntry            tx;         //!< Transmitted traffic.
+  };
+
+  /** Statistics of a switch, kept from one poll to the other. */
+  struct DatapathStats
+  {
+    std::unordered_map<uint64_t, StatsEntry> flows;  //!< Flow rules by key.
+    std::map<uint32_t, PortStats>   ports;         //!< Ports by number.
+    std::map<uint16_t, double>      trafficRates;  //!< Traffic rates (bytes/s).
+    std::vector<uint32_t>           tableEntries;  //!< Rules in each table.
+    std::vector<uint64_t>           tablePackets;  //!< Packets matched in each table.
+  };
+
+  /**
+   * \name Statistics reply handlers.
+   * \param stats The statistics of the switch.
+   * \param msg The multipart reply message.
+   * \param dpId The datapath ID.
+   */
+  //\{
+  void HandleFlowStats (DatapathStats &stats,
+                        struct ofl_msg_multipart_reply_flow *msg, uint64_t dpId);
+  void HandlePortStats (DatapathStats &stats,
+                        struct ofl_msg_multipart_reply_port *msg, uint64_t dpId);
+  //\}
+
+  /**
+   * Take the next batch of packet-in messages, from the next datapath with
+   * queued messages in round robin order, and schedule the end of its
+   * processing according to the controller processing rate.
+   */
+  void StartPacketInBatch (void);
+
+  /**
+   * Process the current batch of packet-in messages, send the resulting
+   * packet-out messages and start the next batch.
+   */
+  void FinishPacketInBatch (void);
+
+  /**
+   * Process a packet-in message. The message is freed, and the packet-out
+   * messages in reply are left in the packet-out buffers.
+   * \param msg The packet-in message.
+   * \param dpId The datapath ID.
    * \param xid Transaction id.
-   * \return 0 if everything's ok, otherwise an error number.
    */
-  ofl_err HandleArpPacketIn (
-    struct ofl_msg_packet_in *msg, Ptr<const RemoteSwitch> swtch, uint32_t xid);
+  void ProcessPacketIn (struct ofl_msg_packet_in *msg, uint64_t dpId,
+                        uint32_t xid);
+
+  /**
+   * Handle ARP request messages. A request for an address not yet in the
+   * replica of this shard waits until the entry arrives.
+   * \param msg The packet-in message.
+   * \param dpId The datapath ID.
+   * \param xid Transaction id.
+   */
+  void HandleArpPacketIn (struct ofl_msg_packet_in *msg, uint64_t dpId,
+                          uint32_t xid);
+
+  /** Buffer for a packet-out message built by the controller. */
+  struct PacketOutBuffer
+  {
+    struct ofl_msg_packet_out   msg;      //!< Packet-out message.
+    struct ofl_action_output    output;   //!< Output action.
+    struct ofl_action_header   *action;   //!< Action list of the message.
+    uint32_t                    xid;      //!< Transaction ID.
+    uint8_t                     data[64]; //!< Frame sent by the switch.
+  };
+
+  /**
+   * Get a free buffer for a packet-out message, growing the pool if needed.
+   * The buffer stays in use until the packet-out messages are sent, and
+   * its pointers are only set then, as the pool may grow meanwhile.
+   * \param xid Transaction id.
+   * \return The packet-out buffer.
+   */
+  PacketOutBuffer &AllocPacketOut (uint32_t xid);
+
+  /**
+   * Send the packet-out messages in use to the switch and release their
+   * buffers.
+   * \param swtch The switch information.
+   */
+  void SendPacketOuts (Ptr<const RemoteSwitch> swtch);
+
+  /**
+   * Fill a packet-out buffer with an ARP reply sent back to the input port.
+   * \param reply The packet-out buffer.
+   * \param inPort The input port of the ARP request.
+   * \param srcMac Source MAC address.
+   * \param srcIp Source IP address.
+   * \param dstMac Destination MAC address.
+   * \param dstIp Destination IP address.
+   */
+  void FillArpReply (PacketOutBuffer &reply, uint32_t inPort,
+                     Mac48Address srcMac, Ipv4Address srcIp,
+                     Mac48Address dstMac, Ipv4Address dstIp);
+
+  /**
+   * Notified when an ARP entry reaches the replica of this shard, to reply
+   * to the ARP requests waiting for it.
+   * \param ipAddr The IPv4 address.
+   * \param macAddr The MAC address.
+   */
+  void NotifyArpEntry (Ipv4Address ipAddr, Mac48Address macAddr);
 
   /**
    * Extract an IPv4 address from packet match.
@@ -180,7 +662,209 @@ private:
     Mac48Address srcMac, Ipv4Address srcIp,
     Mac48Address dstMac, Ipv4Address dstIp);
 
-  Ptr<SdnNetwork>   m_network;      //!< SDN network pointer.
+  /**
+   * Preload the ARP caches of the IP nodes with permanent entries for all
+   * the addresses in the ARP table, so that they never send ARP requests.
+   * \param nodes The IP nodes.
+   */
+  void PreloadArpCaches (NodeContainer nodes) const;
+
+  Ptr<SdnNetwork>       m_network;        //!< SDN network pointer.
+  Time                  m_drainTime;      //!< Migration drain time.
+  TypeId                m_placementType;  //!< Placement engine type.
+  Ptr<PlacementEngine>  m_placement;      //!< Placement engine.
+  DataRate              m_flowRate;       //!< Estimated packet flow rate.
+  bool                  m_aggregateRoutes;//!< Per-host routes for all traffics.
+  std::set<Ipv4Address> m_hostAddresses;  //!< Host IPv4 addresses.
+  uint32_t              m_activeTraffics; //!< Active packet-level traffics.
+
+  /** Metadata associated to a service traffic. */
+  struct ServiceTraffic
+  {
+    InetSocketAddress     srcAddress; //!< Source socket address.
+    InetSocketAddress     dstAddress; //!< Destination socket address.
+    uint32_t              srcHostId;  //!< Source host node ID.
+    uint32_t              dstHostId;  //!< Destination host node ID.
+    std::vector<uint8_t>  vnfList;    //!< VNF IDs for this traffic.
+    std::vector<uint32_t> serverList; //!< Server ID for each VNF.
+  };
+
+  /** Map saving traffic ID / service traffic metadata. */
+  typedef std::map<uint16_t, ServiceTraffic> TrafficMap_t;
+  TrafficMap_t      m_traffics;     //!< Service traffics.
+
+  /** The VNF migration phases. */
+  enum MigrationPhase
+  {
+    INSTALL,      //!< Installing the new rules.
+    REDIRECT,     //!< Redirecting the traffic to the new server.
+    DRAIN         //!< Draining the in-flight packets from the old server.
+  };
+
+  /** Metadata associated to a batch VNF migration. */
+  struct Migration
+  {
+    uint8_t               vnfId;          //!< VNF ID.
+    uint32_t              srcServerId;    //!< Source server ID.
+    uint32_t              dstServerId;    //!< Destination server ID.
+    std::vector<uint16_t> trafficIds;     //!< Traffics being migrated.
+    MigrationPhase        phase;          //!< Current migration phase.
+    uint32_t              pendingBarriers;//!< Barrier replies to wait for.
+    Time                  startTime;      //!< Migration start time.
+  };
+
+  /** Map saving migration ID / migration metadata. */
+  typedef std::map<uint32_t, Migration> MigrationMap_t;
+  MigrationMap_t    m_migrations;   //!< Active migrations.
+
+  /** Map saving barrier transaction ID / migration ID. */
+  typedef std::map<uint32_t, uint32_t> XidMap_t;
+  XidMap_t          m_barrierXids;  //!< Pending migration barriers.
+
+  /** Map saving barrier transaction ID / <requester, migration ID>. */
+  typedef std::map<uint32_t, std::pair<Ptr<SdnController>, uint32_t>> RelayMap_t;
+  RelayMap_t        m_relayedBarriers; //!< Barriers for other shards.
+
+  /** Packet accounting for a traffic while migrating a VNF. */
+  struct MigrationAccount
+  {
+    uint32_t              srcServerId;    //!< Source server ID.
+    uint32_t              dstServerId;    //!< Destination server ID.
+    std::set<uint32_t>    seqNums;        //!< Sequence numbers received.
+    uint32_t              maxSeqNum;      //!< Highest sequence number.
+    uint32_t              reorderedPkts;  //!< Reordered packets.
+    bool                  srcRx;          //!< Packets received at the source.
+    uint32_t              srcLastSeqNum;  //!< Last sequence number at the source.
+    bool                  dstRx;          //!< Packets received at the destination.
+    uint32_t              dstFirstSeqNum; //!< First sequence number at the destination.
+  };
+
+  /** Map saving <VNF ID, traffic ID> / packet accounting. */
+  typedef std::map<std::pair<uint8_t, uint16_t>, MigrationAccount> AccountMap_t;
+  AccountMap_t      m_accounts;     //!< Active packet accounting.
+
+  /** Map saving traffic ID / total <lost, reordered> packets. */
+  typedef std::map<uint16_t, std::pair<uint32_t, uint32_t>> CounterMap_t;
+  CounterMap_t      m_migrationCounters; //!< Migration counters.
+
+  /** Trace source fired when a VNF migration completes for a traffic. */
+  TracedCallback<uint8_t, uint16_t, uint32_t, uint32_t, Time, uint32_t, uint32_t>
+  m_migrationTrace;
+
+  /** Map saving datapath ID / switch statistics. */
+  typedef std::map<uint64_t, DatapathStats> StatsMap_t;
+  StatsMap_t        m_stats;        //!< Switch statistics.
+  Time              m_statsInterval;//!< Statistics poll interval.
+  EventId           m_statsEvent;   //!< Next statistics poll.
+  uint32_t          m_statsRound;   //!< Current statistics poll round.
+
+  /** Requests for all the flow rules and all the ports, sent at each poll. */
+  struct ofl_msg_multipart_request_flow m_flowStatsRequest;
+  struct ofl_msg_multipart_request_port m_portStatsRequest;
+
+  /** Trace sources fired when the statistics of a switch are updated. */
+  TracedCallback<uint64_t> m_flowStatsTrace;
+  TracedCallback<uint64_t> m_portStatsTrace;
+
+  /** Trace source fired with the rule count of a switch at each poll. */
+  TracedCallback<uint64_t, uint32_t, uint32_t> m_ruleCountTrace;
+
+  /** A packet-in message waiting for the controller. */
+  struct PendingPacketIn
+  {
+    struct ofl_msg_packet_in *msg;        //!< Packet-in message.
+    uint32_t              xid;            //!< Transaction ID.
+    Time                  arrival;        //!< Arrival time.
+  };
+
+  /** Map saving datapath ID / queued packet-in messages. */
+  typedef std::map<uint64_t, std::deque<PendingPacketIn>> PacketInQueueMap_t;
+  PacketInQueueMap_t m_packetInQueues;    //!< Queued packet-in messages.
+  std::vector<PendingPacketIn> m_packetInBatch; //!< Batch being processed.
+  uint64_t          m_packetInDpId;       //!< Datapath of the last batch.
+  uint32_t          m_packetInQueued;     //!< Queued packet-in messages.
+  EventId           m_packetInEvent;      //!< End of the current batch.
+  double            m_packetInRate;       //!< Packet-ins processed per second.
+  uint32_t          m_packetInBatchSize;  //!< Packet-ins per batch.
+  uint32_t          m_packetInQueueSize;  //!< Maximum queued packet-ins.
+
+  std::vector<PacketOutBuffer> m_packetOutPool; //!< Packet-out buffers.
+  uint32_t          m_packetOutUsed;      //!< Packet-out buffers in use.
+
+  /** An ARP request waiting for the replica of this shard. */
+  struct PendingArpRequest
+  {
+    uint64_t              dpId;           //!< Datapath ID.
+    uint32_t              xid;            //!< Transaction ID.
+    uint32_t              inPort;         //!< Input port.
+    Ipv4Address           srcIp;          //!< Requester IP address.
+    Mac48Address          srcMac;         //!< Requester MAC address.
+  };
+
+  /** Map saving IPv4 address / ARP requests waiting for it. */
+  typedef std::map<Ipv4Address, std::vector<PendingArpRequest>> ArpRequestMap_t;
+  ArpRequestMap_t   m_pendingArpRequests; //!< Queued ARP requests.
+
+  /** Trace source fired when a packet-in message is processed. */
+  TracedCallback<uint64_t, Time> m_packetInTrace;
+
+  /** Trace source fired when a packet-in message is dropped. */
+  TracedCallback<uint64_t> m_packetInDropTrace;
+
+  uint64_t          m_packetInCount;      //!< Processed packet-ins.
+  double            m_packetInDelaySum;   //!< Sum of packet-in delays (s).
+
+  uint16_t          m_shardId;            //!< Shard of this controller.
+  Time              m_shardDelay;         //!< Delay to reach other shards.
+  uint32_t          m_crossShardRequests; //!< Messages to other shards.
+
+  /** Trace source fired when a message is sent to another shard. */
+  TracedCallback<uint16_t, uint16_t> m_crossShardTrace;
+
+  /** A per-traffic rule tracked for the flow table capacity. */
+  struct FlowRule
+  {
+    uint8_t               tableId;    //!< Flow table ID.
+    uint16_t              priority;   //!< Rule priority.
+    uint16_t              idleTimeout;//!< Rule idle timeout (sec).
+    std::string           match;      //!< dpctl match fields.
+    std::string           instructions; //!< dpctl instructions.
+    uint16_t              trafficId;  //!< Traffic ID matched by the rule.
+    uint64_t              cookie;     //!< Cookie identifying the rule.
+    uint64_t              packets;    //!< Packet counter at the last poll.
+    Time                  lastUsed;   //!< Last time the rule matched packets.
+    bool                  evicted;    //!< Rule evicted from the switch.
+    uint32_t              evictions;  //!< Times the rule was evicted.
+  };
+
+  /** Map saving <table ID, priority, match> / per-traffic rule. */
+  typedef std::map<std::string, FlowRule> FlowRuleMap_t;
+
+  /** The per-traffic rules of a switch. */
+  struct DatapathRules
+  {
+    FlowRuleMap_t         rules;      //!< Installed and evicted rules.
+    std::map<uint8_t, uint32_t> tableRules; //!< Installed rules per table.
+    uint32_t              evictions;  //!< Rules evicted.
+    uint32_t              misses;     //!< Packets missing an evicted rule.
+  };
+
+  /** Map saving datapath ID / per-traffic rules. */
+  typedef std::map<uint64_t, DatapathRules> RulesMap_t;
+  RulesMap_t        m_rules;              //!< Per-traffic rules.
+  uint32_t          m_tableCapacity;      //!< Per-traffic rules per table.
+  EvictionPolicy    m_evictionPolicy;     //!< Eviction policy.
+  uint64_t          m_nextCookie;         //!< Next rule cookie.
+
+  /** Map saving rule cookie / <datapath ID, rule key>. */
+  typedef std::map<uint64_t, std::pair<uint64_t, std::string>> CookieMap_t;
+  CookieMap_t       m_ruleCookies;        //!< Rules by cookie.
+
+  /** Trace source fired when a rule is installed in a full flow table. */
+  TracedCallback<uint64_t, uint8_t> m_tableFullTrace;
+
+  /** Trace source fired when a packet misses an evicted rule. */
+  TracedCallback<uint64_t, uint16_t> m_evictionMissTrace;
 
   /** Map saving <IPv4 address / MAC address> */
   typedef std::map<Ipv4Address, Mac48Address> IpMacMap_t;
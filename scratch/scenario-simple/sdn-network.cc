@@ -27,8 +27,10 @@ NS_LOG_COMPONENT_DEFINE ("SdnNetwork");
 NS_OBJECT_ENSURE_REGISTERED (SdnNetwork);
 
 SdnNetwork::SdnNetwork ()
-  : m_controllerApp (0),
-    m_switchHelper (0)
+  : m_switchHelper (0),
+    m_serviceFlows (0),
+    m_backgroundFlows (0),
+    m_fluidModel (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -53,6 +55,13 @@ SdnNetwork::GetTypeId (void)
                    TypeId::ATTR_GET | TypeId::ATTR_CONSTRUCT,
                    UintegerValue (3),
                    MakeUintegerAccessor (&SdnNetwork::m_numNodes),
+                   MakeUintegerChecker<uint16_t> (1))
+    .AddAttribute ("NumberControllers",
+                   "Number of controller shards, each one owning the "
+                   "switches of some network nodes.",
+                   TypeId::ATTR_GET | TypeId::ATTR_CONSTRUCT,
+                   UintegerValue (1),
+                   MakeUintegerAccessor (&SdnNetwork::m_numControllers),
                    MakeUintegerChecker<uint16_t> (1));
   return tid;
 }
@@ -62,9 +71,22 @@ SdnNetwork::DoDispose ()
 {
   NS_LOG_FUNCTION (this);
 
+  m_fluidModel->Dispose ();
+  m_fluidModel = 0;
+  m_registry->Dispose ();
+  m_registry = 0;
+  m_controllerApps.clear ();
   Object::DoDispose ();
 }
 
+Ptr<FluidModel>
+SdnNetwork::GetFluidModel (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  return m_fluidModel;
+}
+
 uint32_t
 SdnNetwork::GetNetworkSwitchDpId (uint32_t nodeId) const
 {
@@ -89,6 +111,47 @@ SdnNetwork::GetNetworkPortNo (uint32_t srcNodeId, uint32_t dstNodeId) const
   return m_networkToNetworkPorts[srcNodeId][dstNodeId]->GetPortNo ();
 }
 
+Ptr<PipelineModel>
+SdnNetwork::GetPipelineModel (uint64_t dpId) const
+{
+  NS_LOG_FUNCTION (this << dpId);
+
+  for (uint32_t i = 0; i < m_networkSwitchDevs.GetN (); i++)
+    {
+      if (m_networkSwitchDevs.Get (i)->GetDatapathId () == dpId)
+        {
+          return m_networkSwitchDevs.Get (i)->GetObject<PipelineModel> ();
+        }
+    }
+  return 0;
+}
+
+uint16_t
+SdnNetwork::GetShardId (uint64_t dpId) const
+{
+  NS_LOG_FUNCTION (this << dpId);
+
+  auto it = m_datapathShards.find (dpId);
+  NS_ASSERT_MSG (it != m_datapathShards.end (), "Unknown datapath " << dpId);
+  return it->second;
+}
+
+Ptr<SdnController>
+SdnNetwork::GetController (uint16_t shardId) const
+{
+  NS_LOG_FUNCTION (this << shardId);
+
+  return m_controllerApps.at (shardId);
+}
+
+Ptr<SharedRegistry>
+SdnNetwork::GetRegistry (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  return m_registry;
+}
+
 void
 SdnNetwork::EnablePcap (bool enable)
 {
@@ -109,13 +172,20 @@ SdnNetwork::NotifyConstructionCompleted (void)
 
   // Create and configure the helpers.
   m_switchHelper = CreateObject<OFSwitch13InternalHelper> ();
+  m_fluidModel = CreateObject<FluidModel> ();
+  m_registry = CreateObject<SharedRegistry> ();
+  m_registry->SetReplicas (m_numControllers);
   m_csmaHelper.SetDeviceAttribute ("Mtu", UintegerValue (1492));
 
   // Configure network topology and VNFs (respect this order!).
   ConfigureTopology ();
   ConfigureFunctions ();
+  for (auto const &controllerApp : m_controllerApps)
+    {
+      controllerApp->NotifyTopologyBuilt ();
+    }
 
-  // Let's connect the OpenFlow switches to the controller. From this point
+  // Let's connect the OpenFlow switches to the controllers. From this point
   // on it is not possible to change the OpenFlow network configuration.
   m_switchHelper->CreateOpenFlowChannels ();
 
@@ -128,11 +198,24 @@ SdnNetwork::ConfigureTopology (void)
   NS_LOG_FUNCTION (this);
 
   // ---------------------------------------------------------------------------
-  // Create the SDN controller.
-  Ptr<Node> controllerNode = CreateObject<Node> ();
-  Names::Add ("ctrl", controllerNode);
-  m_controllerApp = CreateObject<SdnController> (Ptr<SdnNetwork> (this));
-  m_switchHelper->InstallController (controllerNode, m_controllerApp);
+  // Create the SDN controllers, one for each shard. All controllers connect
+  // to all switches, but each switch is managed by the controller of its
+  // shard only.
+  for (uint16_t s = 0; s < m_numControllers; s++)
+    {
+      std::ostringstream name;
+      name << "ctrl";
+      if (s)
+        {
+          name << s;
+        }
+      Ptr<Node> controllerNode = CreateObject<Node> ();
+      Names::Add (name.str (), controllerNode);
+      Ptr<SdnController> controllerApp =
+        CreateObject<SdnController> (Ptr<SdnNetwork> (this), s);
+      m_switchHelper->InstallController (controllerNode, controllerApp);
+      m_controllerApps.push_back (controllerApp);
+    }
 
   // ---------------------------------------------------------------------------
   // Create the network (core and edge switch) nodes.
@@ -143,9 +226,19 @@ SdnNetwork::ConfigureTopology (void)
       name << "node" << i;
       Names::Add (name.str (), m_networkNodes.Get (i));
     }
-  m_switchHelper->SetDeviceAttribute ("TcamDelay", TimeValue (MicroSeconds (20)));
   m_networkSwitchDevs = m_switchHelper->InstallSwitch (m_networkNodes);
 
+  // The pipeline delay of the network switches depends on the tables visited
+  // and their occupancy, and is updated along with the flow statistics.
+  for (uint32_t i = 0; i < m_numNodes; i++)
+    {
+      Ptr<OFSwitch13Device> device = m_networkSwitchDevs.Get (i);
+      Ptr<PipelineModel> pipeline = CreateObject<PipelineModel> ();
+      device->AggregateObject (pipeline);
+      device->SetAttribute ("TcamDelay", TimeValue (
+                              pipeline->GetTableDelay (0)));
+    }
+
   // ---------------------------------------------------------------------------
   // Connect network switches in full topology.
   // FIXME: Initial DataRate and delay for network connections.
@@ -157,10 +250,12 @@ SdnNetwork::ConfigureTopology (void)
     {
       m_networkToNetworkPorts.push_back (PortVector_t ());
       m_networkToNetworkChannels.push_back (ChannelVector_t ());
+      m_networkToNetworkFluidLinks.push_back (std::vector<uint32_t> ());
       for (uint32_t j = 0; j < m_numNodes; j++)
         {
           m_networkToNetworkPorts.at (i).push_back (0);
           m_networkToNetworkChannels.at (i).push_back (0);
+          m_networkToNetworkFluidLinks.at (i).push_back (0);
         }
     }
 
@@ -180,6 +275,10 @@ SdnNetwork::ConfigureTopology (void)
                 DynamicCast<CsmaNetDevice> (csmaDevices.Get (0))->GetChannel ());
               m_networkToNetworkChannels[i][j] = csmaChannel;
               m_networkToNetworkChannels[j][i] = csmaChannel;
+
+              // Full-duplex channel: one fluid link for each direction.
+              m_networkToNetworkFluidLinks[i][j] = m_fluidModel->AddLink (csmaChannel->GetDataRate ());
+              m_networkToNetworkFluidLinks[j][i] = m_fluidModel->AddLink (csmaChannel->GetDataRate ());
             }
         }
     }
@@ -196,6 +295,14 @@ SdnNetwork::ConfigureTopology (void)
   m_switchHelper->SetDeviceAttribute ("TcamDelay", TimeValue (MicroSeconds (0)));
   m_serverSwitchDevs = m_switchHelper->InstallSwitch (m_serverNodes);
 
+  // The switches of each node belong to the shard of that node.
+  for (uint32_t i = 0; i < m_numNodes; i++)
+    {
+      uint16_t shardId = i % m_numControllers;
+      m_datapathShards [GetNetworkSwitchDpId (i)] = shardId;
+      m_datapathShards [GetServerSwitchDpId (i)] = shardId;
+    }
+
   // ---------------------------------------------------------------------------
   // Connect each server to its network switch (only downlink connection here).
   // Maximum datarate and zero delay for these links.
@@ -247,7 +354,7 @@ SdnNetwork::ConfigureTopology (void)
   // Notify the controller about the host nodes.
   for (uint32_t i = 0; i < m_numNodes; i++)
     {
-      m_controllerApp->NotifyHostAttach (
+      GetNodeController (i)->NotifyHostAttach (
         m_networkSwitchDevs.Get (i), m_networkToHostPorts.at (i)->GetPortNo (), m_hostDevices.Get (i));
     }
 }
@@ -273,10 +380,12 @@ SdnNetwork::ConfigureFunctions (void)
     {
       m_networkToVnfUlinkPorts.push_back (PortVector_t ());
       m_networkToVnfUlinkChannels.push_back (ChannelVector_t ());
+      m_networkToVnfFluidLinks.push_back (std::vector<uint32_t> ());
       for (uint16_t v = 0; v < m_numVnfs; v++)
         {
           m_networkToVnfUlinkPorts.at (n).push_back (0);
           m_networkToVnfUlinkChannels.at (n).push_back (0);
+          m_networkToVnfFluidLinks.at (n).push_back (0);
         }
     }
 
@@ -301,6 +410,8 @@ SdnNetwork::ConfigureFunctions (void)
           m_portDevices.Add (csmaDevices);
           m_networkToVnfUlinkChannels[n][v] = DynamicCast<CsmaChannel> (
             DynamicCast<CsmaNetDevice> (csmaDevices.Get (0))->GetChannel ());
+          m_networkToVnfFluidLinks[n][v] = m_fluidModel->AddLink (
+            m_networkToVnfUlinkChannels[n][v]->GetDataRate ());
 
           // Create the pair of applications for this VNF.
           Ptr<VnfApp> vnfApp1, vnfApp2;
@@ -312,6 +423,11 @@ SdnNetwork::ConfigureFunctions (void)
           Ptr<OFSwitch13Port> logicalPort1 = networkSwitchDevice->AddSwitchPort (virtualDevice1);
           vnfApp1->SetVirtualDevice (virtualDevice1);
           networkNode->AddApplication (vnfApp1);
+          for (auto const &controllerApp : m_controllerApps)
+            {
+              vnfApp1->TraceConnectWithoutContext (
+                "Rx", MakeCallback (&SdnController::NotifyVnfRx, controllerApp));
+            }
 
           // Install the second application on the server node.
           Ptr<VirtualNetDevice> virtualDevice2 = CreateObject<VirtualNetDevice> ();
@@ -321,7 +437,7 @@ SdnNetwork::ConfigureFunctions (void)
           serverNode->AddApplication (vnfApp2);
 
           // Notify the controller about this VNF copy.
-          m_controllerApp->NotifyVnfAttach (
+          GetNodeController (n)->NotifyVnfAttach (
             networkSwitchDevice, logicalPort1->GetPortNo (),
             serverSwitchDevice, logicalPort2->GetPortNo (),
             m_networkToVnfUlinkPorts[n][v]->GetPortNo (),
@@ -338,14 +454,46 @@ SdnNetwork::NewServiceTraffic (
 {
   NS_LOG_FUNCTION (this << srcHostId << dstHostId << startTime << stopTime);
 
-  static uint16_t serviceFlowCounter = 0;
+  Ptr<SourceApp> sourceApp = CreateServiceTraffic (
+    srcHostId, dstHostId, vnfList, startTime, stopTime);
+  if (!pktSizeDesc.empty ())
+    {
+      sourceApp->SetAttribute ("PktSize", StringValue (pktSizeDesc));
+    }
+  if (!pktIntervalDesc.empty ())
+    {
+      sourceApp->SetAttribute ("PktInterval", StringValue (pktIntervalDesc));
+    }
+}
+
+void
+SdnNetwork::NewServiceTraffic (
+  uint32_t srcHostId, uint32_t dstHostId,
+  std::vector<uint8_t> vnfList, Time startTime, Time stopTime,
+  std::string traceFile, uint32_t traceFlowId)
+{
+  NS_LOG_FUNCTION (this << srcHostId << dstHostId << startTime << stopTime <<
+                   traceFile << traceFlowId);
+
+  Ptr<SourceApp> sourceApp = CreateServiceTraffic (
+    srcHostId, dstHostId, vnfList, startTime, stopTime);
+  sourceApp->SetAttribute ("TraceFile", StringValue (traceFile));
+  sourceApp->SetAttribute ("TraceFlowId", UintegerValue (traceFlowId));
+}
+
+void
+SdnNetwork::NewBackgroundTraffic (
+  uint32_t srcHostId, uint32_t dstHostId, Time startTime, Time stopTime,
+  std::string pktSizeDesc, std::string pktIntervalDesc)
+{
+  NS_LOG_FUNCTION (this << srcHostId << dstHostId << startTime << stopTime);
 
   // Increase the flow counter
-  serviceFlowCounter++;
+  m_backgroundFlows++;
 
   // Define UDP port numbers (which are used as flow IDs)
-  uint16_t srcPortNo = 10000 + serviceFlowCounter;
-  uint16_t dstPortNo = 20000 + serviceFlowCounter;
+  uint16_t srcPortNo = 30000 + m_backgroundFlows;
+  uint16_t dstPortNo = 40000 + m_backgroundFlows;
 
   // Create the source application
   Ptr<SourceApp> sourceApp = CreateObjectWithAttributes<SourceApp> (
@@ -353,7 +501,6 @@ SdnNetwork::NewServiceTraffic (
     "LocalUdpPort",   UintegerValue (srcPortNo),
     "FinalIpAddress", Ipv4AddressValue (m_hostIfaces.GetAddress (dstHostId)),
     "FinalUdpPort",   UintegerValue (dstPortNo));
-  sourceApp->SetVnfList (vnfList);
   sourceApp->SetStartTime (startTime);
   sourceApp->SetStopTime (stopTime);
   if (!pktSizeDesc.empty ())
@@ -374,27 +521,61 @@ SdnNetwork::NewServiceTraffic (
   m_hostNodes.Get (dstHostId)->AddApplication (sinkApp);
 
   // Notify the controller about this new traffic
-  m_controllerApp->NotifyNewServiceTraffic (
+  GetNodeController (srcHostId)->NotifyNewBackgroundTraffic (
     InetSocketAddress (m_hostIfaces.GetAddress (srcHostId), srcPortNo),
     InetSocketAddress (m_hostIfaces.GetAddress (dstHostId), dstPortNo),
-    srcHostId, dstHostId, vnfList, startTime, stopTime);
+    srcHostId, dstHostId, startTime, stopTime);
 }
 
 void
-SdnNetwork::NewBackgroundTraffic (
+SdnNetwork::NewFluidServiceTraffic (
+  uint32_t srcHostId, uint32_t dstHostId,
+  std::vector<uint8_t> vnfList, Time startTime, Time stopTime,
+  DataRate rate)
+{
+  NS_LOG_FUNCTION (this << srcHostId << dstHostId << startTime << stopTime << rate);
+
+  // Increase the flow counter. Fluid flows use the same flow IDs as the
+  // packet-level flows, but no sockets are created for them.
+  m_serviceFlows++;
+  uint16_t srcPortNo = 10000 + m_serviceFlows;
+
+  // Notify the controller about this new traffic
+  GetNodeController (srcHostId)->NotifyNewFluidTraffic (
+    srcPortNo, srcHostId, dstHostId, vnfList, rate, startTime, stopTime);
+}
+
+void
+SdnNetwork::NewFluidBackgroundTraffic (
   uint32_t srcHostId, uint32_t dstHostId, Time startTime, Time stopTime,
-  std::string pktSizeDesc, std::string pktIntervalDesc)
+  DataRate rate)
 {
-  NS_LOG_FUNCTION (this << srcHostId << dstHostId << startTime << stopTime);
+  NS_LOG_FUNCTION (this << srcHostId << dstHostId << startTime << stopTime << rate);
+
+  // Increase the flow counter. Fluid flows use the same flow IDs as the
+  // packet-level flows, but no sockets are created for them.
+  m_backgroundFlows++;
+  uint16_t srcPortNo = 30000 + m_backgroundFlows;
+
+  // Notify the controller about this new traffic
+  GetNodeController (srcHostId)->NotifyNewFluidTraffic (
+    srcPortNo, srcHostId, dstHostId, std::vector<uint8_t> (), rate,
+    startTime, stopTime);
+}
 
-  static uint16_t backgroundFlowCounter = 0;
+Ptr<SourceApp>
+SdnNetwork::CreateServiceTraffic (
+  uint32_t srcHostId, uint32_t dstHostId,
+  std::vector<uint8_t> vnfList, Time startTime, Time stopTime)
+{
+  NS_LOG_FUNCTION (this << srcHostId << dstHostId << startTime << stopTime);
 
   // Increase the flow counter
-  backgroundFlowCounter++;
+  m_serviceFlows++;
 
   // Define UDP port numbers (which are used as flow IDs)
-  uint16_t srcPortNo = 30000 + backgroundFlowCounter;
-  uint16_t dstPortNo = 40000 + backgroundFlowCounter;
+  uint16_t srcPortNo = 10000 + m_serviceFlows;
+  uint16_t dstPortNo = 20000 + m_serviceFlows;
 
   // Create the source application
   Ptr<SourceApp> sourceApp = CreateObjectWithAttributes<SourceApp> (
@@ -402,16 +583,9 @@ SdnNetwork::NewBackgroundTraffic (
     "LocalUdpPort",   UintegerValue (srcPortNo),
     "FinalIpAddress", Ipv4AddressValue (m_hostIfaces.GetAddress (dstHostId)),
     "FinalUdpPort",   UintegerValue (dstPortNo));
+  sourceApp->SetVnfList (vnfList);
   sourceApp->SetStartTime (startTime);
   sourceApp->SetStopTime (stopTime);
-  if (!pktSizeDesc.empty ())
-    {
-      sourceApp->SetAttribute ("PktSize", StringValue (pktSizeDesc));
-    }
-  if (!pktIntervalDesc.empty ())
-    {
-      sourceApp->SetAttribute ("PktInterval", StringValue (pktIntervalDesc));
-    }
   m_hostNodes.Get (srcHostId)->AddApplication (sourceApp);
 
   // Create the sink application
@@ -422,10 +596,20 @@ SdnNetwork::NewBackgroundTraffic (
   m_hostNodes.Get (dstHostId)->AddApplication (sinkApp);
 
   // Notify the controller about this new traffic
-  m_controllerApp->NotifyNewBackgroundTraffic (
+  GetNodeController (srcHostId)->NotifyNewServiceTraffic (
     InetSocketAddress (m_hostIfaces.GetAddress (srcHostId), srcPortNo),
     InetSocketAddress (m_hostIfaces.GetAddress (dstHostId), dstPortNo),
-    srcHostId, dstHostId, startTime, stopTime);
+    srcHostId, dstHostId, vnfList, startTime, stopTime);
+
+  return sourceApp;
+}
+
+Ptr<SdnController>
+SdnNetwork::GetNodeController (uint32_t nodeId) const
+{
+  NS_LOG_FUNCTION (this << nodeId);
+
+  return m_controllerApps.at (nodeId % m_numControllers);
 }
 
 } // namespace ns3
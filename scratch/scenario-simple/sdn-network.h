@@ -19,9 +19,14 @@
 
 #include <ns3/ofswitch13-module.h>
 #include "sdn-controller.h"
+#include "fluid-model.h"
+#include "pipeline-model.h"
+#include "shared-registry.h"
+#include "trace-reader.h"
 
 namespace ns3 {
 
+class SourceApp;
 class VnfApp;
 class VnfInfo;
 
@@ -61,6 +66,22 @@ public:
     std::vector<uint8_t> vnfList, Time startTime, Time stopTime,
     std::string pktSizeDesc = "", std::string pktIntervalDesc = "");
 
+  /**
+   * Create a new SFC traffic flow in the network, replaying the packet sizes
+   * and timings from a trace file.
+   * \param srcHostId The source host node ID.
+   * \param dstHostId The destination host node ID.
+   * \param vnfList The list of VNF IDs for this traffic.
+   * \param startTime The application start time.
+   * \param stopTime The application stop time.
+   * \param traceFile The packet trace file name.
+   * \param traceFlowId The flow ID to replay from the packet trace file.
+   */
+  void NewServiceTraffic (
+    uint32_t srcHostId, uint32_t dstHostId,
+    std::vector<uint8_t> vnfList, Time startTime, Time stopTime,
+    std::string traceFile, uint32_t traceFlowId);
+
   /**
    * Create a new background traffic flow in the network.
    * \param srcHostId The source host node ID.
@@ -74,6 +95,42 @@ public:
     uint32_t srcHostId, uint32_t dstHostId, Time startTime, Time stopTime,
     std::string pktSizeDesc = "", std::string pktIntervalDesc = "");
 
+  /**
+   * Create a new SFC traffic flow in the network using the fluid model. No
+   * packets are sent for this traffic, which is only accounted for by the
+   * fluid model.
+   * \param srcHostId The source host node ID.
+   * \param dstHostId The destination host node ID.
+   * \param vnfList The list of VNF IDs for this traffic.
+   * \param startTime The flow start time.
+   * \param stopTime The flow stop time.
+   * \param rate The flow source data rate.
+   */
+  void NewFluidServiceTraffic (
+    uint32_t srcHostId, uint32_t dstHostId,
+    std::vector<uint8_t> vnfList, Time startTime, Time stopTime,
+    DataRate rate);
+
+  /**
+   * Create a new background traffic flow in the network using the fluid
+   * model. No packets are sent for this traffic, which is only accounted for
+   * by the fluid model.
+   * \param srcHostId The source host node ID.
+   * \param dstHostId The destination host node ID.
+   * \param startTime The flow start time.
+   * \param stopTime The flow stop time.
+   * \param rate The flow source data rate.
+   */
+  void NewFluidBackgroundTraffic (
+    uint32_t srcHostId, uint32_t dstHostId, Time startTime, Time stopTime,
+    DataRate rate);
+
+  /**
+   * Get the fluid model for rate-based traffic flows.
+   * \return The fluid model.
+   */
+  Ptr<FluidModel> GetFluidModel (void) const;
+
   /**
    * Get the network switch datapath ID.
    * \param serverId The network ID
@@ -96,6 +153,35 @@ public:
    */
   uint32_t GetNetworkPortNo (uint32_t srcNodeId, uint32_t dstNodeId) const;
 
+  /**
+   * Get the pipeline latency model of a switch. Only network switches have a
+   * latency model, the server switches forward packets with no delay.
+   * \param dpId The OpenFlow datapath ID.
+   * \return The pipeline model, or 0 for server switches.
+   */
+  Ptr<PipelineModel> GetPipelineModel (uint64_t dpId) const;
+
+  /**
+   * Get the controller shard owning a switch. The network switch and the
+   * server switch of each node belong to the same shard.
+   * \param dpId The OpenFlow datapath ID.
+   * \return The shard ID.
+   */
+  uint16_t GetShardId (uint64_t dpId) const;
+
+  /**
+   * Get the controller of a shard.
+   * \param shardId The shard ID.
+   * \return The controller application.
+   */
+  Ptr<SdnController> GetController (uint16_t shardId) const;
+
+  /**
+   * Get the registry shared by the controller shards.
+   * \return The shared registry.
+   */
+  Ptr<SharedRegistry> GetRegistry (void) const;
+
 protected:
   /** Destructor implementation. */
   virtual void DoDispose (void);
@@ -114,12 +200,40 @@ protected:
   void ConfigureFunctions (void);
 
 private:
-  Ptr<SdnController>            m_controllerApp;    //!< Controller app
+  /**
+   * Create the source and sink applications for a new SFC traffic flow and
+   * notify the controller about it.
+   * \param srcHostId The source host node ID.
+   * \param dstHostId The destination host node ID.
+   * \param vnfList The list of VNF IDs for this traffic.
+   * \param startTime The application start time.
+   * \param stopTime The application stop time.
+   * \return The source application, for further traffic configuration.
+   */
+  Ptr<SourceApp> CreateServiceTraffic (
+    uint32_t srcHostId, uint32_t dstHostId,
+    std::vector<uint8_t> vnfList, Time startTime, Time stopTime);
+
+
+  /**
+   * Get the controller of the shard owning a network node.
+   * \param nodeId The network node ID.
+   * \return The controller application.
+   */
+  Ptr<SdnController> GetNodeController (uint32_t nodeId) const;
+
+  std::vector<Ptr<SdnController>> m_controllerApps; //!< Controller apps
+  std::map<uint64_t, uint16_t>  m_datapathShards;   //!< Shard per datapath
+  Ptr<SharedRegistry>           m_registry;         //!< Shard registry
+  uint16_t                      m_numControllers;   //!< Number of controllers
   Ptr<OFSwitch13InternalHelper> m_switchHelper;     //!< Switch helper
   CsmaHelper                    m_csmaHelper;       //!< Connection helper
   NetDeviceContainer            m_portDevices;      //!< Switch port devices
   uint16_t                      m_numVnfs;          //!< Number of VNFs
   uint16_t                      m_numNodes;         //!< Number of nodes
+  uint16_t                      m_serviceFlows;     //!< Service flow counter
+  uint16_t                      m_backgroundFlows;  //!< Background flow counter
+  Ptr<FluidModel>               m_fluidModel;       //!< Fluid traffic model
 
   NodeContainer                 m_networkNodes;     //!< Network nodes
   NodeContainer                 m_serverNodes;      //!< Server nodes
@@ -143,6 +257,9 @@ private:
   /** Matrix of CSMA channels */
   typedef std::vector<std::vector<Ptr<CsmaChannel>>> ChannelVectorVector_t;
 
+  /** Matrix of fluid model link IDs */
+  typedef std::vector<std::vector<uint32_t>> LinkIdVectorVector_t;
+
   /**
    * Vector of ports connecting each network switches to the host nodes
    * Index: [node id]
@@ -169,6 +286,13 @@ private:
    */
   ChannelVectorVector_t m_networkToVnfUlinkChannels;
 
+  /**
+   * Matrix of fluid model links from each network switch to the server switch
+   * There is one link for each VNF
+   * Indexes: [node id][vnf id]
+   */
+  LinkIdVectorVector_t m_networkToVnfFluidLinks;
+
   /**
    * Matrix of switch ports connecting a pair of network switches
    * Indexes: [source node id][destination node id]
@@ -180,6 +304,13 @@ private:
    * Indexes: [source node id][destination node id]
    */
   ChannelVectorVector_t m_networkToNetworkChannels;
+
+  /**
+   * Matrix of fluid model links connecting a pair of network switches
+   * There is one link for each direction
+   * Indexes: [source node id][destination node id]
+   */
+  LinkIdVectorVector_t m_networkToNetworkFluidLinks;
 };
 } // namespace ns3
 #endif /* SDN_NETWORK_H */
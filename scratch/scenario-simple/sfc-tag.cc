@@ -27,6 +27,7 @@ SfcTag::SfcTag ()
     m_sourcePort (0),
     m_finalIp (0),
     m_finalPort (0),
+    m_seqNum (0),
     m_nVnfs (0),
     m_nextVnfIdx (0)
 {
@@ -36,6 +37,7 @@ SfcTag::SfcTag ()
 SfcTag::SfcTag (InetSocketAddress sourceAddr, InetSocketAddress finalAddr,
                 std::vector<uint8_t> vnfList)
   : m_timestamp (Simulator::Now ().GetTimeStep ()),
+    m_seqNum (0),
     m_nVnfs (vnfList.size ()),
     m_nextVnfIdx (0)
 {
@@ -71,7 +73,7 @@ SfcTag::GetInstanceTypeId (void) const
 uint32_t
 SfcTag::GetSerializedSize (void) const
 {
-  return 22 + m_maxVnfs;
+  return 26 + m_maxVnfs;
 }
 
 void
@@ -82,6 +84,7 @@ SfcTag::Serialize (TagBuffer i) const
   i.WriteU16 (m_sourcePort);
   i.WriteU32 (m_finalIp);
   i.WriteU16 (m_finalPort);
+  i.WriteU32 (m_seqNum);
   i.WriteU8  (m_nVnfs);
   i.WriteU8  (m_nextVnfIdx);
   i.Write    (m_listVnfs, m_maxVnfs);
@@ -95,6 +98,7 @@ SfcTag::Deserialize (TagBuffer i)
   m_sourcePort  = i.ReadU16 ();
   m_finalIp     = i.ReadU32 ();
   m_finalPort   = i.ReadU16 ();
+  m_seqNum      = i.ReadU32 ();
   m_nVnfs       = i.ReadU8 ();
   m_nextVnfIdx  = i.ReadU8 ();
   i.Read (m_listVnfs, m_maxVnfs);
@@ -108,6 +112,7 @@ SfcTag::Print (std::ostream &os) const
      << " sourcePort:" << (uint16_t) m_sourcePort
      << " finalIp:" << Ipv4Address (m_finalIp)
      << " finalPort:" << (uint16_t) m_finalPort
+     << " seqNum:" << m_seqNum
      << " numOfVnfs:" << (uint16_t) m_nVnfs
      << " nextVnfIdx:" << (uint16_t) m_nextVnfIdx
      << " vnfList:";
@@ -130,6 +135,18 @@ SfcTag::GetTrafficId (void) const
   return m_sourcePort;
 }
 
+uint32_t
+SfcTag::GetSeqNum (void) const
+{
+  return m_seqNum;
+}
+
+void
+SfcTag::SetSeqNum (uint32_t seqNum)
+{
+  m_seqNum = seqNum;
+}
+
 InetSocketAddress
 SfcTag::GetNextAddress (bool advance)
 {
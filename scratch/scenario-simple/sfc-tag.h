@@ -57,6 +57,22 @@ public:
    */
   uint16_t GetTrafficId (void) const;
 
+  /**
+   * Get the packet sequence number. The source application numbers its
+   * packets sequentially, and each VNF numbers its output packets from the
+   * number of the input packet and its scaling factor, so the sequence
+   * number identifies the packet in the current hop, whichever VNF copy
+   * handled it.
+   * \return The sequence number.
+   */
+  uint32_t GetSeqNum (void) const;
+
+  /**
+   * Set the packet sequence number.
+   * \param seqNum The sequence number.
+   */
+  void SetSeqNum (uint32_t seqNum);
+
   /**
    * Get the socket address of the next VNF application in the SFC list. In case
    * there are no more VNFs in the SFC list, this method will return the socket
@@ -75,6 +91,7 @@ private:
   uint32_t  m_finalIp;              //!< Final host IP
   uint16_t  m_finalPort;            //!< Final host port.
   uint16_t  m_trafficId;            //!< Traffic ID.
+  uint32_t  m_seqNum;               //!< Packet sequence number.
   uint8_t   m_nVnfs;                //!< Number of VNFs in the chain.
   uint8_t   m_nextVnfIdx;           //!< Next VNF ID index in the chain.
   uint8_t   m_listVnfs[m_maxVnfs];  //!< VNF ID chain.
@@ -0,0 +1,245 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "shared-registry.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("SharedRegistry");
+NS_OBJECT_ENSURE_REGISTERED (SharedRegistry);
+
+SharedRegistry::SharedRegistry ()
+  : m_updates (0),
+    m_staleReads (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+SharedRegistry::~SharedRegistry ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+SharedRegistry::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::SharedRegistry")
+    .SetParent<Object> ()
+    .AddConstructor<SharedRegistry> ()
+    .AddAttribute ("PropagationDelay",
+                   "The time for an entry written by a shard to reach the "
+                   "replicas of the other shards.",
+                   TimeValue (MilliSeconds (5)),
+                   MakeTimeAccessor (&SharedRegistry::m_delay),
+                   MakeTimeChecker (Time (0)))
+    .AddTraceSource ("Update", "Entry sent to another replica.",
+                     MakeTraceSourceAccessor (&SharedRegistry::m_updateTrace),
+                     "ns3::SharedRegistry::UpdateTracedCallback")
+  ;
+  return tid;
+}
+
+void
+SharedRegistry::SetReplicas (uint16_t replicas)
+{
+  NS_LOG_FUNCTION (this << replicas);
+
+  NS_ASSERT_MSG (m_replicas.empty (), "Replicas already set.");
+  m_replicas.resize (replicas);
+  m_arpCallbacks.resize (replicas);
+  m_engines.resize (replicas);
+}
+
+void
+SharedRegistry::SetArpEntry (uint16_t replica, Ipv4Address ipAddr,
+                             Mac48Address macAddr)
+{
+  NS_LOG_FUNCTION (this << replica << ipAddr << macAddr);
+
+  // Rewriting an entry the shard already knows costs no update.
+  auto it = m_replicas.at (replica).find (ipAddr);
+  if (it != m_replicas.at (replica).end () && it->second == macAddr)
+    {
+      return;
+    }
+
+  ApplyArpEntry (replica, ipAddr, macAddr);
+  for (uint16_t r = 0; r < m_replicas.size (); r++)
+    {
+      if (r != replica)
+        {
+          m_updates++;
+          m_updateTrace (replica, r);
+          Simulator::Schedule (m_delay, &SharedRegistry::ApplyArpEntry,
+                               this, r, ipAddr, macAddr);
+        }
+    }
+}
+
+bool
+SharedRegistry::GetArpEntry (uint16_t replica, Ipv4Address ipAddr,
+                             Mac48Address &macAddr)
+{
+  NS_LOG_FUNCTION (this << replica << ipAddr);
+
+  auto it = m_replicas.at (replica).find (ipAddr);
+  if (it != m_replicas.at (replica).end ())
+    {
+      macAddr = it->second;
+      return true;
+    }
+
+  // The read is stale when another replica already has the entry.
+  if (HasArpEntry (ipAddr))
+    {
+      NS_LOG_INFO ("Stale read of " << ipAddr << " in replica " << replica);
+      m_staleReads++;
+    }
+  return false;
+}
+
+bool
+SharedRegistry::HasArpEntry (Ipv4Address ipAddr) const
+{
+  NS_LOG_FUNCTION (this << ipAddr);
+
+  for (auto const &replica : m_replicas)
+    {
+      if (replica.find (ipAddr) != replica.end ())
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+SharedRegistry::SetArpEntryCallback (uint16_t replica, ArpEntryCallback callback)
+{
+  NS_LOG_FUNCTION (this << replica);
+
+  m_arpCallbacks.at (replica) = callback;
+}
+
+void
+SharedRegistry::SetPlacementEngine (uint16_t replica, Ptr<PlacementEngine> engine)
+{
+  NS_LOG_FUNCTION (this << replica << engine);
+
+  m_engines.at (replica) = engine;
+}
+
+std::vector<uint32_t>
+SharedRegistry::Place (uint16_t replica, uint16_t trafficId,
+                       uint32_t srcHostId, uint32_t dstHostId,
+                       std::vector<uint8_t> vnfList, DataRate rate)
+{
+  NS_LOG_FUNCTION (this << replica << trafficId << srcHostId << dstHostId << rate);
+
+  std::vector<uint32_t> serverList = m_engines.at (replica)->Place (
+    trafficId, srcHostId, dstHostId, vnfList, rate);
+  for (uint16_t r = 0; r < m_engines.size (); r++)
+    {
+      if (r != replica)
+        {
+          m_updates++;
+          m_updateTrace (replica, r);
+          Simulator::Schedule (m_delay, &PlacementEngine::Commit, m_engines.at (r),
+                               trafficId, srcHostId, dstHostId, vnfList, rate,
+                               serverList);
+        }
+    }
+  return serverList;
+}
+
+void
+SharedRegistry::UpdatePlacement (uint16_t replica, uint16_t trafficId,
+                                 std::vector<uint32_t> serverList)
+{
+  NS_LOG_FUNCTION (this << replica << trafficId);
+
+  m_engines.at (replica)->Update (trafficId, serverList);
+  for (uint16_t r = 0; r < m_engines.size (); r++)
+    {
+      if (r != replica)
+        {
+          m_updates++;
+          m_updateTrace (replica, r);
+          Simulator::Schedule (m_delay, &PlacementEngine::Update, m_engines.at (r),
+                               trafficId, serverList);
+        }
+    }
+}
+
+void
+SharedRegistry::ReleasePlacement (uint16_t replica, uint16_t trafficId)
+{
+  NS_LOG_FUNCTION (this << replica << trafficId);
+
+  m_engines.at (replica)->Release (trafficId);
+  for (uint16_t r = 0; r < m_engines.size (); r++)
+    {
+      if (r != replica)
+        {
+          m_updates++;
+          m_updateTrace (replica, r);
+          Simulator::Schedule (m_delay, &PlacementEngine::Release, m_engines.at (r),
+                               trafficId);
+        }
+    }
+}
+
+uint64_t
+SharedRegistry::GetUpdates (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  return m_updates;
+}
+
+uint64_t
+SharedRegistry::GetStaleReads (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  return m_staleReads;
+}
+
+void
+SharedRegistry::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+
+  m_replicas.clear ();
+  m_arpCallbacks.clear ();
+  m_engines.clear ();
+  Object::DoDispose ();
+}
+
+void
+SharedRegistry::ApplyArpEntry (uint16_t replica, Ipv4Address ipAddr,
+                               Mac48Address macAddr)
+{
+  NS_LOG_FUNCTION (this << replica << ipAddr << macAddr);
+
+  m_replicas.at (replica) [ipAddr] = macAddr;
+  if (!m_arpCallbacks.at (replica).IsNull ())
+    {
+      m_arpCallbacks.at (replica) (ipAddr, macAddr);
+    }
+}
+
+} // namespace ns3
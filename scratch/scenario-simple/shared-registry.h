@@ -0,0 +1,171 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SHARED_REGISTRY_H
+#define SHARED_REGISTRY_H
+
+#include <ns3/core-module.h>
+#include <ns3/network-module.h>
+#include "placement-engine.h"
+
+namespace ns3 {
+
+/**
+ * Registry shared by the controller shards, holding the MAC address of the
+ * hosts and VNFs and the load state of the VNF placement. Each shard has its
+ * own replica, with its own placement engine. The entries and placements
+ * written by a shard are applied to its replica right away, and reach the
+ * replicas of the other shards after the propagation delay, so a shard may
+ * miss an entry or a load already known by another one.
+ */
+class SharedRegistry : public Object
+{
+public:
+  SharedRegistry ();            //!< Default constructor.
+  virtual ~SharedRegistry ();   //!< Dummy destructor, see DoDispose.
+
+  /**
+   * Register this type.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * Set the number of replicas, one for each controller shard.
+   * \param replicas The number of replicas.
+   */
+  void SetReplicas (uint16_t replicas);
+
+  /**
+   * Write an ARP entry from a shard.
+   * \param replica The replica of the writing shard.
+   * \param ipAddr The IPv4 address.
+   * \param macAddr The MAC address.
+   */
+  void SetArpEntry (uint16_t replica, Ipv4Address ipAddr, Mac48Address macAddr);
+
+  /**
+   * Read an ARP entry from the replica of a shard.
+   * \param replica The replica of the reading shard.
+   * \param ipAddr The IPv4 address.
+   * \param macAddr The MAC address, when found.
+   * \return True if the entry was found in the replica.
+   */
+  bool GetArpEntry (uint16_t replica, Ipv4Address ipAddr, Mac48Address &macAddr);
+
+  /**
+   * Check for an ARP entry in any replica, including the entries not yet
+   * replicated to all shards.
+   * \param ipAddr The IPv4 address.
+   * \return True if some replica has the entry.
+   */
+  bool HasArpEntry (Ipv4Address ipAddr) const;
+
+  /** Callback signature for ARP entries applied to a replica. */
+  typedef Callback<void, Ipv4Address, Mac48Address> ArpEntryCallback;
+
+  /**
+   * Set the callback invoked when an ARP entry is applied to a replica.
+   * \param replica The replica.
+   * \param callback The callback.
+   */
+  void SetArpEntryCallback (uint16_t replica, ArpEntryCallback callback);
+
+  /**
+   * Set the placement engine of a replica.
+   * \param replica The replica.
+   * \param engine The placement engine.
+   */
+  void SetPlacementEngine (uint16_t replica, Ptr<PlacementEngine> engine);
+
+  /**
+   * Place a new traffic with the engine of a shard, and commit the placement
+   * to the engines of the other shards.
+   * \param replica The replica of the placing shard.
+   * \param trafficId The traffic ID.
+   * \param srcHostId The source host node ID.
+   * \param dstHostId The destination host node ID.
+   * \param vnfList The list of VNF IDs for this traffic (may be empty).
+   * \param rate The estimated source data rate.
+   * \return The server ID for each VNF in the chain.
+   */
+  std::vector<uint32_t> Place (uint16_t replica, uint16_t trafficId,
+                               uint32_t srcHostId, uint32_t dstHostId,
+                               std::vector<uint8_t> vnfList, DataRate rate);
+
+  /**
+   * Change the placement of an existing traffic in all replicas.
+   * \param replica The replica of the writing shard.
+   * \param trafficId The traffic ID.
+   * \param serverList The new server ID for each VNF in the chain.
+   */
+  void UpdatePlacement (uint16_t replica, uint16_t trafficId,
+                        std::vector<uint32_t> serverList);
+
+  /**
+   * Remove the load of a traffic from all replicas.
+   * \param replica The replica of the writing shard.
+   * \param trafficId The traffic ID.
+   */
+  void ReleasePlacement (uint16_t replica, uint16_t trafficId);
+
+  /**
+   * \name Replication counters accessors.
+   * \return The number of entries and placements sent to other replicas, or
+   *         the number of reads missing an entry not yet replicated.
+   */
+  //\{
+  uint64_t GetUpdates     (void) const;
+  uint64_t GetStaleReads  (void) const;
+  //\}
+
+  /**
+   * TracedCallback signature for entries sent to other replicas.
+   * \param srcReplica The replica of the writing shard.
+   * \param dstReplica The replica receiving the entry.
+   */
+  typedef void (*UpdateTracedCallback)(uint16_t srcReplica, uint16_t dstReplica);
+
+protected:
+  /** Destructor implementation. */
+  virtual void DoDispose ();
+
+private:
+  /**
+   * Apply an ARP entry to a replica.
+   * \param replica The replica.
+   * \param ipAddr The IPv4 address.
+   * \param macAddr The MAC address.
+   */
+  void ApplyArpEntry (uint16_t replica, Ipv4Address ipAddr, Mac48Address macAddr);
+
+  /** Map saving <IPv4 address / MAC address> */
+  typedef std::map<Ipv4Address, Mac48Address> IpMacMap_t;
+
+  std::vector<IpMacMap_t> m_replicas;   //!< ARP table replicas.
+  std::vector<ArpEntryCallback> m_arpCallbacks; //!< ARP entry callbacks.
+  std::vector<Ptr<PlacementEngine>> m_engines;  //!< Placement engines.
+  Time                    m_delay;      //!< Propagation delay.
+  uint64_t                m_updates;    //!< Entries sent to other replicas.
+  uint64_t                m_staleReads; //!< Reads missing an entry.
+
+  /** Trace source fired when an entry or placement is sent to another
+   *  replica. */
+  TracedCallback<uint16_t, uint16_t> m_updateTrace;
+};
+
+} // namespace ns3
+#endif /* SHARED_REGISTRY_H */
@@ -25,7 +25,9 @@ NS_OBJECT_ENSURE_REGISTERED (SourceApp);
 
 SourceApp::SourceApp ()
   : m_socket (0),
-    m_sendEvent (EventId ())
+    m_sendEvent (EventId ()),
+    m_seqNum (0),
+    m_traceReader (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -75,6 +77,18 @@ SourceApp::GetTypeId (void)
                    MakePointerAccessor (&SourceApp::m_pktSizeRng),
                    MakePointerChecker <RandomVariableStream> ())
 
+    // When a trace file is set, the random variables above are ignored.
+    .AddAttribute ("TraceFile",
+                   "The packet trace file to replay (empty to disable).",
+                   StringValue (""),
+                   MakeStringAccessor (&SourceApp::m_traceFile),
+                   MakeStringChecker ())
+    .AddAttribute ("TraceFlowId",
+                   "The flow ID to replay from the packet trace file.",
+                   UintegerValue (TraceReader::AnyFlow),
+                   MakeUintegerAccessor (&SourceApp::m_traceFlowId),
+                   MakeUintegerChecker<uint32_t> ())
+
     // Trace sources for start and stop events
     .AddTraceSource ("AppStart", "Application start trace source.",
                      MakeTraceSourceAccessor (&SourceApp::m_appStartTrace),
@@ -100,6 +114,7 @@ SourceApp::DoDispose (void)
   NS_LOG_FUNCTION (this);
 
   m_socket = 0;
+  m_traceReader = 0;
   Application::DoDispose ();
 }
 
@@ -114,11 +129,17 @@ SourceApp::StartApplication (void)
   m_socket->Bind (InetSocketAddress (m_localIpAddress, m_localUdpPort));
   m_socket->SetRecvCallback (MakeNullCallback<void, Ptr<Socket>> ());
 
+  // Open the packet trace file, if any.
+  if (!m_traceFile.empty ())
+    {
+      NS_LOG_INFO ("Replaying packet trace " << m_traceFile);
+      m_traceReader = CreateObject<TraceReader> (m_traceFile);
+      m_traceLastTime = Time (0);
+    }
+
   // Schedule the first packet transmission.
   m_sendEvent.Cancel ();
-  Time sendTime = Seconds (std::abs (m_pktInterRng->GetValue ()));
-  uint32_t newSize = m_pktSizeRng->GetInteger ();
-  m_sendEvent = Simulator::Schedule (sendTime, &SourceApp::SendPacket, this, newSize);
+  ScheduleNextPacket ();
 
   // Fire trace source
   m_appStartTrace (this);
@@ -139,6 +160,12 @@ SourceApp::StopApplication ()
       m_socket = 0;
     }
 
+  if (m_traceReader != 0)
+    {
+      m_traceReader->Dispose ();
+      m_traceReader = 0;
+    }
+
   // Fire trace source
   m_appStopTrace (this);
 }
@@ -154,6 +181,7 @@ SourceApp::SendPacket (uint32_t size)
   InetSocketAddress sourceAddress (m_localIpAddress, m_localUdpPort);
   InetSocketAddress finalAddress (m_finalIpAddress, m_finalUdpPort);
   SfcTag sfcTag (sourceAddress, finalAddress, m_vnfList);
+  sfcTag.SetSeqNum (m_seqNum++);
   InetSocketAddress nextAddress (sfcTag.GetNextAddress ());
   packet->AddPacketTag (sfcTag);
 
@@ -168,9 +196,33 @@ SourceApp::SendPacket (uint32_t size)
     }
 
   // Schedule the next packet transmission.
-  Time sendTime = Seconds (std::abs (m_pktInterRng->GetValue ()));
-  uint32_t newSize = m_pktSizeRng->GetInteger ();
-  m_sendEvent = Simulator::Schedule (sendTime, &SourceApp::SendPacket, this, newSize);
+  ScheduleNextPacket ();
+}
+
+void
+SourceApp::ScheduleNextPacket (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_traceReader == 0)
+    {
+      Time sendTime = Seconds (std::abs (m_pktInterRng->GetValue ()));
+      uint32_t newSize = m_pktSizeRng->GetInteger ();
+      m_sendEvent = Simulator::Schedule (sendTime, &SourceApp::SendPacket, this, newSize);
+      return;
+    }
+
+  // Trace records are relative to the application start time. Records out of
+  // order in the trace are sent right away.
+  TraceReader::Record record;
+  if (!m_traceReader->ReadNext (record, m_traceFlowId))
+    {
+      NS_LOG_INFO ("End of packet trace " << m_traceFile);
+      return;
+    }
+  Time sendTime = Max (record.time - m_traceLastTime, Time (0));
+  m_traceLastTime = Max (record.time, m_traceLastTime);
+  m_sendEvent = Simulator::Schedule (sendTime, &SourceApp::SendPacket, this, record.size);
 }
 
 } // namespace ns3
@@ -19,15 +19,17 @@
 
 #include <ns3/core-module.h>
 #include <ns3/network-module.h>
+#include "trace-reader.h"
 
 namespace ns3 {
 
 /**
  * This application implements the traffic source for a VNF chain. We can
  * configure a custom traffic pattern by ajusting the PktInterval and PktSize
- * random variables of this class. Each packet created by this application
- * carries a SFC tag with a timestamp and a list of VNFs that this packet must
- * pass through.
+ * random variables of this class, or replay the packet timings from a trace
+ * file by setting the TraceFile attribute (see TraceReader for supported
+ * formats). Each packet created by this application carries a SFC tag with a
+ * timestamp and a list of VNFs that this packet must pass through.
  */
 class SourceApp : public Application
 {
@@ -76,6 +78,12 @@ private:
    */
   void SendPacket (uint32_t size);
 
+  /**
+   * Schedule the next packet transmission, either based on the random
+   * variables or on the next record from the packet trace.
+   */
+  void ScheduleNextPacket (void);
+
   Ptr<Socket>                 m_socket;         //!< UDP socket.
   uint16_t                    m_localUdpPort;   //!< Local UDP port.
   Ipv4Address                 m_localIpAddress; //!< Local IPv4 address.
@@ -86,6 +94,12 @@ private:
   Ptr<RandomVariableStream>   m_pktInterRng;    //!< Packet inter-arrival time.
   Ptr<RandomVariableStream>   m_pktSizeRng;     //!< Packet size.
   EventId                     m_sendEvent;      //!< SendPacket event.
+  uint32_t                    m_seqNum;         //!< Next sequence number.
+
+  std::string                 m_traceFile;      //!< Packet trace file name.
+  uint32_t                    m_traceFlowId;    //!< Packet trace flow ID.
+  Ptr<TraceReader>            m_traceReader;    //!< Packet trace reader.
+  Time                        m_traceLastTime;  //!< Last packet trace time.
 };
 
 } // namespace ns3
@@ -0,0 +1,304 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "trace-reader.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TraceReader");
+NS_OBJECT_ENSURE_REGISTERED (TraceReader);
+
+// Initializing TraceReader static members.
+const uint32_t TraceReader::AnyFlow;
+const uint32_t TraceReader::BinaryMagic;
+const uint32_t TraceReader::BinaryVersion;
+const size_t TraceReader::m_windowSize;
+
+// Native binary format header and record sizes.
+#define BINARY_HEADER_SIZE 8
+#define BINARY_RECORD_SIZE 16
+
+// PCAP global and per-record header sizes.
+#define PCAP_HEADER_SIZE 24
+#define PCAP_RECORD_SIZE 16
+
+// PCAP magic numbers (microsecond and nanosecond timestamps).
+#define PCAP_MAGIC_USEC 0xa1b2c3d4
+#define PCAP_MAGIC_NSEC 0xa1b23c4d
+
+TraceReader::TraceReader (std::string fileName)
+  : m_fileName (fileName),
+    m_fd (-1),
+    m_data (0),
+    m_length (0),
+    m_start (0),
+    m_cursor (0),
+    m_windowStart (0),
+    m_format (BINARY),
+    m_swapped (false),
+    m_nanosecs (false),
+    m_linkType (0),
+    m_firstTs (-1)
+{
+  NS_LOG_FUNCTION (this << fileName);
+
+  m_fd = open (fileName.c_str (), O_RDONLY);
+  NS_ABORT_MSG_IF (m_fd < 0, "Can't open trace file " << fileName);
+
+  struct stat st;
+  NS_ABORT_MSG_IF (fstat (m_fd, &st) < 0, "Can't stat trace file " << fileName);
+  m_length = st.st_size;
+  NS_ABORT_MSG_IF (m_length < BINARY_HEADER_SIZE, "Invalid trace file " << fileName);
+
+  void *addr = mmap (0, m_length, PROT_READ, MAP_PRIVATE, m_fd, 0);
+  NS_ABORT_MSG_IF (addr == MAP_FAILED, "Can't map trace file " << fileName);
+  m_data = static_cast<const uint8_t*> (addr);
+
+  // We only walk forward over the file.
+  madvise (addr, m_length, MADV_SEQUENTIAL);
+
+  // Identify the file format from the magic number.
+  uint32_t magic;
+  memcpy (&magic, m_data, sizeof (uint32_t));
+  if (magic == BinaryMagic)
+    {
+      m_format = BINARY;
+      m_start = BINARY_HEADER_SIZE;
+
+      uint32_t version;
+      memcpy (&version, m_data + 4, sizeof (uint32_t));
+      NS_ABORT_MSG_IF (version != BinaryVersion, "Unsupported version " <<
+                       version << " of trace file " << fileName);
+    }
+  else
+    {
+      m_format = PCAP;
+      m_start = PCAP_HEADER_SIZE;
+      switch (magic)
+        {
+          case PCAP_MAGIC_USEC:
+            break;
+          case PCAP_MAGIC_NSEC:
+            m_nanosecs = true;
+            break;
+          case __builtin_bswap32 (PCAP_MAGIC_USEC):
+            m_swapped = true;
+            break;
+          case __builtin_bswap32 (PCAP_MAGIC_NSEC):
+            m_swapped = true;
+            m_nanosecs = true;
+            break;
+          default:
+            NS_ABORT_MSG ("Unknown format for trace file " << fileName);
+        }
+      NS_ABORT_MSG_IF (m_length < PCAP_HEADER_SIZE, "Invalid trace file " << fileName);
+      m_linkType = PcapU32 (m_data + 20);
+    }
+
+  Rewind ();
+}
+
+TraceReader::~TraceReader ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+TraceReader::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TraceReader")
+    .SetParent<Object> ()
+  ;
+  return tid;
+}
+
+bool
+TraceReader::ReadNext (Record &record, uint32_t flowId)
+{
+  NS_LOG_FUNCTION (this << flowId);
+
+  while (ReadRecord (record))
+    {
+      if (flowId == AnyFlow || record.flowId == flowId)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+void
+TraceReader::Rewind (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_cursor = m_start;
+  m_windowStart = 0;
+  m_firstTs = -1;
+  UpdateWindow ();
+}
+
+void
+TraceReader::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_data)
+    {
+      munmap (const_cast<uint8_t*> (m_data), m_length);
+      m_data = 0;
+    }
+  if (m_fd >= 0)
+    {
+      close (m_fd);
+      m_fd = -1;
+    }
+  Object::DoDispose ();
+}
+
+bool
+TraceReader::ReadRecord (Record &record)
+{
+  if (m_format == BINARY)
+    {
+      if (m_cursor + BINARY_RECORD_SIZE > m_length)
+        {
+          return false;
+        }
+
+      uint64_t timeNs;
+      memcpy (&timeNs, m_data + m_cursor, sizeof (uint64_t));
+      memcpy (&record.size, m_data + m_cursor + 8, sizeof (uint32_t));
+      memcpy (&record.flowId, m_data + m_cursor + 12, sizeof (uint32_t));
+      record.time = NanoSeconds (timeNs);
+      m_cursor += BINARY_RECORD_SIZE;
+    }
+  else
+    {
+      if (m_cursor + PCAP_RECORD_SIZE > m_length)
+        {
+          return false;
+        }
+
+      const uint8_t *header = m_data + m_cursor;
+      int64_t tsSec = PcapU32 (header);
+      int64_t tsFrac = PcapU32 (header + 4);
+      uint32_t inclLen = PcapU32 (header + 8);
+      uint32_t origLen = PcapU32 (header + 12);
+      if (m_cursor + PCAP_RECORD_SIZE + inclLen > m_length)
+        {
+          NS_LOG_WARN ("Truncated record in trace file " << m_fileName);
+          return false;
+        }
+
+      int64_t tsNs = tsSec * 1000000000 + (m_nanosecs ? tsFrac : tsFrac * 1000);
+      if (m_firstTs < 0)
+        {
+          m_firstTs = tsNs;
+        }
+      record.time = NanoSeconds (tsNs - m_firstTs);
+      ParseFrame (header + PCAP_RECORD_SIZE, inclLen, origLen, record);
+      m_cursor += PCAP_RECORD_SIZE + inclLen;
+    }
+
+  if (m_cursor >= m_windowStart + m_windowSize / 2)
+    {
+      UpdateWindow ();
+    }
+  return true;
+}
+
+void
+TraceReader::ParseFrame (const uint8_t *data, uint32_t length,
+                         uint32_t origLen, Record &record) const
+{
+  // The source application adds its own headers, so the record size is the
+  // payload of the innermost header we can parse. Frames that are not
+  // Ethernet are replayed whole.
+  record.flowId = 0;
+  record.size = origLen;
+  const uint32_t ethLen = 14;
+  if (m_linkType != 1 || length < ethLen)
+    {
+      return;
+    }
+  record.size = origLen > ethLen ? origLen - ethLen : 0;
+
+  // Only IPv4 UDP or TCP packets have flow IDs. The IP and UDP length fields
+  // are used when captured, as the frame may carry Ethernet padding.
+  if (length < ethLen + 20 || data[12] != 0x08 || data[13] != 0x00)
+    {
+      return;
+    }
+  const uint8_t *ip = data + ethLen;
+  uint32_t ipLen = (ip[0] & 0x0f) * 4;
+  uint32_t ipTotalLen = (ip[2] << 8) | ip[3];
+  record.size = ipTotalLen > ipLen ? ipTotalLen - ipLen : 0;
+
+  uint8_t proto = ip[9];
+  if ((proto != 6 && proto != 17) || length < ethLen + ipLen + 2)
+    {
+      return;
+    }
+  const uint8_t *l4 = ip + ipLen;
+  record.flowId = (l4[0] << 8) | l4[1];
+  if (proto == 17 && length >= ethLen + ipLen + 8)
+    {
+      uint32_t udpLen = (l4[4] << 8) | l4[5];
+      record.size = udpLen > 8 ? udpLen - 8 : 0;
+    }
+  else if (proto == 6 && length >= ethLen + ipLen + 13)
+    {
+      uint32_t tcpLen = (l4[12] >> 4) * 4;
+      record.size = record.size > tcpLen ? record.size - tcpLen : 0;
+    }
+}
+
+void
+TraceReader::UpdateWindow (void)
+{
+  NS_LOG_FUNCTION (this << m_cursor);
+
+  static const size_t pageSize = sysconf (_SC_PAGESIZE);
+  uint8_t *base = const_cast<uint8_t*> (m_data);
+
+  // Release the pages behind the cursor (they will be read back from the file
+  // on a Rewind).
+  size_t release = (m_cursor / pageSize) * pageSize;
+  if (release > m_windowStart)
+    {
+      madvise (base + m_windowStart, release - m_windowStart, MADV_DONTNEED);
+      m_windowStart = release;
+    }
+
+  // Prefetch the window ahead of the cursor.
+  size_t length = std::min (m_windowSize, m_length - m_windowStart);
+  madvise (base + m_windowStart, length, MADV_WILLNEED);
+}
+
+uint32_t
+TraceReader::PcapU32 (const uint8_t *data) const
+{
+  uint32_t value;
+  memcpy (&value, data, sizeof (uint32_t));
+  return m_swapped ? __builtin_bswap32 (value) : value;
+}
+
+} // namespace ns3
@@ -0,0 +1,148 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRACE_READER_H
+#define TRACE_READER_H
+
+#include <ns3/core-module.h>
+
+namespace ns3 {
+
+/**
+ * Sequential reader for packet traces stored in a memory-mapped file. Two file
+ * formats are supported:
+ *
+ * - The native binary format, starting with a 8-bytes header (the 'SFCT'
+ *   magic number followed by the format version, BinaryVersion) and a
+ *   sequence of fixed-size records with the relative time (nanoseconds), the
+ *   packet size (bytes) and the flow ID, all of them in host byte order.
+ * - The libpcap format (microsecond or nanosecond timestamps, any byte order).
+ *   Packet times are relative to the first record in the file. For Ethernet
+ *   captures, the packet size is the payload of the innermost Ethernet,
+ *   IPv4, UDP or TCP header, and the flow ID is the UDP/TCP source port of
+ *   IPv4 packets (zero otherwise). Other captures use the frame length.
+ *
+ * The whole file is mapped at once, but only a small window of pages around
+ * the read cursor is kept resident: the pages ahead are prefetched and the
+ * pages behind are released as the cursor moves on. This way, the memory
+ * footprint remains constant regardless of the trace length.
+ */
+class TraceReader : public Object
+{
+public:
+  /** A single packet record from the trace. */
+  struct Record
+  {
+    Time     time;                  //!< Time relative to the trace start.
+    uint32_t size;                  //!< Packet size.
+    uint32_t flowId;                //!< Flow ID.
+  };
+
+  /**
+   * Complete constructor.
+   * \param fileName The trace file name.
+   */
+  TraceReader (std::string fileName);
+  virtual ~TraceReader ();  //!< Dummy destructor, see DoDispose.
+
+  /**
+   * Register this type.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * Read the next record from the trace, optionally filtering by flow ID.
+   * \param record The record to fill.
+   * \param flowId The flow ID filter (use AnyFlow to accept all records).
+   * \return True if a record was read, false at the end of the trace.
+   */
+  bool ReadNext (Record &record, uint32_t flowId = AnyFlow);
+
+  /** Rewind the read cursor to the first record in the trace. */
+  void Rewind (void);
+
+  /** Flow ID filter value matching all records in the trace. */
+  static const uint32_t AnyFlow = 0xFFFFFFFF;
+
+  /** Magic number for the native binary trace format. */
+  static const uint32_t BinaryMagic = 0x54434653;
+
+  /** Version of the native binary trace format. */
+  static const uint32_t BinaryVersion = 1;
+
+protected:
+  /** Destructor implementation. */
+  virtual void DoDispose ();
+
+private:
+  /** The trace file formats. */
+  enum Format
+  {
+    BINARY,   //!< Native binary records.
+    PCAP      //!< Libpcap file.
+  };
+
+  /**
+   * Read the next record at the cursor position, whatever its flow ID.
+   * \param record The record to fill.
+   * \return True if a record was read, false at the end of the trace.
+   */
+  bool ReadRecord (Record &record);
+
+  /**
+   * Extract the flow ID and the payload size from the captured bytes of a
+   * frame.
+   * \param data The frame bytes.
+   * \param length The number of captured bytes.
+   * \param origLen The original frame length.
+   * \param record The record to fill.
+   */
+  void ParseFrame (const uint8_t *data, uint32_t length, uint32_t origLen,
+                   Record &record) const;
+
+  /**
+   * Advise the kernel about the pages around the read cursor, prefetching the
+   * window ahead and releasing the pages already consumed.
+   */
+  void UpdateWindow (void);
+
+  /**
+   * Read an unsigned 32-bit value from the PCAP file, handling byte order.
+   * \param data The value position.
+   * \return The value.
+   */
+  uint32_t PcapU32 (const uint8_t *data) const;
+
+  std::string     m_fileName;         //!< Trace file name.
+  int             m_fd;               //!< File descriptor.
+  const uint8_t  *m_data;             //!< Mapped file data.
+  size_t          m_length;           //!< Mapped file length.
+  size_t          m_start;            //!< Offset of the first record.
+  size_t          m_cursor;           //!< Offset of the next record.
+  size_t          m_windowStart;      //!< Offset of the resident window.
+  Format          m_format;           //!< Trace file format.
+  bool            m_swapped;          //!< PCAP with swapped byte order.
+  bool            m_nanosecs;         //!< PCAP with nanosecond timestamps.
+  uint32_t        m_linkType;         //!< PCAP data link type.
+  int64_t         m_firstTs;          //!< First PCAP timestamp (ns).
+
+  /** Size of the window prefetched ahead of the read cursor. */
+  static const size_t m_windowSize = 4 << 20;
+};
+
+} // namespace ns3
+#endif // TRACE_READER_H
@@ -0,0 +1,163 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ns3/core-module.h>
+#include <ns3/internet-module.h>
+#include <ns3/virtual-net-device-module.h>
+#include "sfc-tag.h"
+#include "vnf-app.h"
+
+using namespace ns3;
+
+/**
+ * Check that a stopped VNF application drops the packets still arriving from
+ * the switch, instead of queueing and processing them.
+ */
+class VnfAppStopTestCase : public TestCase
+{
+public:
+  VnfAppStopTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * Send a packet addressed to the VNF over the logical port.
+   * \param app The VNF application.
+   */
+  void SendPacket (Ptr<VnfApp> app);
+
+  /**
+   * \name Trace sinks.
+   */
+  //\{
+  void Rx (uint8_t vnfId, uint32_t vnfCopy, uint16_t trafficId, uint32_t seqNum);
+  void Drop (Ptr<const Packet> packet);
+  void QueueDepth (uint32_t oldValue, uint32_t newValue);
+  //\}
+
+  uint32_t m_rxPkts;        //!< Packets received.
+  uint32_t m_dropPkts;      //!< Packets dropped.
+  uint32_t m_maxDepth;      //!< Maximum input queue depth.
+};
+
+VnfAppStopTestCase::VnfAppStopTestCase ()
+  : TestCase ("Packets arriving after stop are dropped"),
+    m_rxPkts (0),
+    m_dropPkts (0),
+    m_maxDepth (0)
+{
+}
+
+void
+VnfAppStopTestCase::SendPacket (Ptr<VnfApp> app)
+{
+  Ipv4Address srcIp ("10.0.0.1");
+  Ipv4Address vnfIp ("10.0.0.2");
+  std::vector<uint8_t> vnfList (1, 1);
+
+  Ptr<Packet> packet = Create<Packet> (100);
+  SfcTag sfcTag (InetSocketAddress (srcIp, 10000),
+                 InetSocketAddress (Ipv4Address ("10.0.0.3"), 20000), vnfList);
+  packet->AddPacketTag (sfcTag);
+
+  UdpHeader udpHeader;
+  udpHeader.SetSourcePort (10000);
+  udpHeader.SetDestinationPort (9999);
+  packet->AddHeader (udpHeader);
+
+  Ipv4Header ipHeader;
+  ipHeader.SetSource (srcIp);
+  ipHeader.SetDestination (vnfIp);
+  ipHeader.SetProtocol (UdpL4Protocol::PROT_NUMBER);
+  ipHeader.SetPayloadSize (packet->GetSize ());
+  packet->AddHeader (ipHeader);
+
+  app->ReadPacket (packet, Mac48Address ("00:00:00:00:00:01"),
+                   Mac48Address ("00:00:00:00:00:02"), Ipv4L3Protocol::PROT_NUMBER);
+}
+
+void
+VnfAppStopTestCase::Rx (uint8_t vnfId, uint32_t vnfCopy, uint16_t trafficId,
+                        uint32_t seqNum)
+{
+  m_rxPkts++;
+}
+
+void
+VnfAppStopTestCase::Drop (Ptr<const Packet> packet)
+{
+  m_dropPkts++;
+}
+
+void
+VnfAppStopTestCase::QueueDepth (uint32_t oldValue, uint32_t newValue)
+{
+  m_maxDepth = std::max (m_maxDepth, newValue);
+}
+
+void
+VnfAppStopTestCase::DoRun (void)
+{
+  Ptr<VnfApp> app = CreateObjectWithAttributes<VnfApp> (
+    "VnfId", UintegerValue (1),
+    "Ipv4Address", Ipv4AddressValue (Ipv4Address ("10.0.0.2")),
+    "UdpPort", UintegerValue (9999),
+    "NumCores", UintegerValue (1));
+  app->SetVirtualDevice (CreateObject<VirtualNetDevice> ());
+  app->TraceConnectWithoutContext (
+    "Rx", MakeCallback (&VnfAppStopTestCase::Rx, this));
+  app->TraceConnectWithoutContext (
+    "Drop", MakeCallback (&VnfAppStopTestCase::Drop, this));
+  app->TraceConnectWithoutContext (
+    "QueueDepth", MakeCallback (&VnfAppStopTestCase::QueueDepth, this));
+
+  Ptr<Node> node = CreateObject<Node> ();
+  node->AddApplication (app);
+  app->SetStartTime (Seconds (0));
+  app->SetStopTime (Seconds (1));
+
+  Simulator::Stop (Seconds (2));
+  Simulator::Run ();
+
+  // The packet arrives after the application stopped.
+  SendPacket (app);
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_dropPkts, 1, "The packet was not dropped.");
+  NS_TEST_EXPECT_MSG_EQ (m_rxPkts, 0, "The packet was received.");
+  NS_TEST_EXPECT_MSG_EQ (m_maxDepth, 0, "The packet was queued.");
+  NS_TEST_EXPECT_MSG_EQ (app->GetAverageUtilization (), 0, "A core was busy.");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * VNF application test suite.
+ */
+class VnfAppTestSuite : public TestSuite
+{
+public:
+  VnfAppTestSuite ();
+};
+
+VnfAppTestSuite::VnfAppTestSuite ()
+  : TestSuite ("vnf-app", UNIT)
+{
+  AddTestCase (new VnfAppStopTestCase, TestCase::QUICK);
+}
+
+static VnfAppTestSuite g_vnfAppTestSuite; //!< Static variable for test initialization
@@ -14,6 +14,7 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <cmath>
 #include <ns3/internet-module.h>
 #include "vnf-app.h"
 #include "sfc-tag.h"
@@ -26,7 +27,13 @@ NS_OBJECT_ENSURE_REGISTERED (VnfApp);
 
 VnfApp::VnfApp ()
   : m_sendEvent (EventId ()),
-    m_logicalPort (0)
+    m_logicalPort (0),
+    m_busyCores (0),
+    m_busyTime (Time (0)),
+    m_lastBusyUpdate (Simulator::Now ()),
+    m_stopped (false),
+    m_queueDepth (0),
+    m_utilization (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -75,6 +82,46 @@ VnfApp::GetTypeId (void)
                    DoubleValue (1.0),
                    MakeDoubleAccessor (&VnfApp::m_scalingFactor),
                    MakeDoubleChecker<double> ())
+
+    // Packet processing model (disabled when NumCores is 0).
+    .AddAttribute ("NumCores",
+                   "The number of worker cores (0 for instantaneous processing).",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&VnfApp::m_numCores),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("QueueSize",
+                   "The maximum number of packets in the input queue.",
+                   UintegerValue (1000),
+                   MakeUintegerAccessor (&VnfApp::m_queueSize),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("PacketCost",
+                   "The fixed service cost for each packet.",
+                   TimeValue (MicroSeconds (5)),
+                   MakeTimeAccessor (&VnfApp::m_pktCost),
+                   MakeTimeChecker (Time (0)))
+    .AddAttribute ("ByteCost",
+                   "The service cost for each packet byte.",
+                   TimeValue (NanoSeconds (10)),
+                   MakeTimeAccessor (&VnfApp::m_byteCost),
+                   MakeTimeChecker (Time (0)))
+    .AddAttribute ("ComputeFactor",
+                   "The computation scaling factor for the service costs.",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&VnfApp::m_csf),
+                   MakeDoubleChecker<double> (0))
+
+    .AddTraceSource ("Rx", "Packet reception trace source.",
+                     MakeTraceSourceAccessor (&VnfApp::m_rxTrace),
+                     "ns3::VnfApp::RxTracedCallback")
+    .AddTraceSource ("QueueDepth", "Input queue depth trace source.",
+                     MakeTraceSourceAccessor (&VnfApp::m_queueDepth),
+                     "ns3::TracedValueCallback::Uint32")
+    .AddTraceSource ("Utilization", "Worker cores utilization trace source.",
+                     MakeTraceSourceAccessor (&VnfApp::m_utilization),
+                     "ns3::TracedValueCallback::Double")
+    .AddTraceSource ("Drop", "Packet drop trace source.",
+                     MakeTraceSourceAccessor (&VnfApp::m_dropTrace),
+                     "ns3::VnfApp::DropTracedCallback")
   ;
   return tid;
 }
@@ -104,29 +151,65 @@ VnfApp::ReadPacket (Ptr<Packet> packet, const Address& srcMac,
   uint16_t srcPort = fromAddr.GetPort ();
   uint32_t pktSize = packet->GetSize ();
 
-  SfcTag pktTag;
-  packet->PeekPacketTag (pktTag);
-  uint16_t trafficId = pktTag.GetTrafficId ();
-
   NS_LOG_DEBUG (GetVnfDesc () <<
                 " received a packet of " << pktSize <<
                 " bytes from source app at IP " << srcIp <<
                 " port " << srcPort);
 
-  // Send an output packet based on the scaling factor.
-  // For each incoming packet with an specific traffic IF, we add the scaling
-  // factor to the packet adjustment map. Every time the adjustment map is >= 1
-  // we send a new output packet and subtract 1 from the adjusment map.
-  m_pktAdjust[trafficId] += m_scalingFactor;
-  while (m_pktAdjust[trafficId] >= 1.0)
+  // A stopped application must not process nor forward any packet.
+  if (m_stopped)
     {
-      SendPacket (pktSize, pktTag, srcPort, srcIp, srcMac, dstMac);
-      m_pktAdjust[trafficId] -= 1.0;
+      NS_LOG_DEBUG (GetVnfDesc () << " dropped a packet (application stopped)");
+      m_dropTrace (packet);
+      return true;
     }
 
+  SfcTag pktTag;
+  packet->PeekPacketTag (pktTag);
+  m_rxTrace (m_vnfId, m_vnfCopy, pktTag.GetTrafficId (), pktTag.GetSeqNum ());
+
+  Job job;
+  job.packet = packet;
+  job.srcIp = srcIp;
+  job.srcPort = srcPort;
+  job.srcMac = srcMac;
+  job.dstMac = dstMac;
+
+  // Without worker cores, the packet is processed right away.
+  if (m_numCores == 0)
+    {
+      ProcessPacket (job);
+      return true;
+    }
+
+  // Otherwise the packet waits in the input queue for an idle core.
+  if (m_queue.size () >= m_queueSize)
+    {
+      NS_LOG_DEBUG (GetVnfDesc () << " dropped a packet (input queue full)");
+      m_dropTrace (packet);
+      return true;
+    }
+  m_queue.push_back (job);
+  m_queueDepth = m_queue.size ();
+  DispatchPackets ();
+
   return true;
 }
 
+double
+VnfApp::GetAverageUtilization (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  Time elapsed = Simulator::Now () - m_startTime;
+  if (m_numCores == 0 || elapsed.IsZero ())
+    {
+      return 0;
+    }
+  Time busyTime = m_busyTime + (Simulator::Now () - m_lastBusyUpdate) * m_busyCores;
+  return busyTime.GetSeconds () / (elapsed.GetSeconds () * m_numCores);
+}
+
 std::string
 VnfApp::GetVnfDesc (void) const
 {
@@ -174,16 +257,115 @@ VnfApp::SendPacket (uint32_t pktSize, SfcTag pktTag,
                 " port " << nextAddress.GetPort ());
 }
 
+void
+VnfApp::ProcessPacket (Job job)
+{
+  NS_LOG_FUNCTION (this << job.packet);
+
+  SfcTag pktTag;
+  job.packet->PeekPacketTag (pktTag);
+  uint32_t pktSize = job.packet->GetSize ();
+
+  // Send output packets based on the scaling factor. The input packet with
+  // sequence number n yields the output packets numbered from n * factor up
+  // to (n + 1) * factor. The output numbers depend only on the input ones,
+  // so all copies of this VNF number the packets of a traffic alike, even
+  // when the traffic is migrated between them.
+  uint32_t seqNum = pktTag.GetSeqNum ();
+  uint32_t firstSeqNum = static_cast<uint32_t> (std::floor (seqNum * m_scalingFactor));
+  uint32_t endSeqNum = static_cast<uint32_t> (std::floor ((seqNum + 1.0) * m_scalingFactor));
+  for (uint32_t outSeqNum = firstSeqNum; outSeqNum < endSeqNum; outSeqNum++)
+    {
+      pktTag.SetSeqNum (outSeqNum);
+      SendPacket (pktSize, pktTag, job.srcPort, job.srcIp, job.srcMac, job.dstMac);
+    }
+}
+
+void
+VnfApp::DispatchPackets (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_coreEvents.resize (m_numCores);
+  while (m_busyCores < m_numCores && !m_queue.empty ())
+    {
+      Job job = m_queue.front ();
+      m_queue.pop_front ();
+      m_queueDepth = m_queue.size ();
+      SetBusyCores (m_busyCores + 1);
+
+      // The packet goes to the first idle core.
+      uint32_t core = 0;
+      while (m_coreEvents [core].IsRunning ())
+        {
+          core++;
+        }
+      Time serviceTime = GetServiceTime (job.packet->GetSize ());
+      m_coreEvents [core] = Simulator::Schedule (
+          serviceTime, &VnfApp::ServiceComplete, this, job);
+    }
+}
+
+void
+VnfApp::ServiceComplete (Job job)
+{
+  NS_LOG_FUNCTION (this << job.packet);
+
+  SetBusyCores (m_busyCores - 1);
+  ProcessPacket (job);
+  DispatchPackets ();
+}
+
+Time
+VnfApp::GetServiceTime (uint32_t pktSize) const
+{
+  return (m_pktCost + m_byteCost * pktSize) * m_csf;
+}
+
+void
+VnfApp::SetBusyCores (uint32_t busyCores)
+{
+  m_busyTime += (Simulator::Now () - m_lastBusyUpdate) * m_busyCores;
+  m_lastBusyUpdate = Simulator::Now ();
+  m_busyCores = busyCores;
+  m_utilization = static_cast<double> (m_busyCores) / m_numCores;
+}
+
 void
 VnfApp::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
 
   m_logicalPort = 0;
-  m_pktAdjust.clear ();
+  for (auto &event : m_coreEvents)
+    {
+      event.Cancel ();
+    }
+  m_coreEvents.clear ();
+  m_queue.clear ();
   Application::DoDispose ();
 }
 
+void
+VnfApp::StopApplication (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  // Drop the packets under processing and waiting for a core, and any
+  // packet arriving from now on.
+  m_stopped = true;
+  for (auto &event : m_coreEvents)
+    {
+      event.Cancel ();
+    }
+  m_queue.clear ();
+  m_queueDepth = 0;
+  if (m_busyCores)
+    {
+      SetBusyCores (0);
+    }
+}
+
 InetSocketAddress
 VnfApp::RemoveHeaders (Ptr<Packet> packet)
 {
@@ -32,6 +32,16 @@ class SfcTag;
  * KeepAddress attribute is set to true, this application doesn't change packet
  * destination address. This is usefull for implementing the first (fake) VNF
  * application that we install in the network switch.
+ *
+ * When the NumCores attribute is set to a non-zero value, this application
+ * also models the packet processing cost: incoming packets wait in a bounded
+ * input queue for one of the worker cores, which process them in FIFO order
+ * with run-to-completion. The service time for each packet is computed from
+ * the fixed per-packet and per-byte costs scaled by the computation scaling
+ * factor. Output packets are only sent when the service completes.
+ *
+ * Once the application stops, the packets under processing are discarded and
+ * the packets still arriving from the switch are dropped.
  */
 class VnfApp : public Application
 {
@@ -67,6 +77,29 @@ public:
   bool ReadPacket (Ptr<Packet> packet, const Address& srcMac,
                    const Address& dstMac, uint16_t protocolNo);
 
+  /**
+   * Get the average utilization of the worker cores since the application
+   * start time.
+   * \return The average utilization in the [0, 1] interval.
+   */
+  double GetAverageUtilization (void) const;
+
+  /**
+   * TracedCallback signature for dropped packets.
+   * \param packet The dropped packet.
+   */
+  typedef void (*DropTracedCallback)(Ptr<const Packet> packet);
+
+  /**
+   * TracedCallback signature for received packets.
+   * \param vnfId The VNF ID.
+   * \param vnfCopy The VNF copy number.
+   * \param trafficId The traffic ID.
+   * \param seqNum The packet sequence number.
+   */
+  typedef void (*RxTracedCallback)(uint8_t vnfId, uint32_t vnfCopy,
+                                   uint16_t trafficId, uint32_t seqNum);
+
 protected:
   /** Destructor implementation */
   virtual void DoDispose (void);
@@ -114,6 +147,50 @@ protected:
     Mac48Address srcMac, Mac48Address dstMac);
 
 private:
+  // Inherited from Application.
+  virtual void StopApplication (void);
+
+  /** A packet waiting for (or under) processing. */
+  struct Job
+  {
+    Ptr<Packet>   packet;           //!< Packet without IP/UDP headers.
+    Ipv4Address   srcIp;            //!< IPv4 source address.
+    uint16_t      srcPort;          //!< UDP source port number.
+    Address       srcMac;           //!< Ethernet source address.
+    Address       dstMac;           //!< Ethernet destination address.
+  };
+
+  /**
+   * Process the packet and send the output packets based on the scaling
+   * factor.
+   * \param job The packet to process.
+   */
+  void ProcessPacket (Job job);
+
+  /**
+   * Start processing the queued packets while there are idle cores.
+   */
+  void DispatchPackets (void);
+
+  /**
+   * Finish the packet processing on a worker core.
+   * \param job The processed packet.
+   */
+  void ServiceComplete (Job job);
+
+  /**
+   * Get the service time for a packet.
+   * \param pktSize The packet size.
+   * \return The service time.
+   */
+  Time GetServiceTime (uint32_t pktSize) const;
+
+  /**
+   * Update the number of busy cores, the utilization and the busy time.
+   * \param busyCores The new number of busy cores.
+   */
+  void SetBusyCores (uint32_t busyCores);
+
   uint8_t               m_vnfId;            //!< VNF ID.
   uint32_t              m_vnfCopy;          //!< VNF copy.
   Ipv4Address           m_ipv4Address;      //!< Local IPv4 address.
@@ -123,9 +200,30 @@ private:
   EventId               m_sendEvent;        //!< SendPacket event.
   Ptr<VirtualNetDevice> m_logicalPort;      //!< OpenFlow logical port device.
 
-  /** Map saving source port number to output packet adjustment */
-  typedef std::map<uint16_t, double> PortDoubleMap_t;
-  PortDoubleMap_t       m_pktAdjust;        //!< Packet transmission adjustment.
+  uint32_t              m_numCores;         //!< Number of worker cores.
+  uint32_t              m_queueSize;        //!< Input queue size (packets).
+  Time                  m_pktCost;          //!< Per-packet service cost.
+  Time                  m_byteCost;         //!< Per-byte service cost.
+  double                m_csf;              //!< Computation scaling factor.
+  std::deque<Job>       m_queue;            //!< Input queue.
+  std::vector<EventId>  m_coreEvents;       //!< Service end at each core.
+  uint32_t              m_busyCores;        //!< Number of busy cores.
+  Time                  m_busyTime;         //!< Accumulated core busy time.
+  Time                  m_lastBusyUpdate;   //!< Last busy time update.
+  bool                  m_stopped;          //!< Application stopped.
+
+  /** Trace source fired when the input queue depth changes. */
+  TracedValue<uint32_t> m_queueDepth;
+
+  /** Trace source fired when the core utilization changes. */
+  TracedValue<double>   m_utilization;
+
+  /** Trace source fired when a packet is dropped at the input queue or
+   *  after the application stops. */
+  TracedCallback<Ptr<const Packet>> m_dropTrace;
+
+  /** Trace source fired when a packet is received from the switch. */
+  TracedCallback<uint8_t, uint32_t, uint16_t, uint32_t> m_rxTrace;
 };
 
 } // namespace ns3
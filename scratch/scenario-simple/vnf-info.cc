@@ -50,7 +50,8 @@ VnfInfo::VnfInfo (uint8_t vnfId)
 
   // The 2nd application is the one we install in the server switch. This
   // application will change the destination address of the packet based on the
-  // SFC tag.
+  // SFC tag. Its packet processing cost (when enabled by the VnfApp::NumCores
+  // attribute) is scaled by the VNF computation scaling factor.
   m_2ndFactory.SetTypeId (VnfApp::GetTypeId ());
   m_2ndFactory.Set ("VnfId", UintegerValue (vnfId));
   m_2ndFactory.Set ("KeepAddress", BooleanValue (false));
@@ -147,9 +148,11 @@ VnfInfo::SetScalingFactors (double csf, double nsf)
     }
 
   m_2ndFactory.Set ("ScalingFactor", DoubleValue (m_nsf / m_csf));
+  m_2ndFactory.Set ("ComputeFactor", DoubleValue (m_csf));
   for (auto &app : m_2ndAppList)
     {
       app->SetAttribute ("ScalingFactor", DoubleValue (m_nsf / m_csf));
+      app->SetAttribute ("ComputeFactor", DoubleValue (m_csf));
     }
 }
 
@@ -216,6 +216,55 @@ CsmaChannel::TransmitStart (Ptr<const Packet> p, uint32_t srcId)
   return true;
 }
 
+bool
+CsmaChannel::TransmitFullDuplex (Ptr<const Packet> p, uint32_t srcId, Time txTime)
+{
+  NS_LOG_FUNCTION (this << p << srcId << txTime);
+  NS_LOG_INFO ("UID is " << p->GetUid () << ")");
+
+  if (!m_fullDuplex || GetState (srcId) != IDLE)
+    {
+      NS_LOG_WARN ("CsmaChannel::TransmitFullDuplex(): Not full-duplex or state is not IDLE");
+      return false;
+    }
+
+  if (!IsActive (srcId))
+    {
+      NS_LOG_ERROR ("CsmaChannel::TransmitFullDuplex(): Seclected source is not currently attached to network");
+      return false;
+    }
+
+  NS_LOG_LOGIC ("Schedule reception in " << (txTime + m_delay).As (Time::S));
+
+  //
+  // A device may be detached or attached again before the packet reaches it,
+  // so schedule the reception at every other device and check then.
+  //
+  for (uint32_t devId = 0; devId < m_deviceList.size (); devId++)
+    {
+      if (devId != srcId)
+        {
+          Simulator::ScheduleWithContext (m_deviceList[devId].devicePtr->GetNode ()->GetId (),
+                                          txTime + m_delay,
+                                          &CsmaChannel::ReceiveFullDuplex, this, devId,
+                                          p->Copy (), m_deviceList[srcId].devicePtr);
+        }
+    }
+  return true;
+}
+
+void
+CsmaChannel::ReceiveFullDuplex (uint32_t deviceId, Ptr<Packet> p,
+                                Ptr<CsmaNetDevice> sender)
+{
+  NS_LOG_FUNCTION (this << deviceId << p << sender);
+
+  if (IsActive (deviceId))
+    {
+      m_deviceList[deviceId].devicePtr->Receive (p, sender);
+    }
+}
+
 bool
 CsmaChannel::IsActive (uint32_t deviceId)
 {
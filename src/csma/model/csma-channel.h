@@ -216,6 +216,29 @@ public:
    */
   bool TransmitEnd (uint32_t deviceId);
 
+  /**
+   * \brief Start the transmission of a packet on a full-duplex channel,
+   * and schedule its reception at the end of the transmission.
+   *
+   * On a full-duplex channel, nothing can disturb a transmission once it
+   * has started, so the reception of the packet by the other net device is
+   * scheduled right away, txTime plus the channel delay from now, instead
+   * of waiting for a TransmitEnd call. The subchannel of the transmitter
+   * stays IDLE: the net device is responsible for not starting another
+   * transmission before this one completes. Whether each receiver is
+   * attached is checked when the packet reaches it, so a device detached
+   * meanwhile costs one event per packet sent on the channel.
+   *
+   * \param p A reference to the packet that will be transmitted over
+   * the channel
+   * \param srcId The device Id of the net device that wants to
+   * transmit on the channel.
+   * \param txTime The transmission time of the packet
+   * \return True if the channel is full-duplex and idle, and the
+   * transmitting net device is currently active.
+   */
+  bool TransmitFullDuplex (Ptr<const Packet> p, uint32_t srcId, Time txTime);
+
   /**
    * \brief Indicates that the channel has finished propagating the
    * current packet. The channel is released and becomes free.
@@ -339,6 +362,17 @@ private:
    */
   CsmaChannel &operator = (CsmaChannel const &o);
 
+  /**
+   * \brief Deliver a packet sent by TransmitFullDuplex to a net device,
+   * unless the device was detached from the channel meanwhile.
+   *
+   * \param deviceId The deviceID of the receiving net device
+   * \param p The packet
+   * \param sender The transmitting net device
+   */
+  void ReceiveFullDuplex (uint32_t deviceId, Ptr<Packet> p,
+                          Ptr<CsmaNetDevice> sender);
+
   /**
    * The assigned data rate of the channel
    */
@@ -78,6 +78,11 @@ CsmaNetDevice::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&CsmaNetDevice::m_receiveEnable),
                    MakeBooleanChecker ())
+    .AddAttribute ("FullDuplexFastPath",
+                   "Schedule fewer events per frame when the channel is full-duplex.",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&CsmaNetDevice::m_fullDuplexFastPath),
+                   MakeBooleanChecker ())
     .AddAttribute ("ReceiveErrorModel", 
                    "The receiver error model used to simulate packet loss",
                    PointerValue (),
@@ -512,6 +517,12 @@ CsmaNetDevice::TransmitStart (void)
     }
   else 
     {
+      if (m_fullDuplexFastPath && m_channel->IsFullDuplex ())
+        {
+          TransmitFullDuplex ();
+          return;
+        }
+
       //
       // The channel is free, transmit the packet
       //
@@ -539,6 +550,47 @@ CsmaNetDevice::TransmitStart (void)
     }
 }
 
+void
+CsmaNetDevice::TransmitFullDuplex (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+
+  m_phyTxBeginTrace (m_currentPkt);
+  Time tEvent = m_bps.CalculateBytesTxTime (m_currentPkt->GetSize ());
+  if (m_channel->TransmitFullDuplex (m_currentPkt, m_deviceId, tEvent) == false)
+    {
+      NS_LOG_WARN ("Channel TransmitFullDuplex returns an error");
+      m_phyTxDropTrace (m_currentPkt);
+      m_currentPkt = 0;
+      m_txMachineState = READY;
+      return;
+    }
+
+  m_backoff.ResetBackoffTime ();
+  if (!m_phyTxEndTrace.IsEmpty ())
+    {
+      //
+      // Somebody wants to see the end of the transmission, so go through
+      // TransmitCompleteEvent as usual.
+      //
+      m_txMachineState = BUSY;
+      NS_LOG_LOGIC ("Schedule TransmitCompleteEvent in " << tEvent.As (Time::S));
+      Simulator::Schedule (tEvent, &CsmaNetDevice::TransmitCompleteEvent, this);
+      return;
+    }
+
+  //
+  // The channel already has the packet and nobody watches the end of the
+  // transmission: the transmitter is simply unavailable until the end of the
+  // interframe gap.  Send () queues packets in both the BUSY and the GAP
+  // states, so entering GAP now changes nothing for the upper layers.
+  //
+  m_txMachineState = GAP;
+  m_currentPkt = 0;
+  NS_LOG_LOGIC ("Schedule TransmitReadyEvent in " << (tEvent + m_tInterframeGap).As (Time::S));
+  Simulator::Schedule (tEvent + m_tInterframeGap, &CsmaNetDevice::TransmitReadyEvent, this);
+}
+
 void
 CsmaNetDevice::TransmitAbort (void)
 {
@@ -596,7 +648,8 @@ CsmaNetDevice::TransmitCompleteEvent (void)
   // the transmitter after the interframe gap.
   //
   NS_ASSERT_MSG (m_txMachineState == BUSY, "CsmaNetDevice::transmitCompleteEvent(): Must be BUSY if transmitting");
-  NS_ASSERT (m_channel->GetState (m_deviceId) == TRANSMITTING);
+  bool fastPath = m_fullDuplexFastPath && m_channel->IsFullDuplex ();
+  NS_ASSERT (fastPath || m_channel->GetState (m_deviceId) == TRANSMITTING);
   m_txMachineState = GAP;
 
   //
@@ -608,7 +661,14 @@ CsmaNetDevice::TransmitCompleteEvent (void)
   NS_LOG_LOGIC ("Pkt UID is " << m_currentPkt->GetUid () << ")");
   NS_LOG_LOGIC ("Device ID is " << m_deviceId);
 
-  m_channel->TransmitEnd (m_deviceId);
+  //
+  // With the full-duplex fast path, the channel has already scheduled the
+  // reception of the packet in TransmitFullDuplex ().
+  //
+  if (!fastPath)
+    {
+      m_channel->TransmitEnd (m_deviceId);
+    }
   m_phyTxEndTrace (m_currentPkt);
   m_currentPkt = 0;
 
@@ -407,6 +407,22 @@ private:
    */
   void TransmitStart ();
 
+  /**
+   * Start Sending a Packet Down a Full-Duplex Wire.
+   *
+   * Called by TransmitStart when the channel is full-duplex and the
+   * FullDuplexFastPath attribute is set.  Since there is no contention on
+   * such a channel, the channel schedules the reception of the packet as
+   * soon as the transmission starts.  Unless the PhyTxEnd trace source is
+   * connected, the net device then skips TransmitCompleteEvent and only
+   * schedules the TransmitReadyEvent at the end of the interframe gap, so
+   * that back-to-back frames cost one transmit event each instead of two,
+   * with the same arrival times.
+   *
+   * \see CsmaChannel::TransmitFullDuplex ()
+   */
+  void TransmitFullDuplex (void);
+
   /**
    * Stop Sending a Packet Down the Wire and Begin the Interframe Gap.
    *
@@ -472,6 +488,12 @@ private:
    */
   bool m_receiveEnable;
 
+  /**
+   * Use the fast path of TransmitFullDuplex on full-duplex channels.
+   * False by default
+   */
+  bool m_fullDuplexFastPath;
+
   /**
    * Enumeration of the states of the transmit machine of the net device.
    */
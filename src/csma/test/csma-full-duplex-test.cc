@@ -0,0 +1,234 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/data-rate.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/csma-helper.h"
+#include "ns3/csma-net-device.h"
+#include "ns3/csma-channel.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup csma
+ * \ingroup tests
+ *
+ * \brief CSMA full-duplex fast path test
+ *
+ * Runs the same traffic over a full-duplex channel with and without the
+ * FullDuplexFastPath attribute of the devices, and checks that the frames
+ * are received and dropped at the same times, with fewer events executed
+ * by the fast path. Optionally, a device is detached while a frame is sent
+ * to it, and attached again later.
+ */
+class CsmaFullDuplexTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Constructor
+   * \param traceTxEnd Whether to connect the PhyTxEnd trace source.
+   * \param detach Whether to detach a device for a while.
+   */
+  CsmaFullDuplexTestCase (bool traceTxEnd, bool detach = false);
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Simulate the traffic.
+   * \param fastPath The value of the FullDuplexFastPath attribute.
+   * \param events The events seen by the trace sinks.
+   * \return The number of events executed by the simulator.
+   */
+  uint64_t RunTraffic (bool fastPath, std::vector<std::string> &events);
+
+  /**
+   * \brief Send a burst of frames.
+   * \param device The sending device.
+   * \param to The destination of the frames.
+   * \param n The number of frames.
+   */
+  static void SendBurst (Ptr<NetDevice> device, Address to, uint32_t n);
+
+  /**
+   * \brief Detach a device from its channel, or attach it again.
+   * \param device The device.
+   * \param attach Whether to attach the device again.
+   */
+  static void SetAttached (Ptr<NetDevice> device, bool attach);
+
+  /**
+   * \brief Trace sink.
+   * \param context The index of the device, followed by the trace name.
+   * \param p The packet.
+   */
+  void Trace (std::string context, Ptr<const Packet> p);
+
+  bool m_traceTxEnd;                  //!< Connect the PhyTxEnd trace source.
+  bool m_detach;                      //!< Detach a device for a while.
+  std::vector<std::string> *m_events; //!< The events of the current run.
+};
+
+CsmaFullDuplexTestCase::CsmaFullDuplexTestCase (bool traceTxEnd, bool detach)
+  : TestCase (detach ? "CSMA full-duplex fast path with a detached device"
+                     : traceTxEnd ? "CSMA full-duplex fast path with PhyTxEnd traced"
+                                  : "CSMA full-duplex fast path"),
+    m_traceTxEnd (traceTxEnd),
+    m_detach (detach),
+    m_events (0)
+{
+}
+
+void
+CsmaFullDuplexTestCase::SendBurst (Ptr<NetDevice> device, Address to, uint32_t n)
+{
+  for (uint32_t i = 0; i < n; i++)
+    {
+      device->Send (Create<Packet> (46 + (i * 347) % 1455), to, 0x0800);
+    }
+}
+
+void
+CsmaFullDuplexTestCase::SetAttached (Ptr<NetDevice> device, bool attach)
+{
+  Ptr<CsmaNetDevice> csmaDevice = DynamicCast<CsmaNetDevice> (device);
+  Ptr<CsmaChannel> channel = DynamicCast<CsmaChannel> (csmaDevice->GetChannel ());
+  if (attach)
+    {
+      channel->Reattach (csmaDevice);
+    }
+  else
+    {
+      channel->Detach (csmaDevice);
+    }
+}
+
+void
+CsmaFullDuplexTestCase::Trace (std::string context, Ptr<const Packet> p)
+{
+  std::ostringstream os;
+  os << Simulator::Now ().GetTimeStep () << " " << context << " " << p->GetSize ();
+  m_events->push_back (os.str ());
+}
+
+uint64_t
+CsmaFullDuplexTestCase::RunTraffic (bool fastPath, std::vector<std::string> &events)
+{
+  m_events = &events;
+
+  NodeContainer nodes;
+  nodes.Create (2);
+  CsmaHelper csma;
+  csma.SetChannelAttribute ("DataRate", DataRateValue (DataRate ("100Mbps")));
+  csma.SetChannelAttribute ("Delay", TimeValue (MicroSeconds (3)));
+  csma.SetChannelAttribute ("FullDuplex", BooleanValue (true));
+  csma.SetDeviceAttribute ("FullDuplexFastPath", BooleanValue (fastPath));
+  NetDeviceContainer devices = csma.Install (nodes);
+
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      std::ostringstream context;
+      context << i;
+      Ptr<NetDevice> device = devices.Get (i);
+      device->TraceConnect ("PhyRxEnd", context.str () + " rx",
+                            MakeCallback (&CsmaFullDuplexTestCase::Trace, this));
+      device->TraceConnect ("MacTxDrop", context.str () + " drop",
+                            MakeCallback (&CsmaFullDuplexTestCase::Trace, this));
+      device->TraceConnect ("Sniffer", context.str () + " sniff",
+                            MakeCallback (&CsmaFullDuplexTestCase::Trace, this));
+      if (m_traceTxEnd)
+        {
+          device->TraceConnect ("PhyTxEnd", context.str () + " txend",
+                                MakeCallback (&CsmaFullDuplexTestCase::Trace, this));
+        }
+    }
+
+  // A burst which overflows the queue of the first device, traffic in the
+  // other direction meanwhile, and frames sent to an idle transmitter
+  Address to0 = devices.Get (0)->GetAddress ();
+  Address to1 = devices.Get (1)->GetAddress ();
+  Simulator::Schedule (Seconds (1), &SendBurst, devices.Get (0), to1, 150);
+  Simulator::Schedule (Seconds (1) + MicroSeconds (100), &SendBurst, devices.Get (1), to0, 20);
+  Simulator::Schedule (Seconds (1) + MicroSeconds (200), &SendBurst, devices.Get (1), to0, 3);
+  if (m_detach)
+    {
+      // The second device is detached and attached again while frames
+      // are sent to it
+      Simulator::Schedule (Seconds (1) + MicroSeconds (1000), &SetAttached, devices.Get (1), false);
+      Simulator::Schedule (Seconds (1) + MicroSeconds (1500), &SetAttached, devices.Get (1), true);
+    }
+  Simulator::Schedule (Seconds (2), &SendBurst, devices.Get (0), to1, 1);
+  Simulator::Schedule (Seconds (2) + MicroSeconds (1), &SendBurst, devices.Get (0), to1, 1);
+  Simulator::Run ();
+
+  uint64_t eventCount = Simulator::GetEventCount ();
+  Simulator::Destroy ();
+  m_events = 0;
+  return eventCount;
+}
+
+void
+CsmaFullDuplexTestCase::DoRun (void)
+{
+  std::vector<std::string> reference;
+  std::vector<std::string> events;
+  uint64_t referenceCount = RunTraffic (false, reference);
+  uint64_t eventCount = RunTraffic (true, events);
+
+  NS_TEST_ASSERT_MSG_EQ (events.size (), reference.size (), "Fast path fired other traces");
+  for (uint32_t i = 0; i < reference.size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (events[i], reference[i], "Fast path fired other traces");
+    }
+  if (m_detach)
+    {
+      // The frames sent to the detached device cost the fast path an event
+      return;
+    }
+  if (!m_traceTxEnd)
+    {
+      NS_TEST_EXPECT_MSG_LT (eventCount, referenceCount, "Fast path did not save events");
+    }
+  NS_TEST_EXPECT_MSG_LT_OR_EQ (eventCount, referenceCount, "Fast path executed more events");
+}
+
+/**
+ * \ingroup csma
+ * \ingroup tests
+ *
+ * \brief CSMA full-duplex TestSuite
+ */
+class CsmaFullDuplexTestSuite : public TestSuite
+{
+public:
+  CsmaFullDuplexTestSuite ()
+    : TestSuite ("devices-csma-full-duplex", UNIT)
+  {
+    AddTestCase (new CsmaFullDuplexTestCase (false), TestCase::QUICK);
+    AddTestCase (new CsmaFullDuplexTestCase (true), TestCase::QUICK);
+    AddTestCase (new CsmaFullDuplexTestCase (false, true), TestCase::QUICK);
+  }
+};
+
+static CsmaFullDuplexTestSuite g_csmaFullDuplexTestSuite; //!< Static variable for test initialization
@@ -83,6 +83,11 @@ public:
    * Users must first call PopulateRoutingTables() and then may subsequently
    * call RecomputeRoutingTables() at any later time in the simulation.
    *
+   * The routes are recomputed incrementally: only the nodes whose routes
+   * depend on a changed part of the topology run the SPF calculation
+   * again, and only their routes to destinations whose paths changed are
+   * replaced (see GlobalRouteManager::UpdateRoutes ()).
+   *
    */
   static void RecomputeRoutingTables (void);
 private:
@@ -17,6 +17,9 @@
  *
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
+#include <tuple>
+#include <utility>
+
 #include "ns3/assert.h"
 #include "ns3/packet.h"
 #include "ns3/simulator.h"
@@ -199,8 +202,8 @@ ArpCache::HandleWaitReplyTimeout (void)
   bool restartWaitReplyTimer = false;
   for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++) 
     {
-      entry = (*i).second;
-      if (entry != 0 && entry->IsWaitReply ())
+      entry = &i->second;
+      if (entry->IsWaitReply ())
         {
           if (entry->GetRetries () < m_maxRetries)
             {
@@ -244,11 +247,7 @@ void
 ArpCache::Flush (void)
 {
   NS_LOG_FUNCTION (this);
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++) 
-    {
-      delete (*i).second;
-    }
-  m_arpCache.erase (m_arpCache.begin (), m_arpCache.end ());
+  m_arpCache.clear ();
   if (m_waitReplyTimer.IsRunning ())
     {
       NS_LOG_LOGIC ("Stopping WaitReplyTimer at " << Simulator::Now ().GetSeconds () << " due to ArpCache flush");
@@ -275,17 +274,17 @@ ArpCache::PrintArpCache (Ptr<OutputStreamWrapper> stream)
           *os << static_cast<int> (m_device->GetIfIndex ());
         }
 
-      *os << " lladdr " << i->second->GetMacAddress ();
+      *os << " lladdr " << i->second.GetMacAddress ();
 
-      if (i->second->IsAlive ())
+      if (i->second.IsAlive ())
         {
           *os << " REACHABLE\n";
         }
-      else if (i->second->IsWaitReply ())
+      else if (i->second.IsWaitReply ())
         {
           *os << " DELAY\n";
         }
-      else if (i->second->IsPermanent ())
+      else if (i->second.IsPermanent ())
 	{
 	  *os << " PERMANENT\n";
 	}
@@ -304,7 +303,7 @@ ArpCache::LookupInverse (Address to)
   std::list<ArpCache::Entry *> entryList;
   for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++)
     {
-      ArpCache::Entry *entry = (*i).second;
+      ArpCache::Entry *entry = &i->second;
       if (entry->GetMacAddress () == to)
         {
           entryList.push_back (entry);
@@ -321,7 +320,7 @@ ArpCache::Lookup (Ipv4Address to)
   CacheI it = m_arpCache.find (to);
   if (it != m_arpCache.end ())
     {
-      return it->second;
+      return &it->second;
     }
   return 0;
 }
@@ -330,28 +329,41 @@ ArpCache::Entry *
 ArpCache::Add (Ipv4Address to)
 {
   NS_LOG_FUNCTION (this << to);
-  NS_ASSERT (m_arpCache.find (to) == m_arpCache.end ());
+  std::pair<CacheI, bool> ret = m_arpCache.emplace (std::piecewise_construct,
+                                                    std::forward_as_tuple (to),
+                                                    std::forward_as_tuple (this));
+  NS_ASSERT (ret.second);
 
-  ArpCache::Entry *entry = new ArpCache::Entry (this);
-  m_arpCache[to] = entry;
+  ArpCache::Entry *entry = &ret.first->second;
   entry->SetIpv4Address (to);
   return entry;
 }
 
+ArpCache::Entry *
+ArpCache::AddPermanent (Ipv4Address to, Address macAddress)
+{
+  NS_LOG_FUNCTION (this << to << macAddress);
+  ArpCache::Entry *entry = Lookup (to);
+  if (entry == 0)
+    {
+      entry = Add (to);
+    }
+  NS_ASSERT_MSG (!entry->IsWaitReply (), "Can not make a pending ARP entry permanent");
+  entry->SetMacAddress (macAddress);
+  entry->MarkPermanent ();
+  return entry;
+}
+
 void
 ArpCache::Remove (ArpCache::Entry *entry)
 {
   NS_LOG_FUNCTION (this << entry);
   
-  for (CacheI i = m_arpCache.begin (); i != m_arpCache.end (); i++)
+  CacheI i = m_arpCache.find (entry->GetIpv4Address ());
+  if (i != m_arpCache.end () && &i->second == entry)
     {
-      if ((*i).second == entry)
-        {
-          m_arpCache.erase (i);
-          entry->ClearPendingPacket (); //clear the pending packets for entry's ipaddress
-          delete entry;
-          return;
-        }
+      m_arpCache.erase (i); // this also clears the pending packets for entry's ipaddress
+      return;
     }
   NS_LOG_WARN ("Entry not found in this ARP Cache");
 }
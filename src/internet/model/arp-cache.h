@@ -160,6 +160,18 @@ public:
    * \returns A pointer to a new ARP Entry.
    */
   ArpCache::Entry *Add (Ipv4Address to);
+  /**
+   * \brief Add a permanent entry to this ARP cache
+   *
+   * If there is already an entry for this address, its MAC address is
+   * replaced and it becomes permanent.  This is meant to preload the cache
+   * with static neighbors, so that no ARP request is ever sent to them.
+   *
+   * \param to the destination address of the ARP entry.
+   * \param macAddress the MAC address of the destination.
+   * \returns A pointer to the permanent ARP Entry.
+   */
+  ArpCache::Entry *AddPermanent (Ipv4Address to, Address macAddress);
   /**
    * \brief Remove an entry.
    * \param entry pointer to delete it from the list
@@ -312,12 +324,16 @@ private:
 private:
   /**
    * \brief ARP Cache container
+   *
+   * The entries are stored in the container itself, whose elements are
+   * never moved, so the entry pointers given to the users stay valid until
+   * the entries are removed.
    */
-  typedef std::unordered_map<Ipv4Address, ArpCache::Entry *, Ipv4AddressHash> Cache;
+  typedef std::unordered_map<Ipv4Address, ArpCache::Entry, Ipv4AddressHash> Cache;
   /**
    * \brief ARP Cache container iterator
    */
-  typedef std::unordered_map<Ipv4Address, ArpCache::Entry *, Ipv4AddressHash>::iterator CacheI;
+  typedef std::unordered_map<Ipv4Address, ArpCache::Entry, Ipv4AddressHash>::iterator CacheI;
 
   virtual void DoDispose (void);
 
@@ -27,6 +27,7 @@
 #include <queue>
 #include <algorithm>
 #include <iostream>
+#include <iterator>
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
@@ -470,6 +471,28 @@ GlobalRouteManagerLSDB::Insert (Ipv4Address addr, GlobalRoutingLSA* lsa)
   else
     {
       m_database.insert (LSDBPair_t (addr, lsa));
+//
+// Index the TransitNetwork link records for GetLSAByLinkData ().  If several
+// LSAs have the same Link Data, keep the one with the lowest address, which
+// is the first one found when walking the database.
+//
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+          if (lr->GetLinkType () != GlobalRoutingLinkRecord::TransitNetwork)
+            {
+              continue;
+            }
+          LSDBMap_t::iterator i = m_linkDataIndex.find (lr->GetLinkData ());
+          if (i == m_linkDataIndex.end ())
+            {
+              m_linkDataIndex.insert (LSDBPair_t (lr->GetLinkData (), lsa));
+            }
+          else if (addr < i->second->GetLinkStateId ())
+            {
+              i->second = lsa;
+            }
+        }
     }
 }
 
@@ -494,13 +517,10 @@ GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 //
 // Look up an LSA by its address.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_database.find (addr);
+  if (i != m_database.end ())
     {
-      if (i->first == addr)
-        {
-          return i->second;
-        }
+      return i->second;
     }
   return 0;
 }
@@ -510,24 +530,96 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 {
   NS_LOG_FUNCTION (this << addr);
 //
-// Look up an LSA by its address.
+// Look up an LSA by the Link Data of one of its TransitNetwork link records.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_linkDataIndex.find (addr);
+  if (i != m_linkDataIndex.end ())
     {
-      GlobalRoutingLSA* temp = i->second;
-// Iterate among temp's Link Records
-      for (uint32_t j = 0; j < temp->GetNLinkRecords (); j++)
+      return i->second;
+    }
+  return 0;
+}
+
+//
+// Compare the contents of two LSAs, except for their SPF status.
+//
+static bool
+IsSameLSA (GlobalRoutingLSA *a, GlobalRoutingLSA *b)
+{
+  if (a->GetLSType () != b->GetLSType ()
+      || a->GetLinkStateId () != b->GetLinkStateId ()
+      || a->GetAdvertisingRouter () != b->GetAdvertisingRouter ()
+      || a->GetNetworkLSANetworkMask () != b->GetNetworkLSANetworkMask ()
+      || a->GetNLinkRecords () != b->GetNLinkRecords ()
+      || a->GetNAttachedRouters () != b->GetNAttachedRouters ())
+    {
+      return false;
+    }
+  for (uint32_t j = 0; j < a->GetNLinkRecords (); j++)
+    {
+      GlobalRoutingLinkRecord *la = a->GetLinkRecord (j);
+      GlobalRoutingLinkRecord *lb = b->GetLinkRecord (j);
+      if (la->GetLinkType () != lb->GetLinkType ()
+          || la->GetLinkId () != lb->GetLinkId ()
+          || la->GetLinkData () != lb->GetLinkData ()
+          || la->GetMetric () != lb->GetMetric ())
+        {
+          return false;
+        }
+    }
+  for (uint32_t j = 0; j < a->GetNAttachedRouters (); j++)
+    {
+      if (a->GetAttachedRouter (j) != b->GetAttachedRouter (j))
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+bool
+GlobalRouteManagerLSDB::GetChangedLSAs (const GlobalRouteManagerLSDB &old,
+                                        std::set<Ipv4Address> &changed) const
+{
+  NS_LOG_FUNCTION (this << &old);
+//
+// Both maps are sorted by address, so walk them in parallel.
+//
+  LSDBMap_t::const_iterator i = m_database.begin ();
+  LSDBMap_t::const_iterator j = old.m_database.begin ();
+  while (i != m_database.end () || j != old.m_database.end ())
+    {
+      if (j == old.m_database.end () || (i != m_database.end () && i->first < j->first))
         {
-          GlobalRoutingLinkRecord *lr = temp->GetLinkRecord (j);
-          if ( lr->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork &&
-               lr->GetLinkData () == addr)
+          changed.insert ((i++)->first);
+        }
+      else if (i == m_database.end () || j->first < i->first)
+        {
+          changed.insert ((j++)->first);
+        }
+      else
+        {
+          if (!IsSameLSA (i->second, j->second))
             {
-              return temp;
+              changed.insert (i->first);
             }
+          i++;
+          j++;
         }
     }
-  return 0;
+
+  if (m_extdatabase.size () != old.m_extdatabase.size ())
+    {
+      return true;
+    }
+  for (uint32_t k = 0; k < m_extdatabase.size (); k++)
+    {
+      if (!IsSameLSA (m_extdatabase[k], old.m_extdatabase[k]))
+        {
+          return true;
+        }
+    }
+  return false;
 }
 
 // ---------------------------------------------------------------------------
@@ -538,7 +630,10 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
 
 GlobalRouteManagerImpl::GlobalRouteManagerImpl () 
   :
-    m_spfroot (0)
+    m_spfroot (0),
+    m_spfReplaceRoutes (false),
+    m_spfTree (0),
+    m_spfStubOrder (0)
 {
   NS_LOG_FUNCTION (this);
   m_lsdb = new GlobalRouteManagerLSDB ();
@@ -597,6 +692,7 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
       delete m_lsdb;
       m_lsdb = new GlobalRouteManagerLSDB ();
     }
+  m_spfTrees.clear ();
 }
 
 //
@@ -692,41 +788,705 @@ GlobalRouteManagerImpl::BuildGlobalRoutingDatabase ()
 // list becomes empty. 
 //
 void
-GlobalRouteManagerImpl::InitializeRoutes ()
+GlobalRouteManagerImpl::InitializeRoutes ()
+{
+  NS_LOG_FUNCTION (this);
+//
+// Walk the list of nodes in the system.
+//
+  NS_LOG_INFO ("About to start SPF calculation");
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<Node> node = *i;
+//
+// Look for the GlobalRouter interface that indicates that the node is
+// participating in routing.
+//
+      Ptr<GlobalRouter> rtr = 
+        node->GetObject<GlobalRouter> ();
+
+      uint32_t systemId = Simulator::GetSystemId ();
+      // Ignore nodes that are not assigned to our systemId (distributed sim)
+      if (node->GetSystemId () != systemId) 
+        {
+          continue;
+        }
+
+//
+// if the node has a global router interface, then run the global routing
+// algorithms.
+//
+      if (rtr && rtr->GetNumLSAs () )
+        {
+          SPFCalculate (rtr->GetRouterId ());
+        }
+    }
+  NS_LOG_INFO ("Finished SPF calculation");
+}
+
+//
+// Incremental version of DeleteGlobalRoutes (), BuildGlobalRoutingDatabase ()
+// and InitializeRoutes ().  We keep the shortest-path tree of each router
+// from its last SPF calculation, and compare the new LSAs with the ones used
+// for this calculation.  The SPF calculation only runs again for the routers
+// whose tree is changed by the new LSAs, beyond the leaves of the tree that
+// SPFUpdateTree () can attach again on its own.  For the other routers, only
+// the routes to the destinations advertised by the changed LSAs are written
+// again, from the next hops kept in the tree.
+//
+void
+GlobalRouteManagerImpl::UpdateRoutes ()
+{
+  NS_LOG_FUNCTION (this);
+  if (m_spfTrees.empty ())
+    {
+      NS_LOG_LOGIC ("No previous SPF calculation; computing all routes");
+      DeleteGlobalRoutes ();
+      BuildGlobalRoutingDatabase ();
+      InitializeRoutes ();
+      return;
+    }
+
+  GlobalRouteManagerLSDB *oldLsdb = m_lsdb;
+  m_lsdb = new GlobalRouteManagerLSDB ();
+  BuildGlobalRoutingDatabase ();
+  std::set<Ipv4Address> changed;
+  bool externalsChanged = m_lsdb->GetChangedLSAs (*oldLsdb, changed);
+  NS_LOG_LOGIC ("Found " << changed.size () << " changed LSAs" <<
+                (externalsChanged ? " and changed external LSAs" : ""));
+
+  SPFChanges_t changes;
+  SPFInLinks_t inLinks;
+  for (std::set<Ipv4Address>::const_iterator i = changed.begin (); i != changed.end (); i++)
+    {
+      SPFChange &change = changes[*i];
+      change.oldLsa = oldLsdb->GetLSA (*i);
+      change.newLsa = m_lsdb->GetLSA (*i);
+      SPFGetLinkChanges (change);
+      for (uint32_t j = 0; j < change.removedLinks.size (); j++)
+        {
+          inLinks[change.removedLinks[j]->GetLinkId ()];
+        }
+      for (uint32_t j = 0; j < change.addedLinks.size (); j++)
+        {
+          inLinks[change.addedLinks[j]->GetLinkId ()];
+        }
+    }
+//
+// Find the point-to-point links to the vertices at the end of the changed
+// links, which are the leaves that SPFUpdateTree () may attach again.
+//
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); !inLinks.empty () && i != listEnd; i++)
+    {
+      Ptr<GlobalRouter> rtr = (*i)->GetObject<GlobalRouter> ();
+      GlobalRoutingLSA *lsa = rtr ? m_lsdb->GetLSA (rtr->GetRouterId ()) : 0;
+      if (lsa == 0 || lsa->GetLSType () != GlobalRoutingLSA::RouterLSA)
+        {
+          continue;
+        }
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (j);
+          SPFInLinks_t::iterator links = inLinks.find (l->GetLinkId ());
+          if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint && links != inLinks.end ())
+            {
+              links->second.push_back (std::make_pair (lsa->GetLinkStateId (), l->GetMetric ()));
+            }
+        }
+    }
+
+  uint32_t nCalculated = 0;
+  uint32_t nUpdated = 0;
+  m_spfReplaceRoutes = true;
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<Node> node = *i;
+      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
+      if (rtr == 0 || node->GetSystemId () != Simulator::GetSystemId ())
+        {
+          continue;
+        }
+      Ipv4Address root = rtr->GetRouterId ();
+      if (rtr->GetNumLSAs () == 0)
+        {
+//
+// The router had routes but does not participate in routing any more.
+//
+          if (m_spfTrees.erase (root))
+            {
+              rtr->GetRoutingProtocol ()->ReplaceRoutes (m_spfHostRoutes, m_spfNetworkRoutes,
+                                                         m_spfExternalRoutes);
+            }
+          continue;
+        }
+      SPFTrees_t::iterator tree = m_spfTrees.find (root);
+      std::set<Ipv4Address> hosts;
+      std::set<std::pair<Ipv4Address, Ipv4Address> > stubs;
+      if (externalsChanged || tree == m_spfTrees.end ()
+          || !SPFUpdateTree (root, tree->second, changes, inLinks, hosts, stubs))
+        {
+          SPFCalculate (root);
+          nCalculated++;
+        }
+      else if (!hosts.empty () || !stubs.empty ())
+        {
+          SPFUpdateRoutes (rtr->GetRoutingProtocol (), root, tree->second, hosts, stubs);
+          nUpdated++;
+        }
+    }
+  m_spfReplaceRoutes = false;
+  NS_LOG_INFO ("Computed the routes of " << nCalculated << " routers and updated the " <<
+               "routes of " << nUpdated << " routers");
+  delete oldLsdb;
+}
+
+//
+// Link records are compared by type, link ID, link data and metric, to find
+// the links added to or removed from an LSA.
+//
+static bool
+LinkRecordLess (const GlobalRoutingLinkRecord *a, const GlobalRoutingLinkRecord *b)
+{
+  if (a->GetLinkType () != b->GetLinkType ())
+    {
+      return a->GetLinkType () < b->GetLinkType ();
+    }
+  if (a->GetLinkId () != b->GetLinkId ())
+    {
+      return a->GetLinkId () < b->GetLinkId ();
+    }
+  if (a->GetLinkData () != b->GetLinkData ())
+    {
+      return a->GetLinkData () < b->GetLinkData ();
+    }
+  return a->GetMetric () < b->GetMetric ();
+}
+
+void
+GlobalRouteManagerImpl::SPFGetLinkChanges (SPFChange &change)
+{
+  NS_LOG_FUNCTION (&change);
+  GlobalRoutingLSA *lsas[2] = { change.oldLsa, change.newLsa };
+  std::vector<GlobalRoutingLinkRecord *> links[2];
+  std::vector<Ipv4Address> hosts[2];
+  std::vector<std::pair<Ipv4Address, Ipv4Address> > stubs[2];
+  for (uint32_t k = 0; k < 2; k++)
+    {
+      if (lsas[k] == 0 || lsas[k]->GetLSType () != GlobalRoutingLSA::RouterLSA)
+        {
+          continue;
+        }
+      for (uint32_t j = 0; j < lsas[k]->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *l = lsas[k]->GetLinkRecord (j);
+          if (l->GetLinkType () == GlobalRoutingLinkRecord::StubNetwork)
+            {
+              Ipv4Mask mask (l->GetLinkData ().Get ());
+              stubs[k].push_back (std::make_pair (l->GetLinkId ().CombineMask (mask),
+                                                  l->GetLinkData ()));
+              continue;
+            }
+          if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
+            {
+              hosts[k].push_back (l->GetLinkData ());
+            }
+          links[k].push_back (l);
+        }
+      std::sort (links[k].begin (), links[k].end (), &LinkRecordLess);
+      std::sort (hosts[k].begin (), hosts[k].end ());
+      std::sort (stubs[k].begin (), stubs[k].end ());
+    }
+  std::set_difference (links[0].begin (), links[0].end (), links[1].begin (), links[1].end (),
+                       std::back_inserter (change.removedLinks), &LinkRecordLess);
+  std::set_difference (links[1].begin (), links[1].end (), links[0].begin (), links[0].end (),
+                       std::back_inserter (change.addedLinks), &LinkRecordLess);
+  std::set_symmetric_difference (hosts[0].begin (), hosts[0].end (),
+                                 hosts[1].begin (), hosts[1].end (),
+                                 std::back_inserter (change.hosts));
+  std::set_symmetric_difference (stubs[0].begin (), stubs[0].end (),
+                                 stubs[1].begin (), stubs[1].end (),
+                                 std::back_inserter (change.stubs));
+}
+
+bool
+GlobalRouteManagerImpl::SPFUpdateTree (Ipv4Address root, SPFTree &tree,
+                                       const SPFChanges_t &changes,
+                                       const SPFInLinks_t &inLinks,
+                                       std::set<Ipv4Address> &hosts,
+                                       std::set<std::pair<Ipv4Address, Ipv4Address> > &stubs)
+{
+  NS_LOG_FUNCTION (this << root << &tree);
+  if (tree.stub)
+    {
+//
+// The default route of a stub node only depends on its LSA and on the LSA
+// of its neighbor, which are the vertices kept in the tree.
+//
+      for (SPFChanges_t::const_iterator i = changes.begin (); i != changes.end (); i++)
+        {
+          if (tree.vertices.count (i->first))
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+
+  std::set<Ipv4Address> leaves;
+  for (SPFChanges_t::const_iterator i = changes.begin (); i != changes.end (); i++)
+    {
+      const SPFChange &change = i->second;
+      std::unordered_map<Ipv4Address, SPFTreeVertex, Ipv4AddressHash>::const_iterator v =
+        tree.vertices.find (i->first);
+      if (v == tree.vertices.end ())
+        {
+//
+// A router LSA which is not in the tree can only become reachable through a
+// changed link of a vertex in the tree, or through a transit network in the
+// tree, which finds its attached routers by the Link Data of their
+// TransitNetwork link records.
+//
+          for (uint32_t k = 0; k < 2; k++)
+            {
+              const std::vector<GlobalRoutingLinkRecord *> &links =
+                k ? change.addedLinks : change.removedLinks;
+              for (uint32_t j = 0; j < links.size (); j++)
+                {
+                  if (links[j]->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork
+                      && tree.vertices.count (links[j]->GetLinkId ()))
+                    {
+                      return false;
+                    }
+                }
+            }
+          continue;
+        }
+      if (i->first == root || change.oldLsa == 0 || change.newLsa == 0
+          || change.oldLsa->GetLSType () != GlobalRoutingLSA::RouterLSA
+          || change.newLsa->GetLSType () != GlobalRoutingLSA::RouterLSA)
+        {
+          return false;
+        }
+//
+// A removed link of the tree changes the path to the vertex at its end,
+// and so does an added link giving a path as short as the one in the tree.
+// The next hops to a vertex adjacent to the root are found from its links
+// back to the root, and the ones through a transit network from its
+// TransitNetwork links, so changing these links is not handled here.
+//
+      for (uint32_t j = 0; j < change.removedLinks.size (); j++)
+        {
+          GlobalRoutingLinkRecord *l = change.removedLinks[j];
+          if (l->GetLinkId () == root)
+            {
+              return false;
+            }
+          std::unordered_map<Ipv4Address, SPFTreeVertex, Ipv4AddressHash>::const_iterator w =
+            tree.vertices.find (l->GetLinkId ());
+          if (w == tree.vertices.end ())
+            {
+              continue;
+            }
+          if (l->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+            {
+              return false;
+            }
+          if (std::find (w->second.parents.begin (), w->second.parents.end (), i->first)
+              != w->second.parents.end ())
+            {
+              leaves.insert (l->GetLinkId ());
+            }
+        }
+      for (uint32_t j = 0; j < change.addedLinks.size (); j++)
+        {
+          GlobalRoutingLinkRecord *l = change.addedLinks[j];
+          if (l->GetLinkId () == root || l->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+            {
+              return false;
+            }
+          std::unordered_map<Ipv4Address, SPFTreeVertex, Ipv4AddressHash>::const_iterator w =
+            tree.vertices.find (l->GetLinkId ());
+          if (w == tree.vertices.end ()
+              || v->second.distance + l->GetMetric () <= w->second.distance)
+            {
+              leaves.insert (l->GetLinkId ());
+            }
+        }
+      hosts.insert (change.hosts.begin (), change.hosts.end ());
+      stubs.insert (change.stubs.begin (), change.stubs.end ());
+    }
+  if (leaves.empty ())
+    {
+      return true;
+    }
+  if (m_lsdb->GetNumExtLSAs () > 0)
+    {
+      return false;
+    }
+
+//
+// The vertices at the end of the changed links must be leaves of the tree
+// (or new vertices), so that the paths to the other vertices do not change.
+//
+  std::set<Ipv4Address> parents;
+  for (std::unordered_map<Ipv4Address, SPFTreeVertex, Ipv4AddressHash>::const_iterator i =
+         tree.vertices.begin (); i != tree.vertices.end (); i++)
+    {
+      parents.insert (i->second.parents.begin (), i->second.parents.end ());
+    }
+  for (std::set<Ipv4Address>::const_iterator i = leaves.begin (); i != leaves.end (); i++)
+    {
+      if (parents.count (*i))
+        {
+          return false;
+        }
+    }
+
+  bool attached = false;
+  for (std::set<Ipv4Address>::const_iterator i = leaves.begin (); i != leaves.end (); i++)
+    {
+      GlobalRoutingLSA *lsa = m_lsdb->GetLSA (*i);
+      SPFInLinks_t::const_iterator links = inLinks.find (*i);
+      if (lsa == 0 || lsa->GetLSType () != GlobalRoutingLSA::RouterLSA || links == inLinks.end ())
+        {
+          return false;
+        }
+//
+// The shortest paths to the leaf go through its links from the routers in
+// the tree, which are not the root (as the next hops would then be found
+// from the link records of the leaf).
+//
+      SPFTreeVertex leaf;
+      leaf.distance = SPF_INFINITY;
+      for (uint32_t j = 0; j < links->second.size (); j++)
+        {
+          Ipv4Address from = links->second[j].first;
+          std::unordered_map<Ipv4Address, SPFTreeVertex, Ipv4AddressHash>::const_iterator v =
+            tree.vertices.find (from);
+          if (v == tree.vertices.end () || from == *i)
+            {
+              continue;
+            }
+          if (from == root || leaves.count (from))
+            {
+              return false;
+            }
+          uint32_t distance = v->second.distance + links->second[j].second;
+          if (distance < leaf.distance)
+            {
+              leaf.distance = distance;
+              leaf.parents.clear ();
+              leaf.exits.clear ();
+            }
+          if (distance == leaf.distance
+              && std::find (leaf.parents.begin (), leaf.parents.end (), from) == leaf.parents.end ())
+            {
+              leaf.parents.push_back (from);
+              leaf.exits.insert (leaf.exits.end (), v->second.exits.begin (), v->second.exits.end ());
+            }
+        }
+      std::sort (leaf.exits.begin (), leaf.exits.end ());
+      leaf.exits.erase (std::unique (leaf.exits.begin (), leaf.exits.end ()), leaf.exits.end ());
+
+//
+// The leaf must not give a path as short as the one in the tree to another
+// vertex, and it must not be attached to a transit network.
+//
+      GlobalRoutingLSA *lsas[2] = { lsa, 0 };
+      SPFChanges_t::const_iterator change = changes.find (*i);
+      if (change != changes.end ())
+        {
+          lsas[1] = change->second.oldLsa;
+        }
+      for (uint32_t k = 0; k < 2; k++)
+        {
+          for (uint32_t j = 0; lsas[k] && j < lsas[k]->GetNLinkRecords (); j++)
+            {
+              GlobalRoutingLinkRecord *l = lsas[k]->GetLinkRecord (j);
+              if (l->GetLinkType () == GlobalRoutingLinkRecord::TransitNetwork)
+                {
+                  return false;
+                }
+              if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
+                {
+                  hosts.insert (l->GetLinkData ());
+                  if (k == 0 && !leaf.parents.empty ())
+                    {
+                      std::unordered_map<Ipv4Address, SPFTreeVertex, Ipv4AddressHash>::const_iterator w =
+                        tree.vertices.find (l->GetLinkId ());
+                      if (w == tree.vertices.end () || leaves.count (l->GetLinkId ())
+                          || leaf.distance + l->GetMetric () <= w->second.distance)
+                        {
+                          return false;
+                        }
+                    }
+                }
+              else if (l->GetLinkType () == GlobalRoutingLinkRecord::StubNetwork)
+                {
+                  Ipv4Mask mask (l->GetLinkData ().Get ());
+                  stubs.insert (std::make_pair (l->GetLinkId ().CombineMask (mask),
+                                                l->GetLinkData ()));
+                }
+            }
+        }
+
+      if (leaf.parents.empty ())
+        {
+          NS_LOG_LOGIC ("Removing leaf " << *i << " from the tree of " << root);
+          tree.vertices.erase (*i);
+        }
+      else
+        {
+          NS_LOG_LOGIC ("Attaching leaf " << *i << " to the tree of " << root <<
+                        " with distance " << leaf.distance);
+          tree.vertices[*i] = leaf;
+          attached = true;
+        }
+    }
+//
+// Removing leaves does not change the order of the other vertices.
+//
+  return !attached || SPFOrderTree (root, tree);
+}
+
+//
+// The SPF calculation adds the vertices to the tree by increasing distance
+// from the root, with the network vertices before the router vertices at
+// the same distance.  Otherwise, the vertices are added in the order in which
+// their distance was found, that is, by the order of the first parent that
+// was added to the tree, and then by the order of the link to the vertex in
+// the LSA of this parent.  The stubs are then processed in the depth-first
+// order of the tree, with the children of each vertex in the order in which
+// they were added to the tree.
+//
+bool
+GlobalRouteManagerImpl::SPFOrderTree (Ipv4Address root, SPFTree &tree) const
+{
+  NS_LOG_FUNCTION (this << root << &tree);
+  typedef std::unordered_map<Ipv4Address, SPFTreeVertex, Ipv4AddressHash> Vertices_t;
+  std::vector<std::pair<std::pair<uint64_t, uint64_t>, Ipv4Address> > order;
+  for (Vertices_t::const_iterator v = tree.vertices.begin (); v != tree.vertices.end (); v++)
+    {
+      if (v->first == root)
+        {
+          continue;
+        }
+      GlobalRoutingLSA *lsa = m_lsdb->GetLSA (v->first);
+      NS_ASSERT (lsa && !v->second.parents.empty ());
+      uint64_t type = (lsa->GetLSType () == GlobalRoutingLSA::NetworkLSA) ? 0 : 1;
+      Vertices_t::const_iterator parent = tree.vertices.end ();
+      for (uint32_t j = 0; j < v->second.parents.size (); j++)
+        {
+          Vertices_t::const_iterator p = tree.vertices.find (v->second.parents[j]);
+          NS_ASSERT (p != tree.vertices.end ());
+          if (parent == tree.vertices.end () || p->second.popOrder < parent->second.popOrder)
+            {
+              parent = p;
+            }
+        }
+      GlobalRoutingLSA *plsa = m_lsdb->GetLSA (parent->first);
+      uint32_t link = 0;
+      if (plsa->GetLSType () == GlobalRoutingLSA::RouterLSA)
+        {
+          for (; link < plsa->GetNLinkRecords (); link++)
+            {
+              GlobalRoutingLinkRecord *l = plsa->GetLinkRecord (link);
+              if (l->GetLinkType () != GlobalRoutingLinkRecord::StubNetwork
+                  && l->GetLinkId () == v->first
+                  && parent->second.distance + l->GetMetric () == v->second.distance)
+                {
+                  break;
+                }
+            }
+          if (link == plsa->GetNLinkRecords ())
+            {
+              return false;
+            }
+        }
+      else
+        {
+          for (; link < plsa->GetNAttachedRouters (); link++)
+            {
+              GlobalRoutingLSA *w = m_lsdb->GetLSAByLinkData (plsa->GetAttachedRouter (link));
+              if (w && w->GetLinkStateId () == v->first)
+                {
+                  break;
+                }
+            }
+          if (link == plsa->GetNAttachedRouters ())
+            {
+              return false;
+            }
+        }
+      order.push_back (std::make_pair (
+                         std::make_pair ((uint64_t (v->second.distance) << 1) | type,
+                                         (uint64_t (parent->second.popOrder) << 32) | link),
+                         v->first));
+    }
+  std::sort (order.begin (), order.end ());
+
+  std::unordered_map<Ipv4Address, std::vector<Ipv4Address>, Ipv4AddressHash> children;
+  for (uint32_t i = 0; i < order.size (); i++)
+    {
+      SPFTreeVertex &v = tree.vertices[order[i].second];
+      v.popOrder = i + 1;
+      for (uint32_t j = 0; j < v.parents.size (); j++)
+        {
+          children[v.parents[j]].push_back (order[i].second);
+        }
+    }
+
+  std::set<Ipv4Address> processed;
+  std::vector<std::pair<Ipv4Address, uint32_t> > stack;
+  uint32_t stubOrder = 0;
+  tree.vertices[root].stubOrder = stubOrder++;
+  stack.push_back (std::make_pair (root, 0));
+  while (!stack.empty ())
+    {
+      std::vector<Ipv4Address> &next = children[stack.back ().first];
+      if (stack.back ().second == next.size ())
+        {
+          processed.insert (stack.back ().first);
+          stack.pop_back ();
+          continue;
+        }
+      Ipv4Address child = next[stack.back ().second++];
+      if (!processed.count (child))
+        {
+          tree.vertices[child].stubOrder = stubOrder++;
+          stack.push_back (std::make_pair (child, 0));
+        }
+    }
+  return true;
+}
+
+void
+GlobalRouteManagerImpl::SPFUpdateRoutes (Ptr<Ipv4GlobalRouting> routing, Ipv4Address root,
+                                         const SPFTree &tree,
+                                         const std::set<Ipv4Address> &hosts,
+                                         const std::set<std::pair<Ipv4Address, Ipv4Address> > &stubs) const
+{
+  NS_LOG_FUNCTION (this << routing << root << hosts.size () << stubs.size ());
+//
+// Find the link records of the vertices advertising these destinations, in
+// the order in which SPFCalculate () adds their routes: the host routes when
+// the vertex is added to the tree, and the stub routes when the stubs of the
+// vertex are processed.
+//
+  typedef std::pair<std::pair<uint32_t, uint32_t>, Ipv4Address> VertexLink_t;
+  std::vector<VertexLink_t> hostLinks;
+  std::vector<VertexLink_t> stubLinks;
+  for (std::unordered_map<Ipv4Address, SPFTreeVertex, Ipv4AddressHash>::const_iterator v =
+         tree.vertices.begin (); v != tree.vertices.end (); v++)
+    {
+      GlobalRoutingLSA *lsa = m_lsdb->GetLSA (v->first);
+      if (v->first == root || lsa->GetLSType () != GlobalRoutingLSA::RouterLSA)
+        {
+          continue;
+        }
+      for (uint32_t j = 0; j < lsa->GetNLinkRecords (); j++)
+        {
+          GlobalRoutingLinkRecord *l = lsa->GetLinkRecord (j);
+          if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint
+              && hosts.count (l->GetLinkData ()))
+            {
+              hostLinks.push_back (VertexLink_t (std::make_pair (v->second.popOrder, j), v->first));
+            }
+          else if (l->GetLinkType () == GlobalRoutingLinkRecord::StubNetwork
+                   && stubs.count (std::make_pair (
+                                     l->GetLinkId ().CombineMask (Ipv4Mask (l->GetLinkData ().Get ())),
+                                     l->GetLinkData ())))
+            {
+              stubLinks.push_back (VertexLink_t (std::make_pair (v->second.stubOrder, j), v->first));
+            }
+        }
+    }
+  std::sort (hostLinks.begin (), hostLinks.end ());
+  std::sort (stubLinks.begin (), stubLinks.end ());
+
+  std::vector<Ipv4RoutingTableEntry> hostRoutes;
+  for (uint32_t i = 0; i < hostLinks.size (); i++)
+    {
+      const SPFTreeVertex &v = tree.vertices.find (hostLinks[i].second)->second;
+      GlobalRoutingLinkRecord *l =
+        m_lsdb->GetLSA (hostLinks[i].second)->GetLinkRecord (hostLinks[i].first.second);
+      for (uint32_t k = 0; k < v.exits.size (); k++)
+        {
+          if (v.exits[k].second >= 0)
+            {
+              hostRoutes.push_back (Ipv4RoutingTableEntry::CreateHostRouteTo (
+                                      l->GetLinkData (), v.exits[k].first, v.exits[k].second));
+            }
+        }
+    }
+  std::vector<Ipv4RoutingTableEntry> stubRoutes;
+  for (uint32_t i = 0; i < stubLinks.size (); i++)
+    {
+      const SPFTreeVertex &v = tree.vertices.find (stubLinks[i].second)->second;
+      GlobalRoutingLinkRecord *l =
+        m_lsdb->GetLSA (stubLinks[i].second)->GetLinkRecord (stubLinks[i].first.second);
+      Ipv4Mask mask (l->GetLinkData ().Get ());
+      for (uint32_t k = 0; k < v.exits.size (); k++)
+        {
+          if (v.exits[k].second >= 0)
+            {
+              stubRoutes.push_back (Ipv4RoutingTableEntry::CreateNetworkRouteTo (
+                                      l->GetLinkId ().CombineMask (mask), mask,
+                                      v.exits[k].first, v.exits[k].second));
+            }
+        }
+    }
+
+  std::vector<std::pair<Ipv4Address, Ipv4Mask> > networks;
+  for (std::set<std::pair<Ipv4Address, Ipv4Address> >::const_iterator i = stubs.begin ();
+       i != stubs.end (); i++)
+    {
+      networks.push_back (std::make_pair (i->first, Ipv4Mask (i->second.Get ())));
+    }
+  routing->ReplaceRoutesTo (std::vector<Ipv4Address> (hosts.begin (), hosts.end ()), hostRoutes,
+                            networks, stubRoutes);
+}
+
+void
+GlobalRouteManagerImpl::SPFInstallRoutes (void)
 {
   NS_LOG_FUNCTION (this);
-//
-// Walk the list of nodes in the system.
-//
-  NS_LOG_INFO ("About to start SPF calculation");
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+  if (m_spfRootRouting)
     {
-      Ptr<Node> node = *i;
-//
-// Look for the GlobalRouter interface that indicates that the node is
-// participating in routing.
-//
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      uint32_t systemId = Simulator::GetSystemId ();
-      // Ignore nodes that are not assigned to our systemId (distributed sim)
-      if (node->GetSystemId () != systemId) 
+      if (m_spfReplaceRoutes)
         {
-          continue;
+          m_spfRootRouting->ReplaceRoutes (m_spfHostRoutes, m_spfNetworkRoutes,
+                                           m_spfExternalRoutes);
         }
-
-//
-// if the node has a global router interface, then run the global routing
-// algorithms.
-//
-      if (rtr && rtr->GetNumLSAs () )
+      else
         {
-          SPFCalculate (rtr->GetRouterId ());
+          for (std::vector<Ipv4RoutingTableEntry>::const_iterator i = m_spfHostRoutes.begin ();
+               i != m_spfHostRoutes.end (); i++)
+            {
+              m_spfRootRouting->AddHostRouteTo (i->GetDest (), i->GetGateway (),
+                                                i->GetInterface ());
+            }
+          for (std::vector<Ipv4RoutingTableEntry>::const_iterator i = m_spfNetworkRoutes.begin ();
+               i != m_spfNetworkRoutes.end (); i++)
+            {
+              m_spfRootRouting->AddNetworkRouteTo (i->GetDestNetwork (), i->GetDestNetworkMask (),
+                                                   i->GetGateway (), i->GetInterface ());
+            }
+          for (std::vector<Ipv4RoutingTableEntry>::const_iterator i = m_spfExternalRoutes.begin ();
+               i != m_spfExternalRoutes.end (); i++)
+            {
+              m_spfRootRouting->AddASExternalRouteTo (i->GetDestNetwork (), i->GetDestNetworkMask (),
+                                                      i->GetGateway (), i->GetInterface ());
+            }
         }
     }
-  NS_LOG_INFO ("Finished SPF calculation");
+  m_spfHostRoutes.clear ();
+  m_spfNetworkRoutes.clear ();
+  m_spfExternalRoutes.clear ();
+  m_spfRootRouting = 0;
+  m_spfRootIpv4 = 0;
 }
 
 //
@@ -1319,15 +2079,15 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
               if (lr->GetLinkId () == myRouterId)
                 {
                   // Next hop is stored in the LinkID field of lr
-                  Ptr<GlobalRouter> router = rlsa->GetNode ()->GetObject<GlobalRouter> ();
-                  NS_ASSERT (router);
-                  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-                  NS_ASSERT (gr);
-                  gr->AddNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"), lr->GetLinkData (), 
-                                         FindOutgoingInterfaceId (transitLink->GetLinkData ()));
+                  m_spfNetworkRoutes.push_back (
+                    Ipv4RoutingTableEntry::CreateNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("0.0.0.0"),
+                                                                 lr->GetLinkData (),
+                                                                 FindOutgoingInterfaceId (transitLink->GetLinkData ())));
                   NS_LOG_LOGIC ("Inserting default route for node " << myRouterId << " to next hop " << 
                                 lr->GetLinkData () << " via interface " << 
                                 FindOutgoingInterfaceId (transitLink->GetLinkData ()));
+                  // The default route also depends on the LSA of the neighbor
+                  m_spfTree->vertices[w_lsa->GetLinkStateId ()];
                   return true;
                 }
             }
@@ -1368,6 +2128,35 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
   v->SetDistanceFromRoot (0);
   v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
   NS_LOG_LOGIC ("Starting SPFCalculate for node " << root);
+//
+// Find the node corresponding to the root of the tree, which is the one
+// whose routing table we are going to write, once for the whole calculation.
+//
+  m_spfRootIpv4 = 0;
+  m_spfRootRouting = 0;
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<GlobalRouter> rtr = (*i)->GetObject<GlobalRouter> ();
+      if (rtr != 0 && rtr->GetRouterId () == root)
+        {
+          m_spfRootIpv4 = (*i)->GetObject<Ipv4> ();
+          NS_ASSERT_MSG (m_spfRootIpv4, 
+                         "GlobalRouteManagerImpl::SPFCalculate (): "
+                         "GetObject for <Ipv4> interface failed");
+          m_spfRootRouting = rtr->GetRoutingProtocol ();
+          NS_ASSERT (m_spfRootRouting);
+          break;
+        }
+    }
+//
+// Record the shortest-path tree of this node, for UpdateRoutes ().
+//
+  m_spfTree = &m_spfTrees[root];
+  m_spfTree->stub = false;
+  m_spfTree->vertices.clear ();
+  m_spfTree->vertices[root] = SPFTreeVertex ();
+  uint32_t popOrder = 0;
 
 //
 // Optimize SPF calculation, for ns-3.
@@ -1379,7 +2168,10 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
   if (NodeList::GetNNodes () > 0 && CheckForStubNode (root))
     {
       NS_LOG_LOGIC ("SPFCalculate truncated for stub node " << root);
+      m_spfTree->stub = true;
+      SPFInstallRoutes ();
       delete m_spfroot;
+      m_spfroot = 0;
       return;
     }
 
@@ -1423,6 +2215,19 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
       NS_LOG_LOGIC (candidate);
       v = candidate.Pop ();
       NS_LOG_LOGIC ("Popped vertex " << v->GetVertexId ());
+      SPFTreeVertex &treeVertex = m_spfTree->vertices[v->GetVertexId ()];
+      treeVertex.distance = v->GetDistanceFromRoot ();
+      treeVertex.popOrder = ++popOrder;
+      treeVertex.parents.clear ();
+      for (uint32_t i = 0; v->GetParent (i) != 0; i++)
+        {
+          treeVertex.parents.push_back (v->GetParent (i)->GetVertexId ());
+        }
+      treeVertex.exits.clear ();
+      for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+        {
+          treeVertex.exits.push_back (v->GetRootExitDirection (i));
+        }
 //
 // Update the status field of the vertex to indicate that it is in the SPF
 // tree.
@@ -1485,6 +2290,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
     }  // end for loop
 
 // Second stage of SPF calculation procedure
+  m_spfStubOrder = 0;
   SPFProcessStubs (m_spfroot);
   for (uint32_t i = 0; i < m_lsdb->GetNumExtLSAs (); i++)
     {
@@ -1496,9 +2302,11 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 
 //
 // We're all done setting the routing information for the node at the root of
-// the SPF tree.  Delete all of the vertices and corresponding resources.  Go
-// possibly do it again for the next router.
+// the SPF tree.  Write it to the routing table of the node, delete all of the
+// vertices and corresponding resources.  Go possibly do it again for the next
+// router.
 //
+  SPFInstallRoutes ();
   delete m_spfroot;
   m_spfroot = 0;
 }
@@ -1554,110 +2362,50 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
     }
   NS_LOG_LOGIC ("External is on remote host: " 
                 << extlsa->GetAdvertisingRouter () << "; installing");
-
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The routes are written to the node at the root of the SPF tree, which
+// SPFCalculate () found before starting the calculation.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  if (m_spfRootRouting == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
+      NS_LOG_LOGIC ("No GlobalRouter interface for root " << m_spfroot->GetVertexId ());
+      return;
+    }
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFAddASExternal (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = extlsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+//
+// The vertex <v> is the router advertising the external network.  It has
+// the next hop addresses and the outbound interfaces on the root that lead
+// to it precalculated for us.
+//
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
         {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << node->GetId ());
-          continue;
+          m_spfExternalRoutes.push_back (
+            Ipv4RoutingTableEntry::CreateNetworkRouteTo (tempip, tempmask, nextHop, outIf));
+          NS_LOG_LOGIC ("(Route " << i << ") Root " << m_spfroot->GetVertexId () <<
+                        " add external network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
+      else
         {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
-//
-// Get the Global Router Link State Advertisement from the vertex we're
-// adding the routes to.  The LSA will have a number of attached Global Router
-// Link Records corresponding to links off of that vertex / node.  We're going
-// to be interested in the records corresponding to point-to-point links.
-//
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = extlsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = extlsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-
-//
-// Here's why we did all of that work.  We're going to add a host route to the
-// host address found in the m_linkData field of the point-to-point link
-// record.  In the case of a point-to-point link, this is the local IP address
-// of the node connected to the link.  Each of these point-to-point links
-// will correspond to a local interface that has an IP address to which
-// the node at the root of the SPF tree can send packets.  The vertex <v> 
-// (corresponding to the node that has these links and interfaces) has 
-// an m_nextHop address precalculated for us that is the address to which the
-// root node should send packets to be forwarded to these IP addresses.
-// Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
-// which the packets should be send for forwarding.
-//
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddASExternalRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add external network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+          NS_LOG_LOGIC ("(Route " << i << ") Root " << m_spfroot->GetVertexId () <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 
@@ -1669,6 +2417,7 @@ GlobalRouteManagerImpl::SPFProcessStubs (SPFVertex* v)
 {
   NS_LOG_FUNCTION (this << v);
   NS_LOG_LOGIC ("Processing stubs for " << v->GetVertexId ());
+  m_spfTree->vertices[v->GetVertexId ()].stubOrder = m_spfStubOrder++;
   if (v->GetVertexType () == SPFVertex::VertexRouter)
     {
       GlobalRoutingLSA *rlsa = v->GetLSA ();
@@ -1718,117 +2467,50 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
     }
   NS_LOG_LOGIC ("Stub is on remote host: " << v->GetVertexId () << "; installing");
 //
-// The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
+// The routes are written to the node at the root of the SPF tree, which
+// SPFCalculate () found before starting the calculation.
 //
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  if (m_spfRootRouting == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
+      NS_LOG_LOGIC ("No GlobalRouter interface for root " << m_spfroot->GetVertexId ());
+      return;
+    }
+  NS_ASSERT_MSG (v->GetLSA (), 
+                 "GlobalRouteManagerImpl::SPFIntraAddStub (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask (l->GetLinkData ().Get ());
+  Ipv4Address tempip = l->GetLinkId ();
+  tempip = tempip.CombineMask (tempmask);
+//
+// We're going to add a network route to the stub network found in the link
+// record.  The vertex <v> (corresponding to the node that has the stub
+// network) has the next hop addresses and the outbound interfaces on the
+// root precalculated for us.
+//
+  // walk through all next-hop-IPs and out-going-interfaces for reaching
+  // the stub network gateway 'v' from the root node
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
+      if (outIf >= 0)
         {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
+          m_spfNetworkRoutes.push_back (
+            Ipv4RoutingTableEntry::CreateNetworkRouteTo (tempip, tempmask, nextHop, outIf));
+          NS_LOG_LOGIC ("(Route " << i << ") Root " << m_spfroot->GetVertexId () <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
+      else
         {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to QI
-// for that interface.  If the node is acting as an IP version 4 router, it
-// should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "QI for <Ipv4> interface failed");
-//
-// Get the Global Router Link State Advertisement from the vertex we're
-// adding the routes to.  The LSA will have a number of attached Global Router
-// Link Records corresponding to links off of that vertex / node.  We're going
-// to be interested in the records corresponding to point-to-point links.
-//
-          NS_ASSERT_MSG (v->GetLSA (), 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask (l->GetLinkData ().Get ());
-          Ipv4Address tempip = l->GetLinkId ();
-          tempip = tempip.CombineMask (tempmask);
-//
-// Here's why we did all of that work.  We're going to add a host route to the
-// host address found in the m_linkData field of the point-to-point link
-// record.  In the case of a point-to-point link, this is the local IP address
-// of the node connected to the link.  Each of these point-to-point links
-// will correspond to a local interface that has an IP address to which
-// the node at the root of the SPF tree can send packets.  The vertex <v> 
-// (corresponding to the node that has these links and interfaces) has 
-// an m_nextHop address precalculated for us that is the address to which the
-// root node should send packets to be forwarded to these IP addresses.
-// Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
-// which the packets should be send for forwarding.
-//
-
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all next-hop-IPs and out-going-interfaces for reaching
-          // the stub network gateway 'v' from the root node
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative");
-                }
-            }
-          return;
-        } // if
-    } // for
+          NS_LOG_LOGIC ("(Route " << i << ") Root " << m_spfroot->GetVertexId () <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative");
+        }
+    }
 }
 
 //
@@ -1843,70 +2525,27 @@ GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
 {
   NS_LOG_FUNCTION (this << a << amask);
 //
-// We have an IP address <a> and a vertex ID of the root of the SPF tree.
-// The question is what interface index does this address correspond to.
-// The answer is a little complicated since we have to find a pointer to
-// the node corresponding to the vertex ID, find the Ipv4 interface on that
-// node in order to iterate the interfaces and find the one corresponding to
-// the address in question.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
+// We have an IP address <a> and the Ipv4 interface of the node at the root
+// of the SPF tree (found by SPFCalculate ()).  Look through the interfaces
+// on this node for one that has the IP address we're looking for.  If we
+// find one, return the corresponding interface index, or -1 if not found.
 //
-// Walk the list of nodes in the system looking for the one corresponding to
-// the node at the root of the SPF tree.  This is the node for which we are
-// building the routing table.
-//
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  if (m_spfRootIpv4 == 0)
     {
-      Ptr<Node> node = *i;
-
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-//
-// If the node doesn't have a GlobalRouter interface it can't be the one
-// we're interested in.
-//
-      if (rtr == 0)
-        {
-          continue;
-        }
-
-      if (rtr->GetRouterId () == routerId)
-        {
-//
-// This is the node we're building the routing table for.  We're going to need
-// the Ipv4 interface to look for the ipv4 interface index.  Since this node
-// is participating in routing IP version 4 packets, it certainly must have 
-// an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::FindOutgoingInterfaceId (): "
-                         "GetObject for <Ipv4> interface failed");
-//
-// Look through the interfaces on this node for one that has the IP address
-// we're looking for.  If we find one, return the corresponding interface
-// index, or -1 if not found.
-//
-          int32_t interface = ipv4->GetInterfaceForPrefix (a, amask);
+      NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " <<
+                    m_spfroot->GetVertexId ());
+      return -1;
+    }
+  int32_t interface = m_spfRootIpv4->GetInterfaceForPrefix (a, amask);
 
 #if 0
-          if (interface < 0)
-            {
-              NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
-                              "Expected an interface associated with address a:" << a);
-            }
-#endif 
-          return interface;
-        }
+  if (interface < 0)
+    {
+      NS_FATAL_ERROR ("GlobalRouteManagerImpl::FindOutgoingInterfaceId(): "
+                      "Expected an interface associated with address a:" << a);
     }
-//
-// Couldn't find it.
-//
-  NS_LOG_LOGIC ("FindOutgoingInterfaceId():Can't find root node " << routerId);
-  return -1;
+#endif 
+  return interface;
 }
 
 //
@@ -1933,70 +2572,26 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
   NS_ASSERT_MSG (m_spfroot, 
                  "GlobalRouteManagerImpl::SPFIntraAddRouter (): Root pointer not set");
 //
-// The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The routes are written to the node at the root of the SPF tree, which
+// SPFCalculate () found before starting the calculation.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  if (m_spfRootRouting == 0)
     {
-      Ptr<Node> node = *i;
-//
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
-
-      if (rtr == 0)
-        {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
-        }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
-        {
-          NS_LOG_LOGIC ("Setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "GetObject for <Ipv4> interface failed");
+      NS_LOG_LOGIC ("No GlobalRouter interface for root " << m_spfroot->GetVertexId ());
+      return;
+    }
 //
 // Get the Global Router Link State Advertisement from the vertex we're
 // adding the routes to.  The LSA will have a number of attached Global Router
 // Link Records corresponding to links off of that vertex / node.  We're going
 // to be interested in the records corresponding to point-to-point links.
 //
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
-                         "Expected valid LSA in SPFVertex* v");
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddRouter (): "
+                 "Expected valid LSA in SPFVertex* v");
 
-          uint32_t nLinkRecords = lsa->GetNLinkRecords ();
+  uint32_t nLinkRecords = lsa->GetNLinkRecords ();
 //
 // Iterate through the link records on the vertex to which we're going to add
 // routes.  To make sure we're being clear, we're going to add routing table
@@ -2005,69 +2600,50 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 // the local side of the point-to-point links found on the node described by
 // the vertex <v>.
 //
-          NS_LOG_LOGIC (" Node " << node->GetId () <<
-                        " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
-          for (uint32_t j = 0; j < nLinkRecords; ++j)
-            {
+  NS_LOG_LOGIC (" Root " << m_spfroot->GetVertexId () <<
+                " found " << nLinkRecords << " link records in LSA " << lsa << "with LinkStateId "<< lsa->GetLinkStateId ());
+  for (uint32_t j = 0; j < nLinkRecords; ++j)
+    {
 //
 // We are only concerned about point-to-point links
 //
-              GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
-              if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
-                {
-                  continue;
-                }
-//
-// Here's why we did all of that work.  We're going to add a host route to the
-// host address found in the m_linkData field of the point-to-point link
-// record.  In the case of a point-to-point link, this is the local IP address
-// of the node connected to the link.  Each of these point-to-point links
-// will correspond to a local interface that has an IP address to which
-// the node at the root of the SPF tree can send packets.  The vertex <v> 
-// (corresponding to the node that has these links and interfaces) has 
-// an m_nextHop address precalculated for us that is the address to which the
-// root node should send packets to be forwarded to these IP addresses.
-// Similarly, the vertex <v> has an m_rootOif (outbound interface index) to
-// which the packets should be send for forwarding.
-//
-              Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-              if (router == 0)
-                {
-                  continue;
-                }
-              Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-              NS_ASSERT (gr);
-              // walk through all available exit directions due to ECMP,
-              // and add host route for each of the exit direction toward
-              // the vertex 'v'
-              for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-                {
-                  SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-                  Ipv4Address nextHop = exit.first;
-                  int32_t outIf = exit.second;
-                  if (outIf >= 0)
-                    {
-                      gr->AddHostRouteTo (lr->GetLinkData (), nextHop,
-                                          outIf);
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " adding host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " and outgoing interface " << outIf);
-                    }
-                  else
-                    {
-                      NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                    " NOT able to add host route to " << lr->GetLinkData () <<
-                                    " using next hop " << nextHop <<
-                                    " since outgoing interface id is negative " << outIf);
-                    }
-                } // for all routes from the root the vertex 'v'
-            }
+      GlobalRoutingLinkRecord *lr = lsa->GetLinkRecord (j);
+      if (lr->GetLinkType () != GlobalRoutingLinkRecord::PointToPoint)
+        {
+          continue;
+        }
 //
-// Done adding the routes for the selected node.
+// We're going to add a host route to the host address found in the
+// m_linkData field of the point-to-point link record.  In the case of a
+// point-to-point link, this is the local IP address of the node connected
+// to the link.  The vertex <v> has the next hop addresses and the outbound
+// interfaces on the root precalculated for us.
 //
-          return;
-        }
+      // walk through all available exit directions due to ECMP,
+      // and add host route for each of the exit direction toward
+      // the vertex 'v'
+      for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+        {
+          SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+          Ipv4Address nextHop = exit.first;
+          int32_t outIf = exit.second;
+          if (outIf >= 0)
+            {
+              m_spfHostRoutes.push_back (
+                Ipv4RoutingTableEntry::CreateHostRouteTo (lr->GetLinkData (), nextHop, outIf));
+              NS_LOG_LOGIC ("(Route " << i << ") Root " << m_spfroot->GetVertexId () <<
+                            " adding host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " and outgoing interface " << outIf);
+            }
+          else
+            {
+              NS_LOG_LOGIC ("(Route " << i << ") Root " << m_spfroot->GetVertexId () <<
+                            " NOT able to add host route to " << lr->GetLinkData () <<
+                            " using next hop " << nextHop <<
+                            " since outgoing interface id is negative " << outIf);
+            }
+        } // for all routes from the root the vertex 'v'
     }
 }
 void
@@ -2078,105 +2654,52 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
   NS_ASSERT_MSG (m_spfroot, 
                  "GlobalRouteManagerImpl::SPFIntraAddTransit (): Root pointer not set");
 //
-// The root of the Shortest Path First tree is the router to which we are 
-// going to write the actual routing table entries.  The vertex corresponding
-// to this router has a vertex ID which is the router ID of that node.  We're
-// going to use this ID to discover which node it is that we're actually going
-// to update.
-//
-  Ipv4Address routerId = m_spfroot->GetVertexId ();
-
-  NS_LOG_LOGIC ("Vertex ID = " << routerId);
-//
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The routes are written to the node at the root of the SPF tree, which
+// SPFCalculate () found before starting the calculation.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  if (m_spfRootRouting == 0)
     {
-      Ptr<Node> node = *i;
+      NS_LOG_LOGIC ("No GlobalRouter interface for root " << m_spfroot->GetVertexId ());
+      return;
+    }
 //
-// The router ID is accessible through the GlobalRouter interface, so we need
-// to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
-// 
-      Ptr<GlobalRouter> rtr = 
-        node->GetObject<GlobalRouter> ();
+// Get the Global Router Link State Advertisement from the vertex we're
+// adding the routes to.  For a transit network, it is a network LSA and
+// we add a network route to the transit network.
+//
+  GlobalRoutingLSA *lsa = v->GetLSA ();
+  NS_ASSERT_MSG (lsa, 
+                 "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
+                 "Expected valid LSA in SPFVertex* v");
+  Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
+  Ipv4Address tempip = lsa->GetLinkStateId ();
+  tempip = tempip.CombineMask (tempmask);
+  // walk through all available exit directions due to ECMP,
+  // and add host route for each of the exit direction toward
+  // the vertex 'v'
+  for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
+    {
+      SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
+      Ipv4Address nextHop = exit.first;
+      int32_t outIf = exit.second;
 
-      if (rtr == 0)
+      if (outIf >= 0)
         {
-          NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
-                        node->GetId ());
-          continue;
+          m_spfNetworkRoutes.push_back (
+            Ipv4RoutingTableEntry::CreateNetworkRouteTo (tempip, tempmask, nextHop, outIf));
+          NS_LOG_LOGIC ("(Route " << i << ") Root " << m_spfroot->GetVertexId () <<
+                        " add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " via interface " << outIf);
         }
-//
-// If the router ID of the current node is equal to the router ID of the 
-// root of the SPF tree, then this node is the one for which we need to 
-// write the routing tables.
-//
-      NS_LOG_LOGIC ("Considering router " << rtr->GetRouterId ());
-
-      if (rtr->GetRouterId () == routerId)
+      else
         {
-          NS_LOG_LOGIC ("setting routes for node " << node->GetId ());
-//
-// Routing information is updated using the Ipv4 interface.  We need to 
-// GetObject for that interface.  If the node is acting as an IP version 4 
-// router, it should absolutely have an Ipv4 interface.
-//
-          Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
-          NS_ASSERT_MSG (ipv4, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "GetObject for <Ipv4> interface failed");
-//
-// Get the Global Router Link State Advertisement from the vertex we're
-// adding the routes to.  The LSA will have a number of attached Global Router
-// Link Records corresponding to links off of that vertex / node.  We're going
-// to be interested in the records corresponding to point-to-point links.
-//
-          GlobalRoutingLSA *lsa = v->GetLSA ();
-          NS_ASSERT_MSG (lsa, 
-                         "GlobalRouteManagerImpl::SPFIntraAddTransit (): "
-                         "Expected valid LSA in SPFVertex* v");
-          Ipv4Mask tempmask = lsa->GetNetworkLSANetworkMask ();
-          Ipv4Address tempip = lsa->GetLinkStateId ();
-          tempip = tempip.CombineMask (tempmask);
-          Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-          if (router == 0)
-            {
-              continue;
-            }
-          Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-          NS_ASSERT (gr);
-          // walk through all available exit directions due to ECMP,
-          // and add host route for each of the exit direction toward
-          // the vertex 'v'
-          for (uint32_t i = 0; i < v->GetNRootExitDirections (); i++)
-            {
-              SPFVertex::NodeExit_t exit = v->GetRootExitDirection (i);
-              Ipv4Address nextHop = exit.first;
-              int32_t outIf = exit.second;
-
-              if (outIf >= 0)
-                {
-                  gr->AddNetworkRouteTo (tempip, tempmask, nextHop, outIf);
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " via interface " << outIf);
-                }
-              else
-                {
-                  NS_LOG_LOGIC ("(Route " << i << ") Node " << node->GetId () <<
-                                " NOT able to add network route to " << tempip <<
-                                " using next hop " << nextHop <<
-                                " since outgoing interface id is negative " << outIf);
-                }
-            }
+          NS_LOG_LOGIC ("(Route " << i << ") Root " << m_spfroot->GetVertexId () <<
+                        " NOT able to add network route to " << tempip <<
+                        " using next hop " << nextHop <<
+                        " since outgoing interface id is negative " << outIf);
         }
-    } 
+    }
 }
 
 // Derived from quagga ospf_vertex_add_parents ()
@@ -26,10 +26,13 @@
 #include <list>
 #include <queue>
 #include <map>
+#include <set>
 #include <vector>
+#include <unordered_map>
 #include "ns3/object.h"
 #include "ns3/ptr.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/ipv4-routing-table-entry.h"
 #include "global-router-interface.h"
 
 namespace ns3 {
@@ -37,6 +40,7 @@ namespace ns3 {
 const uint32_t SPF_INFINITY = 0xffffffff; //!< "infinite" distance between nodes
 
 class CandidateQueue;
+class Ipv4;
 class Ipv4GlobalRouting;
 
 /**
@@ -674,6 +678,20 @@ public:
    */
   uint32_t GetNumExtLSAs () const;
 
+  /**
+   * @brief Compare this database with an older one.
+   *
+   * The link state IDs of the LSAs that were added, removed or whose
+   * contents changed are inserted in the changed set.  The SPF status of
+   * the LSAs is not compared.
+   *
+   * @param old The older database.
+   * @param changed The set of link state IDs of the changed LSAs.
+   * @returns True if the External Link State Advertisements changed.
+   */
+  bool GetChangedLSAs (const GlobalRouteManagerLSDB &old,
+                       std::set<Ipv4Address> &changed) const;
+
 
 private:
   typedef std::map<Ipv4Address, GlobalRoutingLSA*> LSDBMap_t; //!< container of IPv4 addresses / Link State Advertisements
@@ -681,6 +699,7 @@ private:
 
   LSDBMap_t m_database; //!< database of IPv4 addresses / Link State Advertisements
   std::vector<GlobalRoutingLSA*> m_extdatabase; //!< database of External Link State Advertisements
+  LSDBMap_t m_linkDataIndex; //!< LSAs indexed by the Link Data of their TransitNetwork link records
 
 /**
  * @brief GlobalRouteManagerLSDB copy construction is disallowed.  There's no 
@@ -735,6 +754,20 @@ public:
  */
   virtual void InitializeRoutes ();
 
+/**
+ * @brief Rebuild the routing database and update the per-node forwarding
+ * tables after a topology change.
+ *
+ * The new Link State Advertisements are compared with the ones used in
+ * the last computation.  The shortest-path tree of each router is kept,
+ * and the SPF calculation only runs again for the routers whose tree is
+ * changed beyond its leaves (such as hosts going up or down).  The other
+ * routers only replace their routes to the destinations advertised by the
+ * changed LSAs and by these leaves.  If routes were never computed (or
+ * were deleted), this falls back to a full computation.
+ */
+  virtual void UpdateRoutes ();
+
 /**
  * @brief Debugging routine; allow client code to supply a pre-built LSDB
  * @param lsdb the pre-built LSDB
@@ -770,6 +803,110 @@ private:
   SPFVertex* m_spfroot; //!< the root node
   GlobalRouteManagerLSDB* m_lsdb; //!< the Link State DataBase (LSDB) of the Global Route Manager
 
+  Ptr<Ipv4> m_spfRootIpv4;                 //!< IPv4 of the node at the SPF root
+  Ptr<Ipv4GlobalRouting> m_spfRootRouting; //!< global routing of the node at the SPF root
+  bool m_spfReplaceRoutes;                 //!< replace (instead of add) the routes of the SPF root
+  std::vector<Ipv4RoutingTableEntry> m_spfHostRoutes;     //!< host routes found for the SPF root
+  std::vector<Ipv4RoutingTableEntry> m_spfNetworkRoutes;  //!< network routes found for the SPF root
+  std::vector<Ipv4RoutingTableEntry> m_spfExternalRoutes; //!< external routes found for the SPF root
+
+  /// State of a vertex in the shortest-path tree of a router
+  struct SPFTreeVertex
+  {
+    uint32_t distance;  //!< distance from the root
+    uint32_t popOrder;  //!< order in which the vertex was added to the tree
+    uint32_t stubOrder; //!< order in which the stubs of the vertex were processed
+    std::vector<Ipv4Address> parents;         //!< IDs of the parent vertices
+    std::vector<SPFVertex::NodeExit_t> exits; //!< root exit directions
+  };
+
+  /// Shortest-path tree kept from the last SPF calculation of a router
+  struct SPFTree
+  {
+    bool stub; //!< the router is a stub node, with only a default route
+    /// vertices of the tree (or, for a stub node, the root and its neighbor)
+    std::unordered_map<Ipv4Address, SPFTreeVertex, Ipv4AddressHash> vertices;
+  };
+
+  /// Changes of a Link State Advertisement, found by UpdateRoutes ()
+  struct SPFChange
+  {
+    GlobalRoutingLSA *oldLsa;                            //!< the LSA of the last calculation (may be null)
+    GlobalRoutingLSA *newLsa;                            //!< the new LSA (may be null)
+    std::vector<GlobalRoutingLinkRecord *> removedLinks; //!< removed transit link records
+    std::vector<GlobalRoutingLinkRecord *> addedLinks;   //!< added transit link records
+    std::vector<Ipv4Address> hosts;                      //!< changed point-to-point addresses
+    std::vector<std::pair<Ipv4Address, Ipv4Address> > stubs; //!< changed stub networks and masks
+  };
+
+  typedef std::map<Ipv4Address, SPFTree> SPFTrees_t;     //!< container of SPF trees by router ID
+  typedef std::map<Ipv4Address, SPFChange> SPFChanges_t; //!< container of LSA changes by link state ID
+  /// container of the (router ID, metric) of the point-to-point links to a router, by router ID
+  typedef std::map<Ipv4Address, std::vector<std::pair<Ipv4Address, uint16_t> > > SPFInLinks_t;
+
+  SPFTrees_t m_spfTrees;   //!< the tree of the last SPF calculation of each router
+  SPFTree *m_spfTree;      //!< the tree recorded by the current SPF calculation
+  uint32_t m_spfStubOrder; //!< counter of the vertices processed by SPFProcessStubs
+
+  /**
+   * \brief Compare the link records of the two versions of a changed LSA.
+   * \param change the LSA change to complete
+   */
+  static void SPFGetLinkChanges (SPFChange &change);
+
+  /**
+   * \brief Update the shortest-path tree of a router with the changed LSAs.
+   *
+   * The tree is unchanged if no link in the tree is removed and no added
+   * link gives a path which is shorter than (or as short as) the one in the
+   * tree.  Otherwise, only the changes restricted to leaves of the tree
+   * (routers which are not in the path to any other vertex, such as hosts)
+   * are handled here: each of these leaves is attached again to the tree
+   * (or removed from it) using its links in the new LSAs.  The routes of the
+   * router then only change for the host and stub destinations advertised
+   * by the changed LSAs and by these leaves, which are inserted in the
+   * given sets.
+   *
+   * \param root the router ID
+   * \param tree the tree of the last SPF calculation of the router
+   * \param changes the changed LSAs
+   * \param inLinks the links to the routers which may be attached again
+   * \param hosts the host destinations whose routes must be rewritten
+   * \param stubs the stub networks (and masks) whose routes must be rewritten
+   * \returns false if the SPF calculation must run again for this router
+   */
+  bool SPFUpdateTree (Ipv4Address root, SPFTree &tree, const SPFChanges_t &changes,
+                      const SPFInLinks_t &inLinks, std::set<Ipv4Address> &hosts,
+                      std::set<std::pair<Ipv4Address, Ipv4Address> > &stubs);
+
+  /**
+   * \brief Compute again the order in which the SPF calculation adds the
+   * vertices of a tree and processes their stubs.
+   * \param root the router ID
+   * \param tree the shortest-path tree of the router
+   * \returns false if the tree does not match the LSAs
+   */
+  bool SPFOrderTree (Ipv4Address root, SPFTree &tree) const;
+
+  /**
+   * \brief Rewrite the routes of a router to some host and stub
+   * destinations, using its shortest-path tree.
+   * \param routing the global routing of the router
+   * \param root the router ID
+   * \param tree the shortest-path tree of the router
+   * \param hosts the host destinations
+   * \param stubs the stub networks and masks
+   */
+  void SPFUpdateRoutes (Ptr<Ipv4GlobalRouting> routing, Ipv4Address root, const SPFTree &tree,
+                        const std::set<Ipv4Address> &hosts,
+                        const std::set<std::pair<Ipv4Address, Ipv4Address> > &stubs) const;
+
+  /**
+   * \brief Install the routes found by the SPF calculation in the
+   * forwarding table of the SPF root.
+   */
+  void SPFInstallRoutes (void);
+
   /**
    * \brief Test if a node is a stub, from an OSPF sense.
    *
@@ -65,6 +65,16 @@ public:
  */
   static void InitializeRoutes ();
 
+/**
+ * @brief Rebuild the routing database and update the per-node forwarding
+ * tables after a topology change, only running the SPF calculation again
+ * for the routers whose routes may have changed.
+ *
+ * This has the same result as calling DeleteGlobalRoutes (),
+ * BuildGlobalRoutingDatabase () and InitializeRoutes ().
+ */
+  static void UpdateRoutes ();
+
 private:
 /**
  * @brief Global Route Manager copy construction is disallowed.  There's no 
@@ -22,6 +22,8 @@
 #include "ipv4-end-point.h"
 #include "ipv4-interface-address.h"
 #include "ns3/log.h"
+#include <algorithm>
+#include <vector>
 
 
 namespace ns3 {
@@ -40,23 +42,20 @@ Ipv4EndPointDemux::~Ipv4EndPointDemux ()
   for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
     {
       Ipv4EndPoint *endPoint = *i;
+      endPoint->m_demux = 0;
       delete endPoint;
     }
   m_endPoints.clear ();
+  m_localEndPoints.clear ();
+  m_connectedEndPoints.clear ();
+  m_ports.clear ();
 }
 
 bool
 Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
 {
   NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
-    {
-      if ((*i)->GetLocalPort  () == port) 
-        {
-          return true;
-        }
-    }
-  return false;
+  return m_ports.find (port) != m_ports.end ();
 }
 
 bool
@@ -86,7 +85,7 @@ Ipv4EndPointDemux::Allocate (void)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -102,7 +101,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -125,7 +124,7 @@ Ipv4EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice, Ipv4Address address,
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
   return endPoint;
 }
@@ -136,7 +135,16 @@ Ipv4EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort << boundNetDevice);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  // A connected end point can only be a duplicate of another connected one
+  EndPoints none;
+  const EndPoints *endPoints = &m_endPoints;
+  if (IsConnected (localAddress, peerAddress, peerPort))
+    {
+      std::unordered_map<TupleKey, EndPoints, TupleKeyHash>::const_iterator bucket =
+        m_connectedEndPoints.find (GetTupleKey (localAddress, localPort, peerAddress, peerPort));
+      endPoints = (bucket != m_connectedEndPoints.end ()) ? &bucket->second : &none;
+    }
+  for (EndPoints::const_iterator i = endPoints->begin (); i != endPoints->end (); i++)
     {
       if ((*i)->GetLocalPort () == localPort &&
           (*i)->GetLocalAddress () == localAddress &&
@@ -150,7 +158,7 @@ Ipv4EndPointDemux::Allocate (Ptr<NetDevice> boundNetDevice,
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
+  Insert (endPoint);
 
   NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
 
@@ -165,6 +173,13 @@ Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
     {
       if (*i == endPoint)
         {
+          RemoveIndex (endPoint);
+          std::unordered_map<uint16_t, uint32_t>::iterator port = m_ports.find (endPoint->GetLocalPort ());
+          if (--port->second == 0)
+            {
+              m_ports.erase (port);
+            }
+          endPoint->m_demux = 0;
           delete endPoint;
           m_endPoints.erase (i);
           break;
@@ -208,9 +223,59 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
   EndPoints retval4; // Exact match on all 4
 
   NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr << ":" << dport);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+
+  // We have 3 cases:
+  // 1) Exact local / destination address match
+  // 2) Local endpoint bound to Any -> matches anything
+  // 3) Local endpoint bound to x.y.z.0 -> matches Subnet-directed broadcast packet (e.g., x.y.z.255 in a /24 net) and direct destination match.
+  // The first local address is the exact match, the others are wildcards.
+  std::vector<Ipv4Address> localAddresses;
+  localAddresses.push_back (daddr);
+  if (daddr != Ipv4Address::GetAny ())
     {
-      Ipv4EndPoint* endP = *i;
+      localAddresses.push_back (Ipv4Address::GetAny ());
+    }
+  for (uint32_t i = 0; incomingInterface && i < incomingInterface->GetNAddresses (); i++)
+    {
+      Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+
+      Ipv4Address addrNetpart = addr.GetLocal ().CombineMask (addr.GetMask ());
+      if (addrNetpart == daddr.CombineMask (addr.GetMask ())
+          && std::find (localAddresses.begin (), localAddresses.end (), addrNetpart) == localAddresses.end ())
+        {
+          NS_LOG_LOGIC ("Looking for SubnetDirectedAny endpoints " << addrNetpart << "/" << addr.GetMask ().GetPrefixLength ());
+          localAddresses.push_back (addrNetpart);
+        }
+    }
+
+  // Only the endpoints bound to these local addresses and to the destination
+  // port can match, and only the connected ones with the packet four-tuple.
+  std::vector<std::pair<Ipv4EndPoint *, bool> > candidates;
+  for (uint32_t i = 0; i < localAddresses.size (); i++)
+    {
+      std::unordered_map<uint64_t, EndPoints>::const_iterator local =
+        m_localEndPoints.find (GetLocalKey (localAddresses[i], dport));
+      if (local != m_localEndPoints.end ())
+        {
+          for (EndPoints::const_iterator j = local->second.begin (); j != local->second.end (); j++)
+            {
+              candidates.push_back (std::make_pair (*j, i == 0));
+            }
+        }
+      std::unordered_map<TupleKey, EndPoints, TupleKeyHash>::const_iterator connected =
+        m_connectedEndPoints.find (GetTupleKey (localAddresses[i], dport, saddr, sport));
+      if (connected != m_connectedEndPoints.end ())
+        {
+          for (EndPoints::const_iterator j = connected->second.begin (); j != connected->second.end (); j++)
+            {
+              candidates.push_back (std::make_pair (*j, i == 0));
+            }
+        }
+    }
+
+  for (uint32_t i = 0; i < candidates.size (); i++)
+    {
+      Ipv4EndPoint* endP = candidates[i].first;
 
       NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
                                                  << " daddr=" << endP->GetLocalAddress ()
@@ -224,14 +289,6 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
           continue;
         }
 
-      if (endP->GetLocalPort () != dport) 
-        {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
-          continue;
-        }
       if (endP->GetBoundNetDevice ())
         {
           if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
@@ -244,49 +301,7 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
             }
         }
 
-      bool localAddressMatchesExact = false;
-      bool localAddressIsAny = false;
-      bool localAddressIsSubnetAny = false;
-
-      // We have 3 cases:
-      // 1) Exact local / destination address match
-      // 2) Local endpoint bound to Any -> matches anything
-      // 3) Local endpoint bound to x.y.z.0 -> matches Subnet-directed broadcast packet (e.g., x.y.z.255 in a /24 net) and direct destination match.
-
-      if (endP->GetLocalAddress () == daddr)
-        {
-          // Case 1:
-          localAddressMatchesExact = true;
-        }
-      else if (endP->GetLocalAddress () == Ipv4Address::GetAny ())
-        {
-          // Case 2:
-          localAddressIsAny = true;
-        }
-      else
-        {
-          // Case 3:
-          for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
-            {
-              Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
-
-              Ipv4Address addrNetpart = addr.GetLocal ().CombineMask (addr.GetMask ());
-              if (endP->GetLocalAddress () == addrNetpart)
-                {
-                  NS_LOG_LOGIC ("Endpoint is SubnetDirectedAny " << endP->GetLocalAddress () << "/" << addr.GetMask ().GetPrefixLength ());
-
-                  Ipv4Address daddrNetPart = daddr.CombineMask (addr.GetMask ());
-                  if (addrNetpart == daddrNetPart)
-                    {
-                      localAddressIsSubnetAny = true;
-                    }
-                }
-            }
-
-          // if no match here, keep looking
-          if (!localAddressIsSubnetAny)
-            continue;
-        }
+      bool localAddressMatchesExact = candidates[i].second;
 
       bool remotePortMatchesExact = endP->GetPeerPort () == sport;
       bool remotePortMatchesWildCard = endP->GetPeerPort () == 0;
@@ -300,7 +315,7 @@ Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport,
       if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
         continue;
 
-      bool localAddressMatchesWildCard = localAddressIsAny || localAddressIsSubnetAny;
+      bool localAddressMatchesWildCard = !localAddressMatchesExact;
 
       if (localAddressMatchesExact && remoteAddressMatchesExact && remotePortMatchesExact)
         { // All 4 match - this is the case of an open TCP connection, for example.
@@ -400,5 +415,86 @@ Ipv4EndPointDemux::AllocateEphemeralPort (void)
   return port;
 }
 
+void
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  m_endPoints.push_back (endPoint);
+  m_ports[endPoint->GetLocalPort ()]++;
+  endPoint->m_demux = this;
+  AddIndex (endPoint);
+}
+
+void
+Ipv4EndPointDemux::AddIndex (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  if (IsConnected (endPoint->GetLocalAddress (), endPoint->GetPeerAddress (), endPoint->GetPeerPort ()))
+    {
+      m_connectedEndPoints[GetTupleKey (endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                                        endPoint->GetPeerAddress (), endPoint->GetPeerPort ())].push_back (endPoint);
+    }
+  else
+    {
+      m_localEndPoints[GetLocalKey (endPoint->GetLocalAddress (), endPoint->GetLocalPort ())].push_back (endPoint);
+    }
+}
+
+void
+Ipv4EndPointDemux::RemoveIndex (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  if (IsConnected (endPoint->GetLocalAddress (), endPoint->GetPeerAddress (), endPoint->GetPeerPort ()))
+    {
+      TupleKey key = GetTupleKey (endPoint->GetLocalAddress (), endPoint->GetLocalPort (),
+                                  endPoint->GetPeerAddress (), endPoint->GetPeerPort ());
+      std::unordered_map<TupleKey, EndPoints, TupleKeyHash>::iterator i = m_connectedEndPoints.find (key);
+      NS_ASSERT (i != m_connectedEndPoints.end ());
+      i->second.remove (endPoint);
+      if (i->second.empty ())
+        {
+          m_connectedEndPoints.erase (i);
+        }
+    }
+  else
+    {
+      uint64_t key = GetLocalKey (endPoint->GetLocalAddress (), endPoint->GetLocalPort ());
+      std::unordered_map<uint64_t, EndPoints>::iterator i = m_localEndPoints.find (key);
+      NS_ASSERT (i != m_localEndPoints.end ());
+      i->second.remove (endPoint);
+      if (i->second.empty ())
+        {
+          m_localEndPoints.erase (i);
+        }
+    }
+}
+
+bool
+Ipv4EndPointDemux::IsConnected (Ipv4Address localAddress, Ipv4Address peerAddress, uint16_t peerPort)
+{
+  return localAddress != Ipv4Address::GetAny ()
+         && peerAddress != Ipv4Address::GetAny ()
+         && peerPort != 0;
+}
+
+uint64_t
+Ipv4EndPointDemux::GetLocalKey (Ipv4Address address, uint16_t port)
+{
+  return (uint64_t (address.Get ()) << 16) | port;
+}
+
+Ipv4EndPointDemux::TupleKey
+Ipv4EndPointDemux::GetTupleKey (Ipv4Address localAddress, uint16_t localPort,
+                                Ipv4Address peerAddress, uint16_t peerPort)
+{
+  return std::make_pair (GetLocalKey (localAddress, localPort), GetLocalKey (peerAddress, peerPort));
+}
+
+size_t
+Ipv4EndPointDemux::TupleKeyHash::operator() (const TupleKey &key) const
+{
+  return std::hash<uint64_t> () (key.first * 0x9e3779b97f4a7c15ULL ^ key.second);
+}
+
 } // namespace ns3
 
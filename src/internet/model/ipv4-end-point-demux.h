@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 #include <list>
+#include <unordered_map>
+#include <utility>
 #include "ns3/ipv4-address.h"
 #include "ipv4-interface.h"
 
@@ -40,6 +42,11 @@ class Ipv4EndPoint;
  * of endpoints, and has APIs to add and find endpoints in this demux.  This
  * code is shared in common to TCP and UDP protocols in ns3.  This demux
  * sits between ns3's layer four and the socket layer
+ *
+ * The endpoints are also indexed by local address and port, and the
+ * connected ones (with a local address, a peer address and a peer port) by
+ * their four-tuple, so that the lookup of a received packet only looks at
+ * the few endpoints which may match it.
  */
 
 class Ipv4EndPointDemux {
@@ -166,6 +173,7 @@ public:
   void DeAllocate (Ipv4EndPoint *endPoint);
 
 private:
+  friend class Ipv4EndPoint;
 
   /**
    * \brief Allocate an ephemeral port.
@@ -173,6 +181,69 @@ private:
    */
   uint16_t AllocateEphemeralPort (void);
 
+  /**
+   * \brief Add an end point to the list and to the indexes.
+   * \param endPoint the end point
+   */
+  void Insert (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Add an end point to the indexes.
+   *
+   * This is called by the end point when its local address or peer changes.
+   *
+   * \param endPoint the end point
+   */
+  void AddIndex (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Remove an end point from the indexes.
+   * \param endPoint the end point
+   */
+  void RemoveIndex (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Check if an end point is indexed by its four-tuple.
+   * \param localAddress local address
+   * \param peerAddress peer address
+   * \param peerPort peer port
+   * \return true if the four-tuple has no wildcard
+   */
+  static bool IsConnected (Ipv4Address localAddress, Ipv4Address peerAddress, uint16_t peerPort);
+
+  /**
+   * \brief Key of the local address and port index.
+   * \param address local address
+   * \param port local port
+   * \return the key
+   */
+  static uint64_t GetLocalKey (Ipv4Address address, uint16_t port);
+
+  /// Key of the four-tuple index: local address and port, peer address and port
+  typedef std::pair<uint64_t, uint64_t> TupleKey;
+
+  /// Hash function of the four-tuple index
+  struct TupleKeyHash
+  {
+    /**
+     * \brief Hash a four-tuple key.
+     * \param key the key
+     * \return the hash
+     */
+    size_t operator() (const TupleKey &key) const;
+  };
+
+  /**
+   * \brief Key of the four-tuple index.
+   * \param localAddress local address
+   * \param localPort local port
+   * \param peerAddress peer address
+   * \param peerPort peer port
+   * \return the key
+   */
+  static TupleKey GetTupleKey (Ipv4Address localAddress, uint16_t localPort,
+                               Ipv4Address peerAddress, uint16_t peerPort);
+
   /**
    * \brief The ephemeral port.
    */
@@ -192,6 +263,21 @@ private:
    * \brief A list of IPv4 end points.
    */
   EndPoints m_endPoints;
+
+  /**
+   * \brief The end points which are not connected, by local address and port.
+   */
+  std::unordered_map<uint64_t, EndPoints> m_localEndPoints;
+
+  /**
+   * \brief The connected end points, by four-tuple.
+   */
+  std::unordered_map<TupleKey, EndPoints, TupleKeyHash> m_connectedEndPoints;
+
+  /**
+   * \brief The number of end points of each local port.
+   */
+  std::unordered_map<uint16_t, uint32_t> m_ports;
 };
 
 } // namespace ns3
@@ -59,7 +59,9 @@ Ipv4GlobalRouting::GetTypeId (void)
 
 Ipv4GlobalRouting::Ipv4GlobalRouting () 
   : m_randomEcmpRouting (false),
-    m_respondToInterfaceEvents (false)
+    m_respondToInterfaceEvents (false),
+    m_lookupTablesValid (false),
+    m_routesVersion (1)
 {
   NS_LOG_FUNCTION (this);
 
@@ -80,6 +82,8 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
   m_hostRoutes.push_back (route);
+  m_lookupTablesValid = false;
+  m_routesVersion++;
 }
 
 void 
@@ -90,6 +94,8 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
   m_hostRoutes.push_back (route);
+  m_lookupTablesValid = false;
+  m_routesVersion++;
 }
 
 void 
@@ -105,6 +111,8 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_lookupTablesValid = false;
+  m_routesVersion++;
 }
 
 void 
@@ -118,6 +126,8 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (route);
+  m_lookupTablesValid = false;
+  m_routesVersion++;
 }
 
 void 
@@ -133,26 +143,108 @@ Ipv4GlobalRouting::AddASExternalRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_ASexternalRoutes.push_back (route);
+  m_lookupTablesValid = false;
+  m_routesVersion++;
 }
 
 
+void
+Ipv4GlobalRouting::InsertPrefix (PrefixTrie &trie, Ipv4RoutingTableEntry *route)
+{
+  uint32_t network = route->GetDestNetwork ().Get ();
+  uint16_t prefixLength = route->GetDestNetworkMask ().GetPrefixLength ();
+  uint32_t node = 0;
+  for (uint16_t depth = 0; depth < prefixLength; depth++)
+    {
+      uint32_t bit = (network >> (31 - depth)) & 1;
+      if (trie[node].child[bit] == 0)
+        {
+          trie[node].child[bit] = trie.size ();
+          trie.push_back (PrefixTrieNode ());
+        }
+      node = trie[node].child[bit];
+    }
+  trie[node].routes.push_back (route);
+}
+
+uint32_t
+Ipv4GlobalRouting::LookupPrefix (const PrefixTrie &trie, Ipv4Address dest,
+                                 uint32_t *matches)
+{
+  uint32_t addr = dest.Get ();
+  uint32_t nMatches = 0;
+  uint32_t node = 0;
+  for (uint16_t depth = 0; ; depth++)
+    {
+      if (!trie[node].routes.empty ())
+        {
+          matches[nMatches++] = node;
+        }
+      if (depth == 32)
+        {
+          break;
+        }
+      node = trie[node].child[(addr >> (31 - depth)) & 1];
+      if (node == 0)
+        {
+          break;
+        }
+    }
+  return nMatches;
+}
+
+void
+Ipv4GlobalRouting::BuildLookupTables (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_hostRouteIndex.clear ();
+  for (HostRoutesCI i = m_hostRoutes.begin (); i != m_hostRoutes.end (); i++)
+    {
+      NS_ASSERT ((*i)->IsHost ());
+      m_hostRouteIndex[(*i)->GetDest ().Get ()].push_back (*i);
+    }
+
+  m_networkTrie.assign (1, PrefixTrieNode ());
+  for (NetworkRoutesCI j = m_networkRoutes.begin (); j != m_networkRoutes.end (); j++)
+    {
+      // the trie only handles contiguous masks
+      Ipv4Mask mask = (*j)->GetDestNetworkMask ();
+      uint16_t prefixLength = mask.GetPrefixLength ();
+      NS_ASSERT_MSG (prefixLength == 0 ? mask.Get () == 0
+                     : mask.Get () == (0xffffffff << (32 - prefixLength)),
+                     "Non-contiguous network mask " << mask);
+      InsertPrefix (m_networkTrie, *j);
+    }
+
+  m_ASexternalTrie.assign (1, PrefixTrieNode ());
+  for (ASExternalRoutesCI k = m_ASexternalRoutes.begin (); k != m_ASexternalRoutes.end (); k++)
+    {
+      InsertPrefix (m_ASexternalTrie, *k);
+    }
+  m_lookupTablesValid = true;
+}
+
 Ptr<Ipv4Route>
 Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
 {
   NS_LOG_FUNCTION (this << dest << oif);
   NS_LOG_LOGIC ("Looking for route for destination " << dest);
   Ptr<Ipv4Route> rtentry = 0;
+  if (!m_lookupTablesValid)
+    {
+      BuildLookupTables ();
+    }
   // store all available routes that bring packets to their destination
-  typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
-  RouteVec_t allRoutes;
+  RouteVec allRoutes;
 
   NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
-  for (HostRoutesCI i = m_hostRoutes.begin (); 
-       i != m_hostRoutes.end (); 
-       i++) 
+  std::unordered_map<uint32_t, RouteVec>::const_iterator it =
+    m_hostRouteIndex.find (dest.Get ());
+  if (it != m_hostRouteIndex.end ())
     {
-      NS_ASSERT ((*i)->IsHost ());
-      if ((*i)->GetDest () == dest)
+      for (RouteVec::const_iterator i = it->second.begin ();
+           i != it->second.end ();
+           i++)
         {
           if (oif != 0)
             {
@@ -163,19 +255,22 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
                 }
             }
           allRoutes.push_back (*i);
-          NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i); 
+          NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i);
         }
     }
+  uint32_t matches[33];
   if (allRoutes.size () == 0) // if no host route is found
     {
+      // use the longest matching prefix with routes on the requested
+      // interface; all routes to this prefix form the ECMP set
       NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
-      for (NetworkRoutesI j = m_networkRoutes.begin (); 
-           j != m_networkRoutes.end (); 
-           j++) 
+      uint32_t nMatches = LookupPrefix (m_networkTrie, dest, matches);
+      while (nMatches > 0 && allRoutes.size () == 0)
         {
-          Ipv4Mask mask = (*j)->GetDestNetworkMask ();
-          Ipv4Address entry = (*j)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry)) 
+          const RouteVec &routes = m_networkTrie[matches[--nMatches]].routes;
+          for (RouteVec::const_iterator j = routes.begin ();
+               j != routes.end ();
+               j++)
             {
               if (oif != 0)
                 {
@@ -192,13 +287,13 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif)
     }
   if (allRoutes.size () == 0)  // consider external if no host/network found
     {
-      for (ASExternalRoutesI k = m_ASexternalRoutes.begin ();
-           k != m_ASexternalRoutes.end ();
-           k++)
+      uint32_t nMatches = LookupPrefix (m_ASexternalTrie, dest, matches);
+      while (nMatches > 0 && allRoutes.size () == 0)
         {
-          Ipv4Mask mask = (*k)->GetDestNetworkMask ();
-          Ipv4Address entry = (*k)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry))
+          const RouteVec &routes = m_ASexternalTrie[matches[--nMatches]].routes;
+          for (RouteVec::const_iterator k = routes.begin ();
+               k != routes.end ();
+               k++)
             {
               NS_LOG_LOGIC ("Found external route" << *k);
               if (oif != 0)
@@ -309,6 +404,8 @@ void
 Ipv4GlobalRouting::RemoveRoute (uint32_t index)
 {
   NS_LOG_FUNCTION (this << index);
+  m_lookupTablesValid = false;
+  m_routesVersion++;
   if (index < m_hostRoutes.size ())
     {
       uint32_t tmp = 0;
@@ -362,6 +459,118 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
   NS_ASSERT (false);
 }
 
+bool
+Ipv4GlobalRouting::ReplaceRoutes (const std::vector<Ipv4RoutingTableEntry> &hostRoutes,
+                                  const std::vector<Ipv4RoutingTableEntry> &networkRoutes,
+                                  const std::vector<Ipv4RoutingTableEntry> &externalRoutes)
+{
+  NS_LOG_FUNCTION (this << hostRoutes.size () << networkRoutes.size () << externalRoutes.size ());
+  bool changed = ReplaceRouteList (m_hostRoutes, hostRoutes);
+  changed |= ReplaceRouteList (m_networkRoutes, networkRoutes);
+  changed |= ReplaceRouteList (m_ASexternalRoutes, externalRoutes);
+  if (changed)
+    {
+      m_lookupTablesValid = false;
+      m_routesVersion++;
+    }
+  return changed;
+}
+
+bool
+Ipv4GlobalRouting::ReplaceRoutesTo (const std::vector<Ipv4Address> &hosts,
+                                    const std::vector<Ipv4RoutingTableEntry> &hostRoutes,
+                                    const std::vector<std::pair<Ipv4Address, Ipv4Mask> > &networks,
+                                    const std::vector<Ipv4RoutingTableEntry> &networkRoutes)
+{
+  NS_LOG_FUNCTION (this << hosts.size () << hostRoutes.size () << networks.size () << networkRoutes.size ());
+  std::unordered_set<uint64_t> dests;
+  for (std::vector<Ipv4Address>::const_iterator i = hosts.begin (); i != hosts.end (); i++)
+    {
+      dests.insert ((uint64_t (i->Get ()) << 32) | Ipv4Mask::GetOnes ().Get ());
+    }
+  bool changed = ReplaceRouteList (m_hostRoutes, dests, hostRoutes);
+  dests.clear ();
+  for (std::vector<std::pair<Ipv4Address, Ipv4Mask> >::const_iterator i = networks.begin ();
+       i != networks.end (); i++)
+    {
+      dests.insert ((uint64_t (i->first.Get ()) << 32) | i->second.Get ());
+    }
+  changed |= ReplaceRouteList (m_networkRoutes, dests, networkRoutes);
+  if (changed)
+    {
+      m_lookupTablesValid = false;
+      m_routesVersion++;
+    }
+  return changed;
+}
+
+bool
+Ipv4GlobalRouting::ReplaceRouteList (std::list<Ipv4RoutingTableEntry *> &routes,
+                                     const std::vector<Ipv4RoutingTableEntry> &newRoutes)
+{
+  bool same = (routes.size () == newRoutes.size ());
+  std::vector<Ipv4RoutingTableEntry>::const_iterator j = newRoutes.begin ();
+  for (std::list<Ipv4RoutingTableEntry *>::const_iterator i = routes.begin ();
+       same && i != routes.end (); i++, j++)
+    {
+      same = (**i == *j);
+    }
+  if (same)
+    {
+      return false;
+    }
+  for (std::list<Ipv4RoutingTableEntry *>::iterator i = routes.begin (); i != routes.end (); i++)
+    {
+      delete *i;
+    }
+  routes.clear ();
+  for (j = newRoutes.begin (); j != newRoutes.end (); j++)
+    {
+      routes.push_back (new Ipv4RoutingTableEntry (*j));
+    }
+  return true;
+}
+
+bool
+Ipv4GlobalRouting::ReplaceRouteList (std::list<Ipv4RoutingTableEntry *> &routes,
+                                     const std::unordered_set<uint64_t> &dests,
+                                     const std::vector<Ipv4RoutingTableEntry> &newRoutes)
+{
+  // Check if the routes to these destinations are already the new ones
+  std::vector<std::list<Ipv4RoutingTableEntry *>::iterator> oldRoutes;
+  for (std::list<Ipv4RoutingTableEntry *>::iterator i = routes.begin (); i != routes.end (); i++)
+    {
+      uint64_t key = (uint64_t ((*i)->GetDestNetwork ().Get ()) << 32)
+        | (*i)->GetDestNetworkMask ().Get ();
+      if (dests.count (key))
+        {
+          oldRoutes.push_back (i);
+        }
+    }
+  bool same = (oldRoutes.size () == newRoutes.size ());
+  for (uint32_t k = 0; same && k < oldRoutes.size (); k++)
+    {
+      same = (**oldRoutes[k] == newRoutes[k]);
+    }
+  if (same)
+    {
+      return false;
+    }
+  for (uint32_t k = 0; k < oldRoutes.size (); k++)
+    {
+      delete *oldRoutes[k];
+      routes.erase (oldRoutes[k]);
+    }
+  for (std::vector<Ipv4RoutingTableEntry>::const_iterator j = newRoutes.begin ();
+       j != newRoutes.end (); j++)
+    {
+      NS_ASSERT (dests.count ((uint64_t (j->GetDestNetwork ().Get ()) << 32)
+                              | j->GetDestNetworkMask ().Get ()));
+      routes.push_back (new Ipv4RoutingTableEntry (*j));
+    }
+  return true;
+}
+
 int64_t
 Ipv4GlobalRouting::AssignStreams (int64_t stream)
 {
@@ -392,6 +601,11 @@ Ipv4GlobalRouting::DoDispose (void)
     {
       delete (*l);
     }
+  m_hostRouteIndex.clear ();
+  m_networkTrie.clear ();
+  m_ASexternalTrie.clear ();
+  m_lookupTablesValid = false;
+  m_routesVersion++;
 
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -458,6 +672,13 @@ Ipv4GlobalRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Uni
   (*os).copyfmt (oldState);
 }
 
+uint64_t
+Ipv4GlobalRouting::GetRoutesVersion (void) const
+{
+  // random ECMP routing may pick another route for each packet
+  return m_randomEcmpRouting ? 0 : m_routesVersion;
+}
+
 Ptr<Ipv4Route>
 Ipv4GlobalRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<NetDevice> oif, Socket::SocketErrno &sockerr)
 {
@@ -542,11 +763,10 @@ void
 Ipv4GlobalRouting::NotifyInterfaceUp (uint32_t i)
 {
   NS_LOG_FUNCTION (this << i);
+  m_routesVersion++;
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateRoutes ();
     }
 }
 
@@ -554,11 +774,10 @@ void
 Ipv4GlobalRouting::NotifyInterfaceDown (uint32_t i)
 {
   NS_LOG_FUNCTION (this << i);
+  m_routesVersion++;
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateRoutes ();
     }
 }
 
@@ -566,11 +785,10 @@ void
 Ipv4GlobalRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
   NS_LOG_FUNCTION (this << interface << address);
+  m_routesVersion++;
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateRoutes ();
     }
 }
 
@@ -578,11 +796,10 @@ void
 Ipv4GlobalRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
   NS_LOG_FUNCTION (this << interface << address);
+  m_routesVersion++;
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
-      GlobalRouteManager::DeleteGlobalRoutes ();
-      GlobalRouteManager::BuildGlobalRoutingDatabase ();
-      GlobalRouteManager::InitializeRoutes ();
+      GlobalRouteManager::UpdateRoutes ();
     }
 }
 
@@ -590,6 +807,7 @@ void
 Ipv4GlobalRouting::SetIpv4 (Ptr<Ipv4> ipv4)
 {
   NS_LOG_FUNCTION (this << ipv4);
+  m_routesVersion++;
   NS_ASSERT (m_ipv4 == 0 && ipv4 != 0);
   m_ipv4 = ipv4;
 }
@@ -21,6 +21,9 @@
 #define IPV4_GLOBAL_ROUTING_H
 
 #include <list>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-header.h"
@@ -99,6 +102,7 @@ public:
   virtual void NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address);
   virtual void SetIpv4 (Ptr<Ipv4> ipv4);
   virtual void PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const;
+  virtual uint64_t GetRoutesVersion (void) const;
 
   /**
    * \brief Add a host route to the global routing table.
@@ -218,6 +222,42 @@ public:
    */
   void RemoveRoute (uint32_t i);
 
+  /**
+   * \brief Replace the contents of the global unicast routing table.
+   *
+   * This is equivalent to removing all the routes and adding the given
+   * ones in order, but the table is left untouched if it already has the
+   * same routes.
+   *
+   * \param hostRoutes The new routes to hosts.
+   * \param networkRoutes The new routes to networks.
+   * \param externalRoutes The new external routes.
+   * \return True if the routing table changed.
+   */
+  bool ReplaceRoutes (const std::vector<Ipv4RoutingTableEntry> &hostRoutes,
+                      const std::vector<Ipv4RoutingTableEntry> &networkRoutes,
+                      const std::vector<Ipv4RoutingTableEntry> &externalRoutes);
+
+  /**
+   * \brief Replace the routes to some hosts and networks.
+   *
+   * The host routes to the given hosts and the network routes to the given
+   * networks are removed, and the given routes (which must only go to these
+   * destinations) are appended in order.  The order of the routes to each
+   * destination is thus kept, but the indexes used by GetRoute may differ
+   * from a routing table built from scratch.
+   *
+   * \param hosts The destination hosts.
+   * \param hostRoutes The new routes to these hosts.
+   * \param networks The destination networks and masks.
+   * \param networkRoutes The new routes to these networks.
+   * \return True if the routing table changed.
+   */
+  bool ReplaceRoutesTo (const std::vector<Ipv4Address> &hosts,
+                        const std::vector<Ipv4RoutingTableEntry> &hostRoutes,
+                        const std::vector<std::pair<Ipv4Address, Ipv4Mask> > &networks,
+                        const std::vector<Ipv4RoutingTableEntry> &networkRoutes);
+
   /**
    * Assign a fixed random variable stream number to the random variables
    * used by this model.  Return the number of streams (possibly zero) that
@@ -268,10 +308,85 @@ private:
    */
   Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<NetDevice> oif = 0);
 
+  /// container of routes sharing the same destination (ECMP set)
+  typedef std::vector<Ipv4RoutingTableEntry *> RouteVec;
+
+  /**
+   * \brief Node of the binary trie used for longest prefix match.
+   *
+   * Node 0 is the root (zero-length prefix), so child index 0 means
+   * that there is no child.
+   */
+  struct PrefixTrieNode
+  {
+    PrefixTrieNode ()
+    {
+      child[0] = child[1] = 0;
+    }
+    uint32_t child[2]; //!< indexes of the child nodes for bit 0 and bit 1
+    RouteVec routes;   //!< routes to this prefix, in insertion order
+  };
+
+  /// binary trie of network prefixes, stored as a vector of nodes
+  typedef std::vector<PrefixTrieNode> PrefixTrie;
+
+  /**
+   * \brief Rebuild the host route index and the prefix tries from the
+   * route lists. Called on the first lookup after the routes change.
+   */
+  void BuildLookupTables (void);
+
+  /**
+   * \brief Insert a network route into a prefix trie.
+   * \param trie the prefix trie
+   * \param route the network route
+   */
+  static void InsertPrefix (PrefixTrie &trie, Ipv4RoutingTableEntry *route);
+
+  /**
+   * \brief Find the trie nodes holding routes whose prefix matches dest.
+   * \param trie the prefix trie
+   * \param dest destination address
+   * \param matches array of at least 33 elements, filled with the indexes
+   * of the matching nodes from the shortest to the longest prefix
+   * \return the number of matching nodes
+   */
+  static uint32_t LookupPrefix (const PrefixTrie &trie, Ipv4Address dest,
+                                uint32_t *matches);
+
+  /**
+   * \brief Replace all the routes of one of the route lists.
+   * \param routes the route list
+   * \param newRoutes the new routes
+   * \return true if the route list changed
+   * \see ReplaceRoutes
+   */
+  static bool ReplaceRouteList (std::list<Ipv4RoutingTableEntry *> &routes,
+                                const std::vector<Ipv4RoutingTableEntry> &newRoutes);
+
+  /**
+   * \brief Replace the routes of one of the route lists to some destinations.
+   * \param routes the route list
+   * \param dests the destinations, as (address << 32 | mask) keys
+   * \param newRoutes the new routes to these destinations
+   * \return true if the route list changed
+   * \see ReplaceRoutesTo
+   */
+  static bool ReplaceRouteList (std::list<Ipv4RoutingTableEntry *> &routes,
+                                const std::unordered_set<uint64_t> &dests,
+                                const std::vector<Ipv4RoutingTableEntry> &newRoutes);
+
   HostRoutes m_hostRoutes;             //!< Routes to hosts
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
 
+  /// host routes indexed by destination address
+  std::unordered_map<uint32_t, RouteVec> m_hostRouteIndex;
+  PrefixTrie m_networkTrie;     //!< Prefix trie of the routes to networks
+  PrefixTrie m_ASexternalTrie;  //!< Prefix trie of the external routes
+  bool m_lookupTablesValid;     //!< False if the route lists changed since the last rebuild
+  uint64_t m_routesVersion;     //!< Version of the routes, changed by any route or interface change
+
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
 
@@ -130,8 +130,13 @@ Ipv4L3Protocol::GetTypeId (void)
 }
 
 Ipv4L3Protocol::Ipv4L3Protocol()
+  : m_receiveRun (0)
 {
   NS_LOG_FUNCTION (this);
+  m_ipForwardCallback = MakeCallback (&Ipv4L3Protocol::IpForward, this);
+  m_ipMulticastForwardCallback = MakeCallback (&Ipv4L3Protocol::IpMulticastForward, this);
+  m_localDeliverCallback = MakeCallback (&Ipv4L3Protocol::RouteInputLocalDeliver, this);
+  m_routeInputErrorCallback = MakeCallback (&Ipv4L3Protocol::RouteInputError, this);
 }
 
 Ipv4L3Protocol::~Ipv4L3Protocol ()
@@ -579,6 +584,36 @@ Ipv4L3Protocol::Receive ( Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t p
   int32_t interface = GetInterfaceForDevice(device);
   NS_ASSERT_MSG (interface != -1, "Received a packet from an interface that is not known to IPv4");
 
+  ReceivePacket (device, interface, p, from, 0);
+}
+
+void
+Ipv4L3Protocol::ReceiveBatch (Ptr<NetDevice> device, const std::vector<Ptr<const Packet> > &packets,
+                              uint16_t protocol, const Address &from, const Address &to,
+                              NetDevice::PacketType packetType)
+{
+  NS_LOG_FUNCTION (this << device << packets.size () << protocol << from << to << packetType);
+
+  NS_LOG_LOGIC (packets.size () << " packets from " << from << " received on node " <<
+                m_node->GetId ());
+
+  int32_t interface = GetInterfaceForDevice (device);
+  NS_ASSERT_MSG (interface != -1, "Received a packet from an interface that is not known to IPv4");
+
+  ReceiveRun run;
+  run.valid = false;
+  for (std::vector<Ptr<const Packet> >::const_iterator i = packets.begin (); i != packets.end (); ++i)
+    {
+      ReceivePacket (device, interface, *i, from, &run);
+    }
+}
+
+void
+Ipv4L3Protocol::ReceivePacket (Ptr<NetDevice> device, int32_t interface, Ptr<const Packet> p,
+                               const Address &from, ReceiveRun *run)
+{
+  NS_LOG_FUNCTION (this << device << interface << p << from << run);
+
   Ptr<Packet> packet = p->Copy ();
 
   Ptr<Ipv4Interface> ipv4Interface = m_interfaces[interface];
@@ -616,9 +651,23 @@ Ipv4L3Protocol::Receive ( Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t p
       return;
     }
 
+  // the packets of a run share the ARP cache entry and the routing decision
+  bool sameRun = run && run->valid
+    && run->source == ipHeader.GetSource ()
+    && run->destination == ipHeader.GetDestination ()
+    && run->protocol == ipHeader.GetProtocol ();
+  if (run && !sameRun)
+    {
+      run->valid = true;
+      run->source = ipHeader.GetSource ();
+      run->destination = ipHeader.GetDestination ();
+      run->protocol = ipHeader.GetProtocol ();
+      run->localDeliver = false;
+    }
+
   // the packet is valid, we update the ARP cache entry (if present)
   Ptr<ArpCache> arpCache = ipv4Interface->GetArpCache ();
-  if (arpCache)
+  if (arpCache && !sameRun)
     {
       // case one, it's a a direct routing.
       ArpCache::Entry *entry = arpCache->Lookup (ipHeader.GetSource ());
@@ -660,13 +709,23 @@ Ipv4L3Protocol::Receive ( Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t p
       return;
     }
 
+  if (sameRun && run->localDeliver)
+    {
+      NS_LOG_LOGIC ("Delivering packet locally like the previous one");
+      LocalDeliver (packet, ipHeader, interface);
+      return;
+    }
+
   NS_ASSERT_MSG (m_routingProtocol != 0, "Need a routing protocol object to process packets");
-  if (!m_routingProtocol->RouteInput (packet, ipHeader, device,
-                                      MakeCallback (&Ipv4L3Protocol::IpForward, this),
-                                      MakeCallback (&Ipv4L3Protocol::IpMulticastForward, this),
-                                      MakeCallback (&Ipv4L3Protocol::LocalDeliver, this),
-                                      MakeCallback (&Ipv4L3Protocol::RouteInputError, this)
-                                      ))
+  // only the unicast packets delivered locally are not forwarded as well
+  m_receiveRun = ipHeader.GetDestination ().IsMulticast () ? 0 : run;
+  bool routed = m_routingProtocol->RouteInput (packet, ipHeader, device,
+                                               m_ipForwardCallback,
+                                               m_ipMulticastForwardCallback,
+                                               m_localDeliverCallback,
+                                               m_routeInputErrorCallback);
+  m_receiveRun = 0;
+  if (!routed)
     {
       NS_LOG_WARN ("No route found for forwarding packet.  Drop.");
       m_dropTrace (ipHeader, packet, DROP_NO_ROUTE, m_node->GetObject<Ipv4> (), interface);
@@ -758,7 +817,11 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
   bool mayFragment = true;
 
   // we need a copy of the packet with its tags in case we need to invoke recursion.
-  Ptr<Packet> pktCopyWithTags = packet->Copy ();
+  Ptr<Packet> pktCopyWithTags;
+  if (route == 0)
+    {
+      pktCopyWithTags = packet->Copy ();
+    }
 
   uint8_t ttl = m_defaultTtl;
   SocketIpTtlTag ipTtlTag;
@@ -1436,6 +1499,18 @@ Ipv4L3Protocol::RouteInputError (Ptr<const Packet> p, const Ipv4Header & ipHeade
   // \todo Send an ICMP no route.
 }
 
+void
+Ipv4L3Protocol::RouteInputLocalDeliver (Ptr<const Packet> p, Ipv4Header const&ip, uint32_t iif)
+{
+  NS_LOG_FUNCTION (this << p << &ip << iif);
+  if (m_receiveRun)
+    {
+      m_receiveRun->localDeliver = true;
+      m_receiveRun = 0;
+    }
+  LocalDeliver (p, ip, iif);
+}
+
 void
 Ipv4L3Protocol::DoFragmentation (Ptr<Packet> packet, const Ipv4Header & ipv4Header, uint32_t outIfaceMtu, std::list<Ipv4PayloadHeaderPair>& listFragments)
 {
@@ -154,6 +154,26 @@ public:
   void Receive ( Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from,
                  const Address &to, NetDevice::PacketType packetType);
 
+  /**
+   * Lower layer calls this method to hand up the packets received by a
+   * NetDevice at the same time, in their order of reception.
+   *
+   * This is equivalent to calling Receive for each packet, and every packet
+   * still fires the Rx, Drop and LocalDeliver traces. The interface is looked
+   * up once for the batch, and the ARP cache refresh and the routing decision
+   * are made once per run of consecutive packets with the same source,
+   * destination and protocol when they are delivered locally.
+   * \param device network device
+   * \param packets the packets
+   * \param protocol protocol value
+   * \param from address of the correspondent
+   * \param to address of the destination
+   * \param packetType type of the packets
+   */
+  void ReceiveBatch (Ptr<NetDevice> device, const std::vector<Ptr<const Packet> > &packets,
+                     uint16_t protocol, const Address &from, const Address &to,
+                     NetDevice::PacketType packetType);
+
   /**
    * \param packet packet to send
    * \param source source address of packet
@@ -376,6 +396,38 @@ private:
    */
   void RouteInputError (Ptr<const Packet> p, const Ipv4Header & ipHeader, Socket::SocketErrno sockErrno);
 
+  /**
+   * \brief Packets of a received batch sharing their routing decision.
+   */
+  struct ReceiveRun
+  {
+    bool valid;               //!< True once the run has a first packet
+    Ipv4Address source;       //!< Source address of the packets
+    Ipv4Address destination;  //!< Destination address of the packets
+    uint8_t protocol;         //!< Protocol of the packets
+    bool localDeliver;        //!< True if the packets are delivered locally
+  };
+
+  /**
+   * \brief Process a received packet.
+   * \param device network device
+   * \param interface interface of the device
+   * \param p the packet
+   * \param from address of the correspondent
+   * \param run the run of the batch of the packet, or 0 if not in a batch
+   */
+  void ReceivePacket (Ptr<NetDevice> device, int32_t interface, Ptr<const Packet> p,
+                      const Address &from, ReceiveRun *run);
+
+  /**
+   * \brief Deliver a packet routed by RouteInput, and record the decision
+   * in the run of the packet, if any.
+   * \param p packet delivered
+   * \param ip IPv4 header
+   * \param iif input interface packet was received
+   */
+  void RouteInputLocalDeliver (Ptr<const Packet> p, Ipv4Header const&ip, uint32_t iif);
+
   /**
    * \brief Add an IPv4 interface to the stack.
    * \param interface interface to add
@@ -494,6 +546,11 @@ private:
   TracedCallback<const Ipv4Header &, Ptr<const Packet>, DropReason, Ptr<Ipv4>, uint32_t> m_dropTrace;
 
   Ptr<Ipv4RoutingProtocol> m_routingProtocol; //!< Routing protocol associated with the stack
+  Ipv4RoutingProtocol::UnicastForwardCallback m_ipForwardCallback; //!< Callback to IpForward
+  Ipv4RoutingProtocol::MulticastForwardCallback m_ipMulticastForwardCallback; //!< Callback to IpMulticastForward
+  Ipv4RoutingProtocol::LocalDeliverCallback m_localDeliverCallback; //!< Callback to RouteInputLocalDeliver
+  Ipv4RoutingProtocol::ErrorCallback m_routeInputErrorCallback; //!< Callback to RouteInputError
+  ReceiveRun *m_receiveRun; //!< Run whose routing decision is being made
 
   SocketList m_sockets; //!< List of IPv4 raw sockets.
 
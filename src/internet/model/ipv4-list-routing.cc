@@ -234,6 +234,24 @@ Ipv4ListRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress a
       (*rprotoIter).second->NotifyRemoveAddress (interface, address);
     }
 }
+uint64_t
+Ipv4ListRouting::GetRoutesVersion (void) const
+{
+  // The versions only increase, so their sum changes with any of them
+  uint64_t version = 0;
+  for (Ipv4RoutingProtocolList::const_iterator i = m_routingProtocols.begin ();
+       i != m_routingProtocols.end (); i++)
+    {
+      uint64_t protocolVersion = (*i).second->GetRoutesVersion ();
+      if (protocolVersion == 0)
+        {
+          return 0;
+        }
+      version += protocolVersion;
+    }
+  return version;
+}
+
 void 
 Ipv4ListRouting::SetIpv4 (Ptr<Ipv4> ipv4)
 {
@@ -36,4 +36,10 @@ TypeId Ipv4RoutingProtocol::GetTypeId (void)
   return tid;
 }
 
+uint64_t
+Ipv4RoutingProtocol::GetRoutesVersion (void) const
+{
+  return 0;
+}
+
 } // namespace ns3
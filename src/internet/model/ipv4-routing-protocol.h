@@ -171,6 +171,21 @@ public:
    */
   virtual void PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const = 0;
 
+  /**
+   * \brief Get the version of the routes returned by RouteOutput
+   *
+   * The version changes whenever RouteOutput may return another route for
+   * the same destination, e.g., when a route is added or removed, or an
+   * interface changes. Callers can reuse a route for as long as the version
+   * does not change.
+   *
+   * The default implementation returns 0, which means that the protocol does
+   * not track these changes and that its routes must not be reused.
+   *
+   * \returns the version of the routes, or 0 if the routes must not be reused
+   */
+  virtual uint64_t GetRoutesVersion (void) const;
+
 };
 
 } // namespace ns3
@@ -54,7 +54,8 @@ Ipv4StaticRouting::GetTypeId (void)
 }
 
 Ipv4StaticRouting::Ipv4StaticRouting () 
-  : m_ipv4 (0)
+  : m_routesVersion (1),
+    m_ipv4 (0)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -77,6 +78,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
     {
       Ipv4RoutingTableEntry *routePtr = new Ipv4RoutingTableEntry (route);
       m_networkRoutes.push_back (make_pair (routePtr, metric));
+      m_routesVersion++;
     }
 }
 
@@ -96,6 +98,7 @@ Ipv4StaticRouting::AddNetworkRouteTo (Ipv4Address network,
       Ipv4RoutingTableEntry *routePtr = new Ipv4RoutingTableEntry (route);
 
       m_networkRoutes.push_back (make_pair (routePtr, metric));
+      m_routesVersion++;
     }
 }
 
@@ -154,6 +157,7 @@ Ipv4StaticRouting::SetDefaultMulticastRoute (uint32_t outputInterface)
                                                         networkMask,
                                                         outputInterface);
   m_networkRoutes.push_back (make_pair (route,0));
+  m_routesVersion++;
 }
 
 uint32_t 
@@ -478,6 +482,7 @@ Ipv4StaticRouting::RemoveRoute (uint32_t index)
         {
           delete j->first;
           m_networkRoutes.erase (j);
+          m_routesVersion++;
           return;
         }
       tmp++;
@@ -618,6 +623,7 @@ void
 Ipv4StaticRouting::NotifyInterfaceUp (uint32_t i)
 {
   NS_LOG_FUNCTION (this << i);
+  m_routesVersion++;
   // If interface address and network mask have been set, add a route
   // to the network of the interface (like e.g. ifconfig does on a
   // Linux box)
@@ -637,6 +643,7 @@ void
 Ipv4StaticRouting::NotifyInterfaceDown (uint32_t i)
 {
   NS_LOG_FUNCTION (this << i);
+  m_routesVersion++;
   // Remove all static routes that are going through this interface
   for (NetworkRoutesI it = m_networkRoutes.begin (); it != m_networkRoutes.end (); )
     {
@@ -656,6 +663,7 @@ void
 Ipv4StaticRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
   NS_LOG_FUNCTION (this << interface << " " << address.GetLocal ());
+  m_routesVersion++;
   if (!m_ipv4->IsUp (interface))
     {
       return;
@@ -674,6 +682,7 @@ void
 Ipv4StaticRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
   NS_LOG_FUNCTION (this << interface << " " << address.GetLocal ());
+  m_routesVersion++;
   if (!m_ipv4->IsUp (interface))
     {
       return;
@@ -705,6 +714,7 @@ Ipv4StaticRouting::SetIpv4 (Ptr<Ipv4> ipv4)
   NS_LOG_FUNCTION (this << ipv4);
   NS_ASSERT (m_ipv4 == 0 && ipv4 != 0);
   m_ipv4 = ipv4;
+  m_routesVersion++;
   for (uint32_t i = 0; i < m_ipv4->GetNInterfaces (); i++)
     {
       if (m_ipv4->IsUp (i))
@@ -717,6 +727,12 @@ Ipv4StaticRouting::SetIpv4 (Ptr<Ipv4> ipv4)
         }
     }
 }
+uint64_t
+Ipv4StaticRouting::GetRoutesVersion (void) const
+{
+  return m_routesVersion;
+}
+
 // Formatted like output of "route -n" command
 void
 Ipv4StaticRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit unit) const
@@ -86,6 +86,7 @@ public:
   virtual void NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address);
   virtual void SetIpv4 (Ptr<Ipv4> ipv4);
   virtual void PrintRoutingTable (Ptr<OutputStreamWrapper> stream, Time::Unit unit = Time::S) const;
+  virtual uint64_t GetRoutesVersion (void) const;
 
 /**
  * \brief Add a network route to the static routing table.
@@ -412,6 +413,11 @@ private:
    */
   MulticastRoutes m_multicastRoutes;
 
+  /**
+   * \brief Version of the routes, changed by any route or interface change.
+   */
+  uint64_t m_routesVersion;
+
   /**
    * \brief Ipv4 reference.
    */
@@ -84,6 +84,7 @@ UdpSocketImpl::UdpSocketImpl ()
     m_shutdownSend (false),
     m_shutdownRecv (false),
     m_connected (false),
+    m_routesVersion (0),
     m_rxAvailable (0)
 {
   NS_LOG_FUNCTION (this);
@@ -207,6 +208,7 @@ UdpSocketImpl::FinishBind (void)
 {
   NS_LOG_FUNCTION (this);
   bool done = false;
+  m_route = 0;
   if (m_endPoint != 0)
     {
       m_endPoint->SetRxCallback (MakeCallback (&UdpSocketImpl::ForwardUp, Ptr<UdpSocketImpl> (this)));
@@ -603,8 +605,14 @@ UdpSocketImpl::DoSendTo (Ptr<Packet> p, Ipv4Address dest, uint16_t port, uint8_t
     }
   else if (m_endPoint->GetLocalAddress () != Ipv4Address::GetAny ())
     {
+      // Without a route, Ipv4L3Protocol routes the packet itself
+      Ptr<Ipv4Route> route = GetCachedRoute (ipv4, dest);
+      if (route == 0)
+        {
+          route = RouteBoundDatagram (p, ipv4, dest);
+        }
       m_udp->Send (p->Copy (), m_endPoint->GetLocalAddress (), dest,
-                   m_endPoint->GetLocalPort (), port, 0);
+                   m_endPoint->GetLocalPort (), port, route);
       NotifyDataSent (p->GetSize ());
       NotifySend (GetTxAvailable ());
       return p->GetSize ();
@@ -615,14 +623,12 @@ UdpSocketImpl::DoSendTo (Ptr<Packet> p, Ipv4Address dest, uint16_t port, uint8_t
       header.SetDestination (dest);
       header.SetProtocol (UdpL4Protocol::PROT_NUMBER);
       Socket::SocketErrno errno_;
-      Ptr<Ipv4Route> route;
+      Ptr<Ipv4Route> route = GetCachedRoute (ipv4, dest);
       Ptr<NetDevice> oif = m_boundnetdevice; //specify non-zero if bound to a specific device
-      // TBD-- we could cache the route and just check its validity
-      route = ipv4->GetRoutingProtocol ()->RouteOutput (p, header, oif, errno_); 
-      if (route != 0)
+      if (route == 0)
         {
-          NS_LOG_LOGIC ("Route exists");
-          if (!m_allowBroadcast)
+          route = ipv4->GetRoutingProtocol ()->RouteOutput (p, header, oif, errno_);
+          if (route != 0 && !m_allowBroadcast)
             {
               // Here we try to route subnet-directed broadcasts
               uint32_t outputIfIndex = ipv4->GetInterfaceForDevice (route->GetOutputDevice ());
@@ -637,7 +643,14 @@ UdpSocketImpl::DoSendTo (Ptr<Packet> p, Ipv4Address dest, uint16_t port, uint8_t
                     }
                 }
             }
-
+          if (route != 0 && !dest.IsMulticast ())
+            {
+              CacheRoute (ipv4, dest, route);
+            }
+        }
+      if (route != 0)
+        {
+          NS_LOG_LOGIC ("Route exists");
           header.SetSource (route->GetSource ());
           m_udp->Send (p->Copy (), header.GetSource (), header.GetDestination (),
                        m_endPoint->GetLocalPort (), port, route);
@@ -662,6 +675,67 @@ UdpSocketImpl::DoSendTo (Ptr<Packet> p, Ipv4Address dest, uint16_t port, uint8_t
   return 0;
 }
 
+Ptr<Ipv4Route>
+UdpSocketImpl::GetCachedRoute (Ptr<Ipv4> ipv4, Ipv4Address dest) const
+{
+  if (m_route == 0 || m_routeDestination != dest)
+    {
+      return 0;
+    }
+  Ptr<Ipv4RoutingProtocol> routingProtocol = ipv4->GetRoutingProtocol ();
+  if (routingProtocol != m_routingProtocol || routingProtocol->GetRoutesVersion () != m_routesVersion)
+    {
+      NS_LOG_LOGIC ("Routes changed since the last datagram to " << dest);
+      return 0;
+    }
+  return m_route;
+}
+
+void
+UdpSocketImpl::CacheRoute (Ptr<Ipv4> ipv4, Ipv4Address dest, Ptr<Ipv4Route> route)
+{
+  NS_LOG_FUNCTION (this << ipv4 << dest << route);
+  m_routingProtocol = ipv4->GetRoutingProtocol ();
+  m_routesVersion = m_routingProtocol->GetRoutesVersion ();
+  m_route = m_routesVersion != 0 ? route : 0;
+  m_routeDestination = dest;
+}
+
+Ptr<Ipv4Route>
+UdpSocketImpl::RouteBoundDatagram (Ptr<Packet> p, Ptr<Ipv4> ipv4, Ipv4Address dest)
+{
+  NS_LOG_FUNCTION (this << p << ipv4 << dest);
+  Ptr<Ipv4RoutingProtocol> routingProtocol = ipv4->GetRoutingProtocol ();
+  if (dest.IsMulticast () || routingProtocol == 0 || routingProtocol->GetRoutesVersion () == 0)
+    {
+      return 0;
+    }
+  // Ipv4L3Protocol sends subnet-directed broadcasts out of their subnet
+  for (uint32_t i = 0; i < ipv4->GetNInterfaces (); i++)
+    {
+      for (uint32_t j = 0; j < ipv4->GetNAddresses (i); j++)
+        {
+          Ipv4Mask mask = ipv4->GetAddress (i, j).GetMask ();
+          if (dest.IsSubnetDirectedBroadcast (mask)
+              && dest.CombineMask (mask) == ipv4->GetAddress (i, j).GetLocal ().CombineMask (mask))
+            {
+              return 0;
+            }
+        }
+    }
+  Ipv4Header header;
+  header.SetSource (m_endPoint->GetLocalAddress ());
+  header.SetDestination (dest);
+  header.SetProtocol (UdpL4Protocol::PROT_NUMBER);
+  Socket::SocketErrno errno_;
+  Ptr<Ipv4Route> route = routingProtocol->RouteOutput (p, header, 0, errno_);
+  if (route != 0)
+    {
+      CacheRoute (ipv4, dest, route);
+    }
+  return route;
+}
+
 int
 UdpSocketImpl::DoSendTo (Ptr<Packet> p, Ipv6Address dest, uint16_t port)
 {
@@ -952,6 +1026,7 @@ UdpSocketImpl::BindToNetDevice (Ptr<NetDevice> netdevice)
   Ptr<NetDevice> oldBoundNetDevice = m_boundnetdevice;
 
   Socket::BindToNetDevice (netdevice); // Includes sanity check
+  m_route = 0;
   if (m_endPoint != 0)
     {
       m_endPoint->BindToNetDevice (netdevice);
@@ -1204,6 +1279,7 @@ bool
 UdpSocketImpl::SetAllowBroadcast (bool allowBroadcast)
 {
   m_allowBroadcast = allowBroadcast;
+  m_route = 0;
   return true;
 }
 
@@ -40,6 +40,9 @@ class Packet;
 class UdpL4Protocol;
 class Ipv6Header;
 class Ipv6Interface;
+class Ipv4;
+class Ipv4Route;
+class Ipv4RoutingProtocol;
 
 /**
  * \ingroup socket
@@ -210,6 +213,33 @@ private:
    */
   int DoSendTo (Ptr<Packet> p, Ipv6Address daddr, uint16_t dport);
 
+  /**
+   * \brief Get the route of the previous unicast datagram to a destination
+   * \param ipv4 the IPv4 stack of the node
+   * \param daddr destination address
+   * \returns the route, or 0 if there is none or the routes changed since
+   */
+  Ptr<Ipv4Route> GetCachedRoute (Ptr<Ipv4> ipv4, Ipv4Address daddr) const;
+  /**
+   * \brief Keep the route of a unicast datagram for the next ones
+   * \param ipv4 the IPv4 stack of the node
+   * \param daddr destination address
+   * \param route the route
+   */
+  void CacheRoute (Ptr<Ipv4> ipv4, Ipv4Address daddr, Ptr<Ipv4Route> route);
+  /**
+   * \brief Find the route of a unicast datagram sent from the bound address
+   *
+   * This finds the route that Ipv4L3Protocol::Send would use for a packet
+   * sent without a route.
+   *
+   * \param p packet
+   * \param ipv4 the IPv4 stack of the node
+   * \param daddr destination address
+   * \returns the route, or 0 if Ipv4L3Protocol must route the packet itself
+   */
+  Ptr<Ipv4Route> RouteBoundDatagram (Ptr<Packet> p, Ptr<Ipv4> ipv4, Ipv4Address daddr);
+
   /**
    * \brief Called by the L3 protocol when it received an ICMP packet to pass on to TCP.
    *
@@ -250,6 +280,12 @@ private:
   bool                     m_connected;       //!< Connection established
   bool                     m_allowBroadcast;  //!< Allow send broadcast packets
 
+  // Route of the last unicast datagram, reused while the routes do not change
+  Ptr<Ipv4Route> m_route;                       //!< Route of the last unicast datagram
+  Ipv4Address m_routeDestination;               //!< Destination of the cached route
+  Ptr<Ipv4RoutingProtocol> m_routingProtocol;   //!< Routing protocol of the cached route
+  uint64_t m_routesVersion;                     //!< Routes version of the cached route
+
   std::queue<std::pair<Ptr<Packet>, Address> > m_deliveryQueue; //!< Queue for incoming packets
   uint32_t m_rxAvailable;                   //!< Number of available bytes to be received
 
@@ -0,0 +1,97 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/mac48-address.h"
+#include "ns3/arp-cache.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief ARP cache entries test
+ */
+class ArpCacheEntriesTestCase : public TestCase
+{
+public:
+  ArpCacheEntriesTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+ArpCacheEntriesTestCase::ArpCacheEntriesTestCase ()
+  : TestCase ("ARP cache entries")
+{
+}
+
+void
+ArpCacheEntriesTestCase::DoRun (void)
+{
+  Ptr<ArpCache> cache = CreateObject<ArpCache> ();
+
+  // Entries keep their address while the cache grows
+  ArpCache::Entry *first = cache->Add ("10.0.0.1");
+  for (uint32_t i = 2; i < 1000; i++)
+    {
+      cache->AddPermanent (Ipv4Address ((10 << 24) | i), Mac48Address::Allocate ());
+    }
+  NS_TEST_EXPECT_MSG_EQ (cache->Lookup ("10.0.0.1"), first, "Entry moved");
+  NS_TEST_EXPECT_MSG_EQ (first->IsAlive (), true, "Wrong state of a new entry");
+  NS_TEST_EXPECT_MSG_EQ (cache->Lookup ("10.0.0.1")->GetIpv4Address (), Ipv4Address ("10.0.0.1"),
+                         "Wrong address");
+  NS_TEST_EXPECT_MSG_EQ (cache->Lookup ("10.0.3.232"), 0, "Unexpected entry");
+
+  // Permanent entries never expire
+  Mac48Address mac = Mac48Address::Allocate ();
+  ArpCache::Entry *permanent = cache->AddPermanent ("10.0.0.1", mac);
+  NS_TEST_EXPECT_MSG_EQ (permanent, first, "Existing entry not reused");
+  NS_TEST_EXPECT_MSG_EQ (permanent->IsPermanent (), true, "Entry not permanent");
+  NS_TEST_EXPECT_MSG_EQ (permanent->IsExpired (), false, "Permanent entry expired");
+  NS_TEST_EXPECT_MSG_EQ (Mac48Address::ConvertFrom (permanent->GetMacAddress ()), mac,
+                         "Wrong MAC address");
+  NS_TEST_EXPECT_MSG_EQ (cache->LookupInverse (mac).size (), 1, "Entry not found by MAC address");
+
+  cache->Remove (permanent);
+  NS_TEST_EXPECT_MSG_EQ (cache->Lookup ("10.0.0.1"), 0, "Entry not removed");
+  NS_TEST_EXPECT_MSG_NE (cache->Lookup ("10.0.0.2"), 0, "Wrong entry removed");
+  cache->Flush ();
+  NS_TEST_EXPECT_MSG_EQ (cache->Lookup ("10.0.0.2"), 0, "Entry not flushed");
+
+  cache->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief ARP cache TestSuite
+ */
+class ArpCacheTestSuite : public TestSuite
+{
+public:
+  ArpCacheTestSuite ()
+    : TestSuite ("arp-cache", UNIT)
+  {
+    AddTestCase (new ArpCacheEntriesTestCase, TestCase::QUICK);
+  }
+};
+
+static ArpCacheTestSuite g_arpCacheTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,165 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/ipv4-interface-address.h"
+#include "ns3/ipv4-end-point.h"
+#include "ns3/ipv4-end-point-demux.h"
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 end point demux lookup test
+ *
+ * Checks the precedence of the end points matching a packet, and that the
+ * end points are found again after their local address or peer changes.
+ */
+class Ipv4EndPointDemuxLookupTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxLookupTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Lookup the end point of a packet.
+   * \param demux The demux.
+   * \param daddr The destination address.
+   * \param dport The destination port.
+   * \param saddr The source address.
+   * \param sport The source port.
+   * \return The only matching end point, or 0 if there is none.
+   */
+  Ipv4EndPoint *Lookup (Ipv4EndPointDemux &demux, Ipv4Address daddr, uint16_t dport,
+                        Ipv4Address saddr, uint16_t sport);
+
+  Ptr<Ipv4Interface> m_interface; //!< The incoming interface.
+};
+
+Ipv4EndPointDemuxLookupTestCase::Ipv4EndPointDemuxLookupTestCase ()
+  : TestCase ("IPv4 end point demux lookup")
+{
+}
+
+Ipv4EndPoint *
+Ipv4EndPointDemuxLookupTestCase::Lookup (Ipv4EndPointDemux &demux,
+                                         Ipv4Address daddr, uint16_t dport,
+                                         Ipv4Address saddr, uint16_t sport)
+{
+  Ipv4EndPointDemux::EndPoints endPoints = demux.Lookup (daddr, dport, saddr, sport, m_interface);
+  return endPoints.empty () ? 0 : endPoints.front ();
+}
+
+void
+Ipv4EndPointDemuxLookupTestCase::DoRun (void)
+{
+  Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+  m_interface = CreateObject<Ipv4Interface> ();
+  m_interface->SetDevice (device);
+  m_interface->AddAddress (Ipv4InterfaceAddress ("10.0.1.1", "255.255.255.0"));
+
+  Ipv4Address local ("10.0.1.1");
+  Ipv4Address peer ("10.0.2.2");
+  Ipv4EndPointDemux demux;
+
+  // Unrelated end points, including many connections to the same port
+  for (uint16_t i = 0; i < 1000; i++)
+    {
+      demux.Allocate (0, Ipv4Address::GetAny (), 20000 + i);
+      demux.Allocate (0, local, 80, peer, 40000 + i);
+    }
+
+  Ipv4EndPoint *any = demux.Allocate (0, Ipv4Address::GetAny (), 9);
+  NS_TEST_ASSERT_MSG_NE (any, 0, "Allocation failed");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 9, peer, 1234), any, "Wildcard end point not found");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 10, peer, 1234), 0, "Unexpected end point");
+
+  Ipv4EndPoint *subnet = demux.Allocate (0, Ipv4Address ("10.0.1.0"), 7);
+  NS_TEST_ASSERT_MSG_NE (subnet, 0, "Allocation failed");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "10.0.1.255", 7, peer, 1234), subnet,
+                         "Subnet-directed end point not found");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "10.0.3.1", 7, peer, 1234), 0,
+                         "Subnet-directed end point matches another subnet");
+  demux.DeAllocate (subnet);
+
+  Ipv4EndPoint *bound = demux.Allocate (0, local, 9);
+  NS_TEST_ASSERT_MSG_NE (bound, 0, "Allocation failed");
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (0, local, 9), 0, "Duplicated end point allocated");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 9, peer, 1234), bound,
+                         "Local address not preferred over the wildcard");
+
+  Ipv4EndPoint *connected = demux.Allocate (0, local, 9, peer, 1234);
+  NS_TEST_ASSERT_MSG_NE (connected, 0, "Allocation failed");
+  NS_TEST_EXPECT_MSG_EQ (demux.Allocate (0, local, 9, peer, 1234), 0, "Duplicated end point allocated");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 9, peer, 1234), connected, "Exact match not preferred");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 9, peer, 1235), bound, "Wrong end point for another peer");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 80, peer, 40500)->GetPeerPort (), 40500,
+                         "Wrong connection");
+
+  // Changes of the peer and local address of an end point
+  connected->SetPeer (peer, 4321);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 9, peer, 1234), bound, "End point found with its old peer");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 9, peer, 4321), connected, "End point not found with its new peer");
+  Ipv4EndPoint *ephemeral = demux.Allocate ();
+  NS_TEST_ASSERT_MSG_NE (ephemeral, 0, "Allocation failed");
+  ephemeral->SetPeer (peer, 5678);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, ephemeral->GetLocalPort (), peer, 5678), ephemeral,
+                         "Wildcard end point not found with its peer");
+  ephemeral->SetLocalAddress (local);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, ephemeral->GetLocalPort (), peer, 5678), ephemeral,
+                         "End point not found with its new local address");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, "10.0.1.2", ephemeral->GetLocalPort (), peer, 5678), 0,
+                         "End point found with its old local address");
+
+  // Disabled and deallocated end points
+  connected->SetRxEnabled (false);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 9, peer, 4321), bound, "Disabled end point found");
+  demux.DeAllocate (bound);
+  NS_TEST_EXPECT_MSG_EQ (Lookup (demux, local, 9, peer, 4321), any, "Deallocated end point found");
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (9), true, "Local port not found");
+  demux.DeAllocate (any);
+  demux.DeAllocate (connected);
+  NS_TEST_EXPECT_MSG_EQ (demux.LookupPortLocal (9), false, "Deallocated local port found");
+  NS_TEST_EXPECT_MSG_EQ (demux.GetAllEndPoints ().size (), 2001, "Wrong number of end points");
+
+  m_interface = 0;
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 end point demux TestSuite
+ */
+class Ipv4EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  Ipv4EndPointDemuxTestSuite ()
+    : TestSuite ("ipv4-end-point-demux", UNIT)
+  {
+    AddTestCase (new Ipv4EndPointDemuxLookupTestCase, TestCase::QUICK);
+  }
+};
+
+static Ipv4EndPointDemuxTestSuite g_ipv4EndPointDemuxTestSuite; //!< Static variable for test initialization
@@ -14,6 +14,9 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <map>
+#include <set>
+#include <sstream>
 #include <vector>
 #include "ns3/boolean.h"
 #include "ns3/config.h"
@@ -25,6 +28,7 @@
 #include "ns3/node.h"
 #include "ns3/log.h"
 #include "ns3/node-container.h"
+#include "ns3/node-list.h"
 #include "ns3/packet.h"
 #include "ns3/simple-net-device-helper.h"
 #include "ns3/pointer.h"
@@ -42,6 +46,7 @@
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/ipv4-global-routing.h"
 #include "ns3/bridge-helper.h"
+#include "ns3/global-route-manager.h"
 
 using namespace ns3;
 
@@ -1244,6 +1249,321 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 GlobalRouting longest prefix match and ECMP lookup test
+ */
+class Ipv4GlobalRoutingLpmTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingLpmTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Lookup a route with RouteOutput.
+   * \param routing The global routing protocol.
+   * \param dest The destination address.
+   * \param oif The requested output device (may be 0).
+   * \return The route gateway, or the any address if there is no route.
+   */
+  Ipv4Address Lookup (Ptr<Ipv4GlobalRouting> routing, Ipv4Address dest,
+                      Ptr<NetDevice> oif = 0);
+};
+
+Ipv4GlobalRoutingLpmTestCase::Ipv4GlobalRoutingLpmTestCase ()
+  : TestCase ("Global routing longest prefix match")
+{
+}
+
+Ipv4Address
+Ipv4GlobalRoutingLpmTestCase::Lookup (Ptr<Ipv4GlobalRouting> routing,
+                                      Ipv4Address dest, Ptr<NetDevice> oif)
+{
+  Ipv4Header header;
+  header.SetDestination (dest);
+  Socket::SocketErrno sockerr;
+  Ptr<Ipv4Route> route = routing->RouteOutput (0, header, oif, sockerr);
+  return route ? route->GetGateway () : Ipv4Address::GetAny ();
+}
+
+void
+Ipv4GlobalRoutingLpmTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  SimpleNetDeviceHelper simpleHelper;
+  NetDeviceContainer net;
+  net.Add (simpleHelper.Install (node, CreateObject<SimpleChannel> ()));
+  net.Add (simpleHelper.Install (node, CreateObject<SimpleChannel> ()));
+
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (node);
+
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.1.0", "255.255.255.0");
+  ipv4.Assign (net.Get (0));
+  ipv4.SetBase ("10.0.2.0", "255.255.255.0");
+  ipv4.Assign (net.Get (1));
+
+  Ptr<Ipv4GlobalRouting> routing =
+    node->GetObject<Ipv4L3Protocol> ()->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+  NS_TEST_ASSERT_MSG_NE (routing, 0, "Error-- no Ipv4GlobalRouting object");
+
+  // Unrelated routes to fill the table
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      routing->AddNetworkRouteTo (Ipv4Address ((10 << 24) | (128 << 16) | (i << 8)),
+                                  Ipv4Mask ("/24"), Ipv4Address ("10.0.2.9"), 2);
+    }
+  routing->AddNetworkRouteTo ("192.168.0.0", "/16", "10.0.1.2", 1);
+  routing->AddNetworkRouteTo ("192.168.1.0", "/24", "10.0.2.2", 2);
+  routing->AddNetworkRouteTo ("192.168.1.0", "/24", "10.0.1.3", 1);
+  routing->AddNetworkRouteTo ("0.0.0.0", Ipv4Mask::GetZero (), "10.0.1.4", 1);
+  routing->AddHostRouteTo ("192.168.1.7", "10.0.2.3", 2);
+  routing->AddASExternalRouteTo ("8.0.0.0", "/8", "10.0.2.5", 2);
+  routing->AddASExternalRouteTo ("8.8.0.0", "/16", "10.0.1.5", 1);
+
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "192.168.1.7"), Ipv4Address ("10.0.2.3"),
+                         "Host route not preferred");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "192.168.1.5"), Ipv4Address ("10.0.2.2"),
+                         "Longest prefix not preferred");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "192.168.1.5", net.Get (0)), Ipv4Address ("10.0.1.3"),
+                         "Wrong ECMP route on the requested interface");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "192.168.2.5"), Ipv4Address ("10.0.1.2"),
+                         "Wrong route to the shorter prefix");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "192.168.2.5", net.Get (1)), Ipv4Address::GetAny (),
+                         "Unexpected route on the requested interface");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "10.128.200.1"), Ipv4Address ("10.0.2.9"),
+                         "Wrong route to the filler prefix");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "8.8.8.8"), Ipv4Address ("10.0.1.4"),
+                         "Default route not preferred over external routes");
+
+  // Removing the default route exposes the external routes
+  for (uint32_t i = 0; i < routing->GetNRoutes (); i++)
+    {
+      Ipv4RoutingTableEntry *route = routing->GetRoute (i);
+      if (route->IsDefault ())
+        {
+          routing->RemoveRoute (i);
+          break;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "8.8.8.8"), Ipv4Address ("10.0.1.5"),
+                         "Longest external prefix not preferred");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "8.9.8.8"), Ipv4Address ("10.0.2.5"),
+                         "Wrong external route");
+  NS_TEST_EXPECT_MSG_EQ (Lookup (routing, "9.9.9.9"), Ipv4Address::GetAny (),
+                         "Unexpected route");
+
+  // Random ECMP uses both routes to the longest prefix
+  routing->SetAttribute ("RandomEcmpRouting", BooleanValue (true));
+  std::set<Ipv4Address> gateways;
+  for (uint32_t i = 0; i < 100; i++)
+    {
+      gateways.insert (Lookup (routing, "192.168.1.5"));
+    }
+  NS_TEST_EXPECT_MSG_EQ (gateways.size (), 2, "ECMP routes not used");
+  NS_TEST_EXPECT_MSG_EQ (gateways.count (Ipv4Address ("10.0.1.2")), 0,
+                         "Shorter prefix used for ECMP");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 GlobalRouting incremental route computation test
+ *
+ * After each topology change, the routes computed again from the previous
+ * shortest-path trees must be the same as the routes computed from scratch.
+ */
+class Ipv4GlobalRoutingIncrementalTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingIncrementalTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /// Routes of each node, as (node ID, destination) -> ordered (gateway, interface) list
+  typedef std::map<std::pair<uint32_t, std::string>, std::vector<std::string> > Routes_t;
+
+  /**
+   * \brief Get the global routes of all the nodes.
+   * \return The routes.
+   */
+  Routes_t GetRoutes (void) const;
+
+  /**
+   * \brief Compute the routes again, incrementally and from scratch, and
+   * compare them.
+   * \param event The topology change.
+   */
+  void CheckRoutes (std::string event);
+
+  /**
+   * \brief Get the interface of a node for a device.
+   * \param devices The devices of a link.
+   * \param i The index of the device.
+   * \return The IPv4 of the node and the interface index.
+   */
+  static std::pair<Ptr<Ipv4>, uint32_t> GetInterface (const NetDeviceContainer &devices,
+                                                      uint32_t i);
+};
+
+Ipv4GlobalRoutingIncrementalTestCase::Ipv4GlobalRoutingIncrementalTestCase ()
+  : TestCase ("Global routing incremental route computation")
+{
+}
+
+Ipv4GlobalRoutingIncrementalTestCase::Routes_t
+Ipv4GlobalRoutingIncrementalTestCase::GetRoutes (void) const
+{
+  Routes_t routes;
+  for (uint32_t i = 0; i < NodeList::GetNNodes (); i++)
+    {
+      Ptr<Node> node = NodeList::GetNode (i);
+      Ptr<Ipv4GlobalRouting> routing =
+        node->GetObject<Ipv4L3Protocol> ()->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+      for (uint32_t j = 0; j < routing->GetNRoutes (); j++)
+        {
+          Ipv4RoutingTableEntry *route = routing->GetRoute (j);
+          std::ostringstream dest;
+          std::ostringstream nextHop;
+          dest << route->GetDest () << "/" << route->GetDestNetworkMask ().GetPrefixLength ();
+          nextHop << route->GetGateway () << "%" << route->GetInterface ();
+          routes[std::make_pair (node->GetId (), dest.str ())].push_back (nextHop.str ());
+        }
+    }
+  return routes;
+}
+
+void
+Ipv4GlobalRoutingIncrementalTestCase::CheckRoutes (std::string event)
+{
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  Routes_t incremental = GetRoutes ();
+  GlobalRouteManager::DeleteGlobalRoutes ();
+  GlobalRouteManager::BuildGlobalRoutingDatabase ();
+  GlobalRouteManager::InitializeRoutes ();
+  Routes_t full = GetRoutes ();
+
+  NS_TEST_EXPECT_MSG_EQ (incremental.size (), full.size (),
+                         "Wrong number of destinations after " << event);
+  for (Routes_t::const_iterator i = full.begin (); i != full.end (); i++)
+    {
+      Routes_t::const_iterator j = incremental.find (i->first);
+      NS_TEST_EXPECT_MSG_EQ ((j != incremental.end () && j->second == i->second), true,
+                             "Wrong routes of node " << i->first.first << " to " <<
+                             i->first.second << " after " << event);
+    }
+}
+
+std::pair<Ptr<Ipv4>, uint32_t>
+Ipv4GlobalRoutingIncrementalTestCase::GetInterface (const NetDeviceContainer &devices, uint32_t i)
+{
+  Ptr<Ipv4> ipv4 = devices.Get (i)->GetNode ()->GetObject<Ipv4> ();
+  return std::make_pair (ipv4, uint32_t (ipv4->GetInterfaceForDevice (devices.Get (i))));
+}
+
+void
+Ipv4GlobalRoutingIncrementalTestCase::DoRun (void)
+{
+  // Ring of six routers with a chord, one host on each router, a host
+  // attached to two routers and a LAN between two routers and a host.
+  // There is no equal-cost path to the LAN, which is not supported.
+  NodeContainer routers;
+  routers.Create (6);
+  NodeContainer hosts;
+  hosts.Create (7);
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (routers);
+  internet.Install (hosts);
+
+  SimpleNetDeviceHelper p2pHelper;
+  p2pHelper.SetNetDevicePointToPointMode (true);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.255.255.252");
+  std::vector<NetDeviceContainer> core;
+  std::vector<NetDeviceContainer> access;
+  for (uint32_t i = 0; i < 6; i++)
+    {
+      core.push_back (p2pHelper.Install (NodeContainer (routers.Get (i), routers.Get ((i + 1) % 6))));
+      ipv4.Assign (core.back ());
+      ipv4.NewNetwork ();
+      access.push_back (p2pHelper.Install (NodeContainer (routers.Get (i), hosts.Get (i))));
+      ipv4.Assign (access.back ());
+      ipv4.NewNetwork ();
+    }
+  core.push_back (p2pHelper.Install (NodeContainer (routers.Get (1), routers.Get (4))));
+  ipv4.Assign (core.back ());
+  ipv4.NewNetwork ();
+  access.push_back (p2pHelper.Install (NodeContainer (routers.Get (2), hosts.Get (0))));
+  ipv4.Assign (access.back ());
+
+  SimpleNetDeviceHelper lanHelper;
+  NetDeviceContainer lan = lanHelper.Install (NodeContainer (routers.Get (2), routers.Get (5),
+                                                             hosts.Get (6)));
+  ipv4.SetBase ("10.1.0.0", "255.255.255.0");
+  ipv4.Assign (lan);
+
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  std::pair<Ptr<Ipv4>, uint32_t> itf;
+  itf = GetInterface (access[2], 1);
+  itf.first->SetDown (itf.second);
+  CheckRoutes ("host link down (host side)");
+  itf.first->SetUp (itf.second);
+  CheckRoutes ("host link up (host side)");
+
+  itf = GetInterface (access[6], 0);
+  itf.first->SetDown (itf.second);
+  CheckRoutes ("dual-homed host link down (router side)");
+  itf.first->SetUp (itf.second);
+  CheckRoutes ("dual-homed host link up (router side)");
+
+  itf = GetInterface (core[0], 0);
+  itf.first->SetDown (itf.second);
+  CheckRoutes ("router link down");
+  itf.first->SetUp (itf.second);
+  CheckRoutes ("router link up");
+
+  itf = GetInterface (core[6], 1);
+  itf.first->SetMetric (itf.second, 3);
+  CheckRoutes ("router link metric change");
+  itf = GetInterface (access[4], 0);
+  itf.first->SetMetric (itf.second, 5);
+  CheckRoutes ("host link metric change");
+
+  NetDeviceContainer stub = lanHelper.Install (hosts.Get (5), CreateObject<SimpleChannel> ());
+  ipv4.SetBase ("172.16.0.0", "255.255.255.0");
+  ipv4.Assign (stub);
+  CheckRoutes ("stub network added to a host");
+  itf = GetInterface (stub, 0);
+  itf.first->SetDown (itf.second);
+  CheckRoutes ("stub network removed from a host");
+
+  itf = GetInterface (lan, 2);
+  itf.first->SetDown (itf.second);
+  CheckRoutes ("LAN host down");
+  itf = GetInterface (lan, 0);
+  itf.first->SetDown (itf.second);
+  CheckRoutes ("LAN router down");
+  itf.first->SetUp (itf.second);
+  GetInterface (lan, 2).first->SetUp (GetInterface (lan, 2).second);
+  CheckRoutes ("LAN up");
+
+  Simulator::Destroy ();
+}
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -1267,6 +1587,8 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite ()
     AddTestCase (new TwoBridgeTest, TestCase::QUICK);
     AddTestCase (new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
     AddTestCase (new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingLpmTestCase, TestCase::QUICK);
+    AddTestCase (new Ipv4GlobalRoutingIncrementalTestCase, TestCase::QUICK);
   }
 
 static Ipv4GlobalRoutingTestSuite g_globalRoutingTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,299 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/udp-header.h"
+#include "ns3/udp-l4-protocol.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/inet-socket-address.h"
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 batched receive test
+ *
+ * Delivers the same packets to two identical nodes, one packet at a time to
+ * the first one and in a single batch to the second one, and checks that the
+ * traces and the sockets see the same packets in the same order.
+ */
+class Ipv4ReceiveBatchTestCase : public TestCase
+{
+public:
+  Ipv4ReceiveBatchTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  /**
+   * \brief Create a node with an interface and two UDP sockets.
+   * \param index The index of the node.
+   */
+  void SetupNode (uint32_t index);
+
+  /**
+   * \brief Build a UDP packet received by the nodes.
+   * \param source The source address.
+   * \param destination The destination address.
+   * \param sourcePort The source port.
+   * \param destinationPort The destination port.
+   * \return The packet, with its IPv4 header.
+   */
+  Ptr<const Packet> BuildPacket (Ipv4Address source, Ipv4Address destination,
+                                 uint16_t sourcePort, uint16_t destinationPort);
+
+  /**
+   * \brief Rx trace sink.
+   * \param context The index of the node.
+   * \param p The packet.
+   * \param ipv4 The IPv4 stack.
+   * \param interface The interface.
+   */
+  void Rx (std::string context, Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface);
+
+  /**
+   * \brief Drop trace sink.
+   * \param context The index of the node.
+   * \param header The IPv4 header.
+   * \param p The packet.
+   * \param reason The drop reason.
+   * \param ipv4 The IPv4 stack.
+   * \param interface The interface.
+   */
+  void Drop (std::string context, const Ipv4Header &header, Ptr<const Packet> p,
+             Ipv4L3Protocol::DropReason reason, Ptr<Ipv4> ipv4, uint32_t interface);
+
+  /**
+   * \brief LocalDeliver and UnicastForward trace sink.
+   * \param context The index of the node and the trace.
+   * \param header The IPv4 header.
+   * \param p The packet.
+   * \param interface The interface.
+   */
+  void Deliver (std::string context, const Ipv4Header &header, Ptr<const Packet> p, uint32_t interface);
+
+  /**
+   * \brief Receive the packets of a socket.
+   * \param socket The socket.
+   */
+  void ReceivePkt (Ptr<Socket> socket);
+
+  /**
+   * \brief Log an event of a node.
+   * \param context The index of the node, followed by the event name.
+   * \param p The packet.
+   */
+  void Log (std::string context, Ptr<const Packet> p);
+
+  Ptr<Node> m_nodes[2];                 //!< The nodes.
+  Ptr<NetDevice> m_devices[2];          //!< The devices of the nodes.
+  std::vector<std::string> m_events[2]; //!< The events of each node.
+  uint32_t m_received[2][2];            //!< Packets received by the sockets of each node.
+};
+
+Ipv4ReceiveBatchTestCase::Ipv4ReceiveBatchTestCase ()
+  : TestCase ("IPv4 batched receive")
+{
+}
+
+void
+Ipv4ReceiveBatchTestCase::Log (std::string context, Ptr<const Packet> p)
+{
+  std::istringstream is (context);
+  uint32_t index;
+  std::string event;
+  is >> index >> event;
+  std::ostringstream os;
+  os << event << " " << p->GetUid ();
+  m_events[index].push_back (os.str ());
+}
+
+void
+Ipv4ReceiveBatchTestCase::Rx (std::string context, Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  Log (context + " rx", p);
+}
+
+void
+Ipv4ReceiveBatchTestCase::Drop (std::string context, const Ipv4Header &header, Ptr<const Packet> p,
+                                Ipv4L3Protocol::DropReason reason, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  std::ostringstream os;
+  os << context << " drop" << reason;
+  Log (os.str (), p);
+}
+
+void
+Ipv4ReceiveBatchTestCase::Deliver (std::string context, const Ipv4Header &header, Ptr<const Packet> p,
+                                   uint32_t interface)
+{
+  Log (context, p);
+}
+
+void
+Ipv4ReceiveBatchTestCase::ReceivePkt (Ptr<Socket> socket)
+{
+  uint32_t index = socket->GetNode () == m_nodes[0] ? 0 : 1;
+  Address from;
+  Ptr<Packet> p;
+  while ((p = socket->RecvFrom (from)))
+    {
+      Address local;
+      socket->GetSockName (local);
+      uint16_t port = InetSocketAddress::ConvertFrom (local).GetPort ();
+      std::ostringstream os;
+      os << index << " socket" << port;
+      Log (os.str (), p);
+      m_received[index][port - 1234]++;
+    }
+}
+
+void
+Ipv4ReceiveBatchTestCase::SetupNode (uint32_t index)
+{
+  m_nodes[index] = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (m_nodes[index]);
+
+  SimpleNetDeviceHelper helper;
+  m_devices[index] = helper.Install (m_nodes[index]).Get (0);
+
+  Ptr<Ipv4> ipv4 = m_nodes[index]->GetObject<Ipv4> ();
+  uint32_t interface = ipv4->AddInterface (m_devices[index]);
+  ipv4->AddAddress (interface, Ipv4InterfaceAddress ("10.0.0.1", "255.255.255.0"));
+  ipv4->SetUp (interface);
+
+  std::ostringstream context;
+  context << index;
+  ipv4->TraceConnect ("Rx", context.str (), MakeCallback (&Ipv4ReceiveBatchTestCase::Rx, this));
+  ipv4->TraceConnect ("Drop", context.str (), MakeCallback (&Ipv4ReceiveBatchTestCase::Drop, this));
+  ipv4->TraceConnect ("LocalDeliver", context.str () + " local",
+                      MakeCallback (&Ipv4ReceiveBatchTestCase::Deliver, this));
+  ipv4->TraceConnect ("UnicastForward", context.str () + " forward",
+                      MakeCallback (&Ipv4ReceiveBatchTestCase::Deliver, this));
+
+  for (uint16_t port = 1234; port <= 1235; port++)
+    {
+      Ptr<Socket> socket = m_nodes[index]->GetObject<UdpSocketFactory> ()->CreateSocket ();
+      NS_TEST_EXPECT_MSG_EQ (socket->Bind (InetSocketAddress (Ipv4Address::GetAny (), port)), 0,
+                             "Bind failed");
+      socket->SetRecvCallback (MakeCallback (&Ipv4ReceiveBatchTestCase::ReceivePkt, this));
+      m_received[index][port - 1234] = 0;
+    }
+}
+
+Ptr<const Packet>
+Ipv4ReceiveBatchTestCase::BuildPacket (Ipv4Address source, Ipv4Address destination,
+                                       uint16_t sourcePort, uint16_t destinationPort)
+{
+  Ptr<Packet> p = Create<Packet> (100);
+  UdpHeader udpHeader;
+  udpHeader.SetSourcePort (sourcePort);
+  udpHeader.SetDestinationPort (destinationPort);
+  p->AddHeader (udpHeader);
+
+  Ipv4Header ipHeader;
+  ipHeader.SetSource (source);
+  ipHeader.SetDestination (destination);
+  ipHeader.SetProtocol (UdpL4Protocol::PROT_NUMBER);
+  ipHeader.SetPayloadSize (p->GetSize ());
+  ipHeader.SetTtl (64);
+  p->AddHeader (ipHeader);
+  return p;
+}
+
+void
+Ipv4ReceiveBatchTestCase::DoRun (void)
+{
+  SetupNode (0);
+  SetupNode (1);
+
+  Ipv4Address local ("10.0.0.1");
+  Ipv4Address peer ("10.0.0.2");
+  std::vector<Ptr<const Packet> > packets;
+  // A run of two flows to the same address, another source, and a packet to forward
+  packets.push_back (BuildPacket (peer, local, 5000, 1234));
+  packets.push_back (BuildPacket (peer, local, 5000, 1234));
+  packets.push_back (BuildPacket (peer, local, 5001, 1235));
+  packets.push_back (BuildPacket (peer, local, 5000, 1234));
+  packets.push_back (BuildPacket (peer, local, 5001, 1235));
+  packets.push_back (BuildPacket ("10.0.0.3", local, 5000, 1234));
+  packets.push_back (BuildPacket (peer, "10.0.0.9", 5000, 1234));
+  packets.push_back (BuildPacket (peer, local, 5000, 1234));
+
+  Ptr<Ipv4L3Protocol> ipv4 = m_nodes[0]->GetObject<Ipv4L3Protocol> ();
+  for (uint32_t i = 0; i < packets.size (); i++)
+    {
+      Simulator::Schedule (Seconds (1), &Ipv4L3Protocol::Receive, ipv4, m_devices[0], packets[i],
+                           Ipv4L3Protocol::PROT_NUMBER, m_devices[0]->GetAddress (),
+                           m_devices[0]->GetAddress (), NetDevice::PACKET_HOST);
+    }
+  ipv4 = m_nodes[1]->GetObject<Ipv4L3Protocol> ();
+  Simulator::Schedule (Seconds (1), &Ipv4L3Protocol::ReceiveBatch, ipv4, m_devices[1], packets,
+                       Ipv4L3Protocol::PROT_NUMBER, m_devices[1]->GetAddress (),
+                       m_devices[1]->GetAddress (), NetDevice::PACKET_HOST);
+  Simulator::Run ();
+
+  NS_TEST_EXPECT_MSG_EQ (m_received[0][0], 5, "Wrong number of packets received on port 1234");
+  NS_TEST_EXPECT_MSG_EQ (m_received[0][1], 2, "Wrong number of packets received on port 1235");
+  NS_TEST_EXPECT_MSG_EQ (std::count (m_events[0].begin (), m_events[0].end (), "forward " +
+                                     std::to_string (packets[6]->GetUid ())), 1, "Packet not forwarded");
+  NS_TEST_EXPECT_MSG_EQ (m_received[1][0], m_received[0][0], "Batch delivered other packets on port 1234");
+  NS_TEST_EXPECT_MSG_EQ (m_received[1][1], m_received[0][1], "Batch delivered other packets on port 1235");
+  NS_TEST_ASSERT_MSG_EQ (m_events[1].size (), m_events[0].size (), "Batch fired other traces");
+  for (uint32_t i = 0; i < m_events[0].size (); i++)
+    {
+      NS_TEST_EXPECT_MSG_EQ (m_events[1][i], m_events[0][i], "Batch fired other traces");
+    }
+
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      m_nodes[i] = 0;
+      m_devices[i] = 0;
+    }
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief IPv4 batched receive TestSuite
+ */
+class Ipv4ReceiveBatchTestSuite : public TestSuite
+{
+public:
+  Ipv4ReceiveBatchTestSuite ()
+    : TestSuite ("ipv4-receive-batch", UNIT)
+  {
+    AddTestCase (new Ipv4ReceiveBatchTestCase, TestCase::QUICK);
+  }
+};
+
+static Ipv4ReceiveBatchTestSuite g_ipv4ReceiveBatchTestSuite; //!< Static variable for test initialization
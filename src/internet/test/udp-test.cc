@@ -52,6 +52,8 @@
 #include "ns3/ipv6-list-routing.h"
 #include "ns3/ipv6-static-routing.h"
 #include "ns3/ipv6-address-helper.h"
+#include "ns3/ipv4-static-routing-helper.h"
+#include "ns3/ipv4-routing-table-entry.h"
 
 #include <string>
 #include <limits>
@@ -708,6 +710,119 @@ Udp6SocketImplTest::DoRun (void)
 }
 
 
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief UDP Socket route reuse Test
+ *
+ * The sockets reuse the route of their previous datagram to the same
+ * destination. Checks that they follow the changes of the routes.
+ */
+class UdpSocketRouteCacheTest : public TestCase
+{
+public:
+  UdpSocketRouteCacheTest ();
+  virtual void DoRun (void);
+
+  /**
+   * \brief Tx trace sink.
+   * \param p The packet.
+   * \param ipv4 The IPv4 stack.
+   * \param interface The interface.
+   */
+  void Tx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface);
+
+  /**
+   * \brief Send a datagram and get its output interface.
+   * \param socket The sending socket.
+   * \param to The destination address.
+   * \return The output interface, or 0 if the datagram was not sent.
+   */
+  uint32_t SendTo (Ptr<Socket> socket, Ipv4Address to);
+
+  uint32_t m_txInterface; //!< Output interface of the last datagram
+};
+
+UdpSocketRouteCacheTest::UdpSocketRouteCacheTest ()
+  : TestCase ("UDP route reuse test")
+{
+}
+
+void
+UdpSocketRouteCacheTest::Tx (Ptr<const Packet> p, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+  m_txInterface = interface;
+}
+
+uint32_t
+UdpSocketRouteCacheTest::SendTo (Ptr<Socket> socket, Ipv4Address to)
+{
+  m_txInterface = 0;
+  socket->SendTo (Create<Packet> (123), 0, InetSocketAddress (to, 1234));
+  return m_txInterface;
+}
+
+void
+UdpSocketRouteCacheTest::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      SimpleNetDeviceHelper helper;
+      Ptr<NetDevice> device = helper.Install (node).Get (0);
+      uint32_t interface = ipv4->AddInterface (device);
+      ipv4->AddAddress (interface, Ipv4InterfaceAddress (Ipv4Address (0x0a000001 + (i << 8)), "/24"));
+      ipv4->SetUp (interface);
+    }
+  ipv4->TraceConnectWithoutContext ("Tx", MakeCallback (&UdpSocketRouteCacheTest::Tx, this));
+
+  Ipv4StaticRoutingHelper staticRoutingHelper;
+  Ptr<Ipv4StaticRouting> staticRouting = staticRoutingHelper.GetStaticRouting (ipv4);
+  staticRouting->AddNetworkRouteTo ("10.0.5.0", "255.255.255.0", "10.0.0.2", 1);
+
+  Ptr<SocketFactory> socketFactory = node->GetObject<UdpSocketFactory> ();
+  Ptr<Socket> socket = socketFactory->CreateSocket ();
+  socket->Bind ();
+  Ptr<Socket> boundSocket = socketFactory->CreateSocket ();
+  boundSocket->Bind (InetSocketAddress ("10.0.1.1", 0));
+
+  Ipv4Address dest ("10.0.5.1");
+  NS_TEST_EXPECT_MSG_EQ (SendTo (socket, dest), 1, "Wrong output interface");
+  NS_TEST_EXPECT_MSG_EQ (SendTo (socket, dest), 1, "Wrong output interface with the previous route");
+  NS_TEST_EXPECT_MSG_EQ (SendTo (boundSocket, dest), 1, "Wrong output interface");
+  NS_TEST_EXPECT_MSG_EQ (SendTo (boundSocket, dest), 1, "Wrong output interface with the previous route");
+
+  // A more specific route
+  staticRouting->AddHostRouteTo (dest, "10.0.1.2", 2);
+  NS_TEST_EXPECT_MSG_EQ (SendTo (socket, dest), 2, "Added route not used");
+  NS_TEST_EXPECT_MSG_EQ (SendTo (boundSocket, dest), 2, "Added route not used");
+  NS_TEST_EXPECT_MSG_EQ (SendTo (socket, "10.0.5.2"), 1, "Wrong route to another destination");
+
+  // The interface of the route goes down
+  ipv4->SetDown (2);
+  NS_TEST_EXPECT_MSG_EQ (SendTo (socket, dest), 1, "Route of a down interface used");
+  NS_TEST_EXPECT_MSG_EQ (SendTo (boundSocket, dest), 1, "Route of a down interface used");
+
+  // No more route
+  for (uint32_t i = staticRouting->GetNRoutes (); i > 0; i--)
+    {
+      if (staticRouting->GetRoute (i - 1).GetDestNetwork () == "10.0.5.0")
+        {
+          staticRouting->RemoveRoute (i - 1);
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (SendTo (socket, dest), 0, "Removed route used");
+  NS_TEST_EXPECT_MSG_EQ (SendTo (boundSocket, dest), 0, "Removed route used");
+
+  Simulator::Destroy ();
+}
+
+
 /**
  * \ingroup internet-test
  * \ingroup tests
@@ -723,6 +838,7 @@ public:
     AddTestCase (new UdpSocketLoopbackTest, TestCase::QUICK);
     AddTestCase (new Udp6SocketImplTest, TestCase::QUICK);
     AddTestCase (new Udp6SocketLoopbackTest, TestCase::QUICK);
+    AddTestCase (new UdpSocketRouteCacheTest, TestCase::QUICK);
   }
 };
 
@@ -20,6 +20,8 @@
 #include "buffer.h"
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include <atomic>
+#include <cstring>
 
 #define LOG_INTERNAL_STATE(y)                                                                    \
   NS_LOG_LOGIC (y << "start="<<m_start<<", end="<<m_end<<", zero start="<<m_zeroAreaStart<<              \
@@ -50,8 +52,22 @@ namespace ns3 {
 NS_LOG_COMPONENT_DEFINE ("Buffer");
 
 
-uint32_t Buffer::g_recommendedStart = 0;
+thread_local uint32_t Buffer::g_recommendedStart = 0;
 #ifdef BUFFER_FREE_LIST
+/* The buffer data storages are recycled by size class: the storages of
+ * class i hold exactly BUFFER_MIN_CLASS_SIZE << i bytes, and larger ones
+ * are not recycled. Each thread keeps its own free lists, so that they
+ * are never shared. The storages which do not fit in the free lists of a
+ * thread, or which are left when a thread exits, are pushed on global
+ * lock-free overflow stacks, which a thread takes as a whole when its
+ * free list is empty: since no storage is ever popped alone from an
+ * overflow stack, the stacks are not exposed to the ABA problem.
+ */
+#define BUFFER_MIN_CLASS_SIZE 64
+#define BUFFER_SIZE_CLASSES 11
+#define BUFFER_FREE_LIST_SIZE 256
+#define BUFFER_OVERFLOW_SIZE 4096
+
 /* The following macros are pretty evil but they are needed to allow us to
  * keep track of 3 possible states for the g_freeList variable:
  *  - uninitialized means that no one has created a buffer yet
@@ -75,43 +91,140 @@ uint32_t Buffer::g_recommendedStart = 0;
 #define IS_INITIALIZED(x) (!IS_UNINITIALIZED (x) && !IS_DESTROYED (x))
 #define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
 #define UNINITIALIZED ((Buffer::FreeList*)0)
-uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList *Buffer::g_freeList = 0;
-struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
+
+struct Buffer::FreeList
+{
+  std::vector<struct Buffer::Data *> m_classes[BUFFER_SIZE_CLASSES]; //!< Free storages of each size class
+  uint64_t m_hits;   //!< Storages taken from the free lists
+  uint64_t m_misses; //!< Storages allocated
+};
+
+thread_local Buffer::FreeList *Buffer::g_freeList = 0;
+thread_local struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
+struct Buffer::GlobalStaticDestructor Buffer::g_globalStaticDestructor;
+
+/// Overflow stack of each size class, linked through the first bytes of the storages
+static std::atomic<uint8_t *> g_overflow[BUFFER_SIZE_CLASSES];
+/// Number of storages in the overflow stacks
+static std::atomic<uint32_t> g_overflowSize (0);
+/// True once the overflow stacks have been deallocated
+static std::atomic<bool> g_overflowDestroyed (false);
+
+/**
+ * \ingroup packet
+ * \brief Get the size class of a buffer data storage.
+ * \param size the size of the storage
+ * \returns the smallest size class which can hold size bytes, which is
+ *          BUFFER_SIZE_CLASSES or more if the storage is too large to be
+ *          recycled
+ */
+static uint32_t
+GetSizeClass (uint32_t size)
+{
+  uint32_t sizeClass = 0;
+  while (sizeClass < BUFFER_SIZE_CLASSES &&
+         (static_cast<uint32_t> (BUFFER_MIN_CLASS_SIZE) << sizeClass) < size)
+    {
+      sizeClass++;
+    }
+  return sizeClass;
+}
 
 Buffer::LocalStaticDestructor::~LocalStaticDestructor(void)
 {
   NS_LOG_FUNCTION (this);
   if (IS_INITIALIZED (g_freeList))
     {
-      for (Buffer::FreeList::iterator i = g_freeList->begin ();
-           i != g_freeList->end (); i++)
+      for (uint32_t sizeClass = 0; sizeClass < BUFFER_SIZE_CLASSES; sizeClass++)
         {
-          Buffer::Deallocate (*i);
+          std::vector<struct Buffer::Data *> &list = g_freeList->m_classes[sizeClass];
+          for (std::vector<struct Buffer::Data *>::iterator i = list.begin ();
+               i != list.end (); i++)
+            {
+              PushOverflow (*i, sizeClass);
+            }
         }
       delete g_freeList;
       g_freeList = DESTROYED;
     }
 }
 
+Buffer::GlobalStaticDestructor::~GlobalStaticDestructor (void)
+{
+  NS_LOG_FUNCTION (this);
+  g_overflowDestroyed = true;
+  for (uint32_t sizeClass = 0; sizeClass < BUFFER_SIZE_CLASSES; sizeClass++)
+    {
+      uint8_t *buf = g_overflow[sizeClass].exchange (0);
+      while (buf != 0)
+        {
+          struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data *> (buf);
+          std::memcpy (&buf, data->m_data, sizeof (buf));
+          Buffer::Deallocate (data);
+        }
+    }
+  g_overflowSize = 0;
+}
+
+void
+Buffer::PushOverflow (struct Buffer::Data *data, uint32_t sizeClass)
+{
+  NS_LOG_FUNCTION (data << sizeClass);
+  if (g_overflowDestroyed)
+    {
+      Buffer::Deallocate (data);
+      return;
+    }
+  if (g_overflowSize.fetch_add (1) >= BUFFER_OVERFLOW_SIZE)
+    {
+      g_overflowSize--;
+      Buffer::Deallocate (data);
+      return;
+    }
+  uint8_t *buf = reinterpret_cast<uint8_t *> (data);
+  uint8_t *next = g_overflow[sizeClass].load ();
+  do
+    {
+      std::memcpy (data->m_data, &next, sizeof (next));
+    }
+  while (!g_overflow[sizeClass].compare_exchange_weak (next, buf));
+}
+
+void
+Buffer::PopOverflow (uint32_t sizeClass)
+{
+  NS_LOG_FUNCTION (sizeClass);
+  NS_ASSERT (IS_INITIALIZED (g_freeList));
+  uint8_t *buf = g_overflow[sizeClass].exchange (0);
+  while (buf != 0)
+    {
+      struct Buffer::Data *data = reinterpret_cast<struct Buffer::Data *> (buf);
+      std::memcpy (&buf, data->m_data, sizeof (buf));
+      g_freeList->m_classes[sizeClass].push_back (data);
+      g_overflowSize--;
+    }
+}
+
 void
 Buffer::Recycle (struct Buffer::Data *data)
 {
   NS_LOG_FUNCTION (data);
   NS_ASSERT (data->m_count == 0);
-  NS_ASSERT (!IS_UNINITIALIZED (g_freeList));
-  g_maxSize = std::max (g_maxSize, data->m_size);
-  /* feed into free list */
-  if (data->m_size < g_maxSize ||
-      IS_DESTROYED (g_freeList) ||
-      g_freeList->size () > 1000)
+  uint32_t sizeClass = GetSizeClass (data->m_size);
+  /* feed into the free list of the size class */
+  if (!IS_INITIALIZED (g_freeList) ||
+      sizeClass >= BUFFER_SIZE_CLASSES ||
+      data->m_size != (static_cast<uint32_t> (BUFFER_MIN_CLASS_SIZE) << sizeClass))
     {
       Buffer::Deallocate (data);
     }
+  else if (g_freeList->m_classes[sizeClass].size () >= BUFFER_FREE_LIST_SIZE)
+    {
+      PushOverflow (data, sizeClass);
+    }
   else
     {
-      NS_ASSERT (IS_INITIALIZED (g_freeList));
-      g_freeList->push_back (data);
+      g_freeList->m_classes[sizeClass].push_back (data);
     }
 }
 
@@ -123,25 +236,50 @@ Buffer::Create (uint32_t dataSize)
   if (IS_UNINITIALIZED (g_freeList))
     {
       g_freeList = new Buffer::FreeList ();
+      // Referencing the destructor of the free lists of this thread
+      // registers it to run when the thread exits.
+      (void) &g_localStaticDestructor;
     }
-  else if (IS_INITIALIZED (g_freeList))
+  if (IS_INITIALIZED (g_freeList))
     {
-      while (!g_freeList->empty ()) 
+      // leave room for the largest headers seen, within the size classes
+      uint32_t maxClassSize = static_cast<uint32_t> (BUFFER_MIN_CLASS_SIZE) << (BUFFER_SIZE_CLASSES - 1);
+      uint32_t sizeClass = GetSizeClass (std::max (dataSize, std::min (g_recommendedStart, maxClassSize)));
+      if (sizeClass < BUFFER_SIZE_CLASSES)
         {
-          struct Buffer::Data *data = g_freeList->back ();
-          g_freeList->pop_back ();
-          if (data->m_size >= dataSize) 
+          std::vector<struct Buffer::Data *> &list = g_freeList->m_classes[sizeClass];
+          if (list.empty ())
             {
+              PopOverflow (sizeClass);
+            }
+          if (!list.empty ())
+            {
+              struct Buffer::Data *data = list.back ();
+              list.pop_back ();
               data->m_count = 1;
+              g_freeList->m_hits++;
               return data;
             }
-          Buffer::Deallocate (data);
+          dataSize = static_cast<uint32_t> (BUFFER_MIN_CLASS_SIZE) << sizeClass;
         }
+      g_freeList->m_misses++;
     }
   struct Buffer::Data *data = Buffer::Allocate (dataSize);
   NS_ASSERT (data->m_count == 1);
   return data;
 }
+
+uint64_t
+Buffer::GetFreeListHits (void)
+{
+  return IS_INITIALIZED (g_freeList) ? g_freeList->m_hits : 0;
+}
+
+uint64_t
+Buffer::GetFreeListMisses (void)
+{
+  return IS_INITIALIZED (g_freeList) ? g_freeList->m_misses : 0;
+}
 #else /* BUFFER_FREE_LIST */
 void
 Buffer::Recycle (struct Buffer::Data *data)
@@ -157,6 +295,18 @@ Buffer::Create (uint32_t size)
   NS_LOG_FUNCTION (size);
   return Allocate (size);
 }
+
+uint64_t
+Buffer::GetFreeListHits (void)
+{
+  return 0;
+}
+
+uint64_t
+Buffer::GetFreeListMisses (void)
+{
+  return 0;
+}
 #endif /* BUFFER_FREE_LIST */
 
 struct Buffer::Data *
@@ -432,6 +582,19 @@ Buffer::AddAtEnd (const Buffer &o)
     }
 
   *this = CreateFullCopy ();
+  if (m_data == o.m_data)
+    {
+      /**
+       * o still shares our storage (e.g. it is a fragment of this
+       * buffer) and growing in place would write over the bytes we
+       * read, so append a private copy of o instead.
+       */
+      Buffer copy;
+      copy.AddAtEnd (o.GetSize ());
+      copy.Begin ().Write (o.Begin (), o.End ());
+      AddAtEnd (copy);
+      return;
+    }
   AddAtEnd (o.GetSize ());
   Buffer::Iterator destStart = End ();
   destStart.Prev (o.GetSize ());
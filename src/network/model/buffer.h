@@ -38,9 +38,9 @@ namespace ns3 {
  * automatically adjusted to hold any data prepended
  * or appended by the user. Its implementation is optimized
  * to ensure that the number of buffer resizes is minimized,
- * by creating new Buffers of the maximum size ever used.
- * The correct maximum size is learned at runtime during use by 
- * recording the maximum size of each packet.
+ * by creating new Buffers with room for the largest headers ever
+ * prepended. The correct size is learned at runtime during use by
+ * recording the maximum size of the headers of each packet.
  *
  * \internal
  * The implementation of the Buffer class uses a COW (Copy On Write)
@@ -59,6 +59,12 @@ namespace ns3 {
  * In every other case, the BufferData must be copied before
  * being modified.
  *
+ * The BufferData instances which are no longer referenced are kept in
+ * free lists, one per power-of-two size class and per thread, so that
+ * the threads of a simulation never share them. The storage each
+ * thread cannot keep goes to global overflow stacks from which the
+ * other threads refill their free lists.
+ *
  * To understand the way the Buffer::Add and Buffer::Remove methods
  * work, you first need to understand the "virtual offsets" used to
  * keep track of the content of buffers. Each Buffer instance
@@ -642,6 +648,21 @@ private:
    */
   Buffer (uint32_t dataSize, bool initialize);
   ~Buffer ();
+
+  /**
+   * \brief Get the number of buffer data storages which the calling
+   * thread took from the free lists rather than allocating them.
+   *
+   * \returns the number of free list hits of the calling thread
+   */
+  static uint64_t GetFreeListHits (void);
+  /**
+   * \brief Get the number of buffer data storages which the calling
+   * thread allocated because the free lists had none of the right size.
+   *
+   * \returns the number of free list misses of the calling thread
+   */
+  static uint64_t GetFreeListMisses (void);
 private:
   /**
    * This data structure is variable-sized through its last member whose size
@@ -765,9 +786,9 @@ private:
   /**
    * location in a newly-allocated buffer where you should start
    * writing data. i.e., m_start should be initialized to this 
-   * value.
+   * value. Each thread learns its own value.
    */
-  static uint32_t g_recommendedStart;
+  static thread_local uint32_t g_recommendedStart;
 
   /**
    * offset to the start of the virtual zero area from the start
@@ -791,16 +812,35 @@ private:
   uint32_t m_end;
 
 #ifdef BUFFER_FREE_LIST
-  /// Container for buffer data
-  typedef std::vector<struct Buffer::Data*> FreeList;
-  /// Local static destructor structure
+  /**
+   * \brief Move a buffer data storage to the global overflow stack of
+   * its size class, or deallocate it if the stack is full.
+   * \param data the buffer data storage
+   * \param sizeClass the size class of the storage
+   */
+  static void PushOverflow (struct Buffer::Data *data, uint32_t sizeClass);
+  /**
+   * \brief Move the global overflow stack of a size class to the free
+   * list of the calling thread.
+   * \param sizeClass the size class
+   */
+  static void PopOverflow (uint32_t sizeClass);
+
+  /// Free lists of a thread, one per size class
+  struct FreeList;
+  /// Local static destructor structure, giving the free lists of a thread away on exit
   struct LocalStaticDestructor 
   {
     ~LocalStaticDestructor ();
   };
-  static uint32_t g_maxSize; //!< Max observed data size
-  static FreeList *g_freeList; //!< Buffer data container
-  static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
+  /// Global static destructor structure, deallocating the overflow stacks
+  struct GlobalStaticDestructor
+  {
+    ~GlobalStaticDestructor ();
+  };
+  static thread_local FreeList *g_freeList; //!< Buffer data free lists of the thread
+  static thread_local struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
+  static struct GlobalStaticDestructor g_globalStaticDestructor; //!< Global static destructor
 #endif
 };
 
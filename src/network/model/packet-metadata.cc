@@ -655,6 +655,11 @@ PacketMetadata::AddHeader (const Header &header, uint32_t size)
 {
   NS_LOG_FUNCTION (this << &header << size);
   NS_ASSERT (IsStateOk ());
+  if (!m_enable)
+    {
+      m_metadataSkipped = true;
+      return;
+    }
   uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
   DoAddHeader (uid, size);
   NS_ASSERT (IsStateOk ());
@@ -682,14 +687,14 @@ PacketMetadata::DoAddHeader (uint32_t uid, uint32_t size)
 void 
 PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
 {
-  uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &header << size);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
+  if (!m_enable)
     {
       m_metadataSkipped = true;
       return;
     }
+  uint32_t uid = header.GetInstanceTypeId ().GetUid () << 1;
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_head, &item, &extraItem);
@@ -730,7 +735,6 @@ PacketMetadata::RemoveHeader (const Header &header, uint32_t size)
 void 
 PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
 {
-  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &trailer << size);
   NS_ASSERT (IsStateOk ());
   if (!m_enable)
@@ -738,6 +742,7 @@ PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
       m_metadataSkipped = true;
       return;
     }
+  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
   struct PacketMetadata::SmallItem item;
   item.next = 0xffff;
   item.prev = m_tail;
@@ -752,14 +757,14 @@ PacketMetadata::AddTrailer (const Trailer &trailer, uint32_t size)
 void 
 PacketMetadata::RemoveTrailer (const Trailer &trailer, uint32_t size)
 {
-  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
   NS_LOG_FUNCTION (this << &trailer << size);
   NS_ASSERT (IsStateOk ());
-  if (!m_enable) 
+  if (!m_enable)
     {
       m_metadataSkipped = true;
       return;
     }
+  uint32_t uid = trailer.GetInstanceTypeId ().GetUid () << 1;
   struct PacketMetadata::SmallItem item;
   struct PacketMetadata::ExtraItem extraItem;
   uint32_t read = ReadItems (m_tail, &item, &extraItem);
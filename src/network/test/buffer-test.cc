@@ -389,6 +389,54 @@ BufferTest::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ (val1, val2, "Bad ReadNtohU16()");
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Buffer free lists unit tests.
+ */
+class BufferFreeListTest : public TestCase {
+public:
+  virtual void DoRun (void);
+  BufferFreeListTest ();
+};
+
+BufferFreeListTest::BufferFreeListTest ()
+  : TestCase ("Buffer free lists") {
+}
+
+void
+BufferFreeListTest::DoRun (void)
+{
+  // Storages of the size classes, and a storage too large to be recycled
+  uint32_t sizes[] = {10, 100, 1000, 10000, 1000000};
+  for (uint32_t i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++)
+    {
+      {
+        Buffer buffer;
+        buffer.AddAtEnd (sizes[i]);
+        buffer.Begin ().WriteU8 (1, sizes[i]);
+      }
+      uint64_t hits = Buffer::GetFreeListHits ();
+      uint64_t misses = Buffer::GetFreeListMisses ();
+      Buffer buffer;
+      buffer.AddAtEnd (sizes[i]);
+      buffer.Begin ().WriteU8 (2, sizes[i]);
+      NS_TEST_EXPECT_MSG_EQ (buffer.GetSize (), sizes[i], "Wrong buffer size");
+      NS_TEST_EXPECT_MSG_EQ (buffer.Begin ().ReadU8 (), 2, "Wrong buffer content");
+      if (sizes[i] <= 10000)
+        {
+          NS_TEST_EXPECT_MSG_GT (Buffer::GetFreeListHits (), hits,
+                                 "Recycled storage of " << sizes[i] << " bytes not reused");
+        }
+      else
+        {
+          NS_TEST_EXPECT_MSG_GT (Buffer::GetFreeListMisses (), misses,
+                                 "Storage of " << sizes[i] << " bytes recycled");
+        }
+    }
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -405,6 +453,7 @@ BufferTestSuite::BufferTestSuite ()
   : TestSuite ("buffer", UNIT)
 {
   AddTestCase (new BufferTest, TestCase::QUICK);
+  AddTestCase (new BufferFreeListTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite; //!< Static variable for test initialization
@@ -83,6 +83,63 @@ DropTailQueueTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ ((packet == 0), true, "There are really no packets in there");
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * DropTailQueue ring buffer storage tests.
+ */
+class DropTailQueueRingTestCase : public TestCase
+{
+public:
+  DropTailQueueRingTestCase ();
+  virtual void DoRun (void);
+};
+
+DropTailQueueRingTestCase::DropTailQueueRingTestCase ()
+  : TestCase ("Check the FIFO order across ring buffer wrap-around and growth")
+{
+}
+void
+DropTailQueueRingTestCase::DoRun (void)
+{
+  Ptr<DropTailQueue<Packet> > queue = CreateObject<DropTailQueue<Packet> > ();
+  queue->SetMaxSize (QueueSize ("1000p"));
+
+  // Keep a sliding window of packets in the queue, so that the head and tail
+  // indexes wrap around the ring buffer many times, while the depth grows.
+  std::list<Ptr<Packet> > expected;
+  uint32_t bytes = 0;
+  for (uint32_t i = 0; i < 2000; i++)
+    {
+      Ptr<Packet> p = Create<Packet> (i % 100 + 1);
+      NS_TEST_EXPECT_MSG_EQ (queue->Enqueue (p), true, "Enqueue failed");
+      expected.push_back (p);
+      bytes += p->GetSize ();
+
+      if (i % 3 != 0)
+        {
+          NS_TEST_EXPECT_MSG_EQ (queue->Peek (), expected.front (), "Wrong head packet");
+          Ptr<Packet> q = (i % 7 == 0) ? queue->Remove () : queue->Dequeue ();
+          NS_TEST_EXPECT_MSG_EQ (q, expected.front (), "Wrong packet order");
+          bytes -= q->GetSize ();
+          expected.pop_front ();
+        }
+      NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), expected.size (), "Wrong number of packets");
+      NS_TEST_EXPECT_MSG_EQ (queue->GetNBytes (), bytes, "Wrong number of bytes");
+    }
+
+  // Check the final state of the queue.
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNPackets (), 667, "Wrong number of packets");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetTotalDroppedPacketsAfterDequeue (), 190, "Wrong number of removed packets");
+
+  queue->Flush ();
+  NS_TEST_EXPECT_MSG_EQ (queue->IsEmpty (), true, "The queue should be empty");
+  NS_TEST_EXPECT_MSG_EQ (queue->GetNBytes (), 0, "There should be no bytes in there");
+  NS_TEST_EXPECT_MSG_EQ (queue->Dequeue (), 0, "There are really no packets in there");
+  NS_TEST_EXPECT_MSG_EQ (queue->Peek (), 0, "There are really no packets in there");
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -96,6 +153,7 @@ public:
     : TestSuite ("drop-tail-queue", UNIT)
   {
     AddTestCase (new DropTailQueueTestCase (), TestCase::QUICK);
+    AddTestCase (new DropTailQueueRingTestCase (), TestCase::QUICK);
   }
 };
 
@@ -900,6 +900,21 @@ PacketMetadataTest::DoRun (void)
                                  p3->GetSize ());
   delete [] buf;
   NS_TEST_EXPECT_MSG_EQ (msg, std::string ("hello world"), "Could not find original data in received packet");
+
+  // Empty packets and their copies keep separate histories once
+  // items are added to them.
+  p = Create<Packet> ();
+  p1 = p->Copy ();
+  p2 = p->CreateFragment (0, 0);
+  CHECK_HISTORY (p, 0);
+  ADD_HEADER (p1, 10);
+  CHECK_HISTORY (p1, 1, 10);
+  CHECK_HISTORY (p, 0);
+  p2->AddAtEnd (p1);
+  CHECK_HISTORY (p2, 1, 10);
+  REM_HEADER (p1, 10);
+  CHECK_HISTORY (p1, 0);
+  CHECK_HISTORY (p2, 1, 10);
 }
 
 
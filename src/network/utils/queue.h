@@ -34,6 +34,7 @@
 #include <string>
 #include <sstream>
 #include <list>
+#include <vector>
 
 namespace ns3 {
 
@@ -223,6 +224,66 @@ private:
 };
 
 
+/**
+ * \ingroup queue
+ * \brief Growable ring buffer used as FIFO storage by Queue
+ *
+ * Items are kept in a contiguous array whose size is a power of two. The array
+ * doubles when full and never shrinks, so pushing and popping items does not
+ * allocate memory once the queue has reached its steady-state depth.
+ */
+template <typename T>
+class QueueRingBuffer
+{
+public:
+  QueueRingBuffer ();
+
+  /**
+   * \return true if the buffer holds no items
+   */
+  bool IsEmpty (void) const;
+
+  /**
+   * \return the number of items in the buffer
+   */
+  uint32_t GetSize (void) const;
+
+  /**
+   * Append an item at the tail of the buffer
+   * \param item the item to append
+   */
+  void PushBack (const T &item);
+
+  /**
+   * Remove the item at the head of the buffer (the buffer must not be empty)
+   * \return the removed item
+   */
+  T PopFront (void);
+
+  /**
+   * Get the item at the head of the buffer (the buffer must not be empty)
+   * \return a reference to the head item
+   */
+  const T & Front (void) const;
+
+  /**
+   * Remove all items from the buffer, keeping the allocated storage
+   */
+  void Clear (void);
+
+private:
+  /**
+   * Double the storage size, moving the items to the beginning of the array
+   */
+  void Grow (void);
+
+  std::vector<T> m_items;   //!< the storage array
+  uint32_t m_head;          //!< the index of the head item
+  uint32_t m_size;          //!< the number of items
+};
+
+
+
 /**
  * \ingroup queue
  * \brief Template class for packet Queues
@@ -248,6 +309,13 @@ private:
  * \endcode
  *
  * Then, include queue.h in the corresponding .cc file.
+ *
+ * Items can be stored in two ways. The iterator-based methods (DoEnqueue,
+ * DoDequeue, DoRemove and DoPeek) keep the items in a list, allowing subclasses
+ * to insert and remove items at any position. FIFO queues can use instead the
+ * DoEnqueueTail, DoDequeueHead, DoRemoveHead and DoPeekHead methods, which keep
+ * the items in a ring buffer and do not allocate memory in steady state. A
+ * subclass must stick to one of the two ways for all the items in the queue.
  */
 template <typename Item>
 class Queue : public QueueBase
@@ -409,6 +477,31 @@ protected:
    */
   Ptr<const Item> DoPeek (ConstIterator pos) const;
 
+  /**
+   * Push an item at the tail of the FIFO storage
+   * \param item the item to enqueue
+   * \return true if success, false if the packet has been dropped.
+   */
+  bool DoEnqueueTail (Ptr<Item> item);
+
+  /**
+   * Pull the item at the head of the FIFO storage
+   * \return the item.
+   */
+  Ptr<Item> DoDequeueHead (void);
+
+  /**
+   * Pull the item at the head of the FIFO storage to drop it
+   * \return the item.
+   */
+  Ptr<Item> DoRemoveHead (void);
+
+  /**
+   * Peek the item at the head of the FIFO storage
+   * \return the item.
+   */
+  Ptr<const Item> DoPeekHead (void) const;
+
   /**
    * \brief Drop a packet before enqueue
    * \param item item that was dropped
@@ -432,7 +525,20 @@ protected:
   void DoDispose (void) override;
 
 private:
+  /**
+   * Update the statistics and fire the trace for an enqueued item
+   * \param item the item
+   */
+  void NotifyEnqueue (Ptr<Item> item);
+
+  /**
+   * Update the statistics and fire the trace for a dequeued item
+   * \param item the item
+   */
+  void NotifyDequeue (Ptr<Item> item);
+
   std::list<Ptr<Item> > m_packets;          //!< the items in the queue
+  QueueRingBuffer<Ptr<Item> > m_ring;       //!< the items in the FIFO storage
   NS_LOG_TEMPLATE_DECLARE;                  //!< the log component
 
   /// Traced callback: fired when a packet is enqueued
@@ -452,6 +558,84 @@ private:
  * Implementation of the templates declared above.
  */
 
+template <typename T>
+QueueRingBuffer<T>::QueueRingBuffer ()
+  : m_head (0),
+    m_size (0)
+{
+}
+
+template <typename T>
+bool
+QueueRingBuffer<T>::IsEmpty (void) const
+{
+  return m_size == 0;
+}
+
+template <typename T>
+uint32_t
+QueueRingBuffer<T>::GetSize (void) const
+{
+  return m_size;
+}
+
+template <typename T>
+void
+QueueRingBuffer<T>::PushBack (const T &item)
+{
+  if (m_size == m_items.size ())
+    {
+      Grow ();
+    }
+  m_items[(m_head + m_size) & (m_items.size () - 1)] = item;
+  m_size++;
+}
+
+template <typename T>
+T
+QueueRingBuffer<T>::PopFront (void)
+{
+  NS_ASSERT (m_size > 0);
+  // Move the item out of the array, so that the slot releases its reference
+  T item = std::move (m_items[m_head]);
+  m_items[m_head] = T ();
+  m_head = (m_head + 1) & (m_items.size () - 1);
+  m_size--;
+  return item;
+}
+
+template <typename T>
+const T &
+QueueRingBuffer<T>::Front (void) const
+{
+  NS_ASSERT (m_size > 0);
+  return m_items[m_head];
+}
+
+template <typename T>
+void
+QueueRingBuffer<T>::Clear (void)
+{
+  while (m_size > 0)
+    {
+      PopFront ();
+    }
+  m_head = 0;
+}
+
+template <typename T>
+void
+QueueRingBuffer<T>::Grow (void)
+{
+  std::vector<T> items (m_items.empty () ? 16 : 2 * m_items.size ());
+  for (uint32_t i = 0; i < m_size; i++)
+    {
+      items[i] = std::move (m_items[(m_head + i) & (m_items.size () - 1)]);
+    }
+  m_items.swap (items);
+  m_head = 0;
+}
+
 template <typename Item>
 TypeId
 Queue<Item>::GetTypeId (void)
@@ -503,6 +687,7 @@ bool
 Queue<Item>::DoEnqueue (ConstIterator pos, Ptr<Item> item, Iterator& ret)
 {
   NS_LOG_FUNCTION (this << item);
+  NS_ASSERT_MSG (m_ring.IsEmpty (), "Mixing iterator and FIFO storage");
 
   if (GetCurrentSize () + item > GetMaxSize ())
     {
@@ -512,7 +697,35 @@ Queue<Item>::DoEnqueue (ConstIterator pos, Ptr<Item> item, Iterator& ret)
     }
 
   ret = m_packets.insert (pos, item);
+  NotifyEnqueue (item);
+
+  return true;
+}
+
+template <typename Item>
+bool
+Queue<Item>::DoEnqueueTail (Ptr<Item> item)
+{
+  NS_LOG_FUNCTION (this << item);
+  NS_ASSERT_MSG (m_packets.empty (), "Mixing iterator and FIFO storage");
+
+  if (GetCurrentSize () + item > GetMaxSize ())
+    {
+      NS_LOG_LOGIC ("Queue full -- dropping pkt");
+      DropBeforeEnqueue (item);
+      return false;
+    }
 
+  m_ring.PushBack (item);
+  NotifyEnqueue (item);
+
+  return true;
+}
+
+template <typename Item>
+void
+Queue<Item>::NotifyEnqueue (Ptr<Item> item)
+{
   uint32_t size = item->GetSize ();
   m_nBytes += size;
   m_nTotalReceivedBytes += size;
@@ -522,8 +735,20 @@ Queue<Item>::DoEnqueue (ConstIterator pos, Ptr<Item> item, Iterator& ret)
 
   NS_LOG_LOGIC ("m_traceEnqueue (p)");
   m_traceEnqueue (item);
+}
 
-  return true;
+template <typename Item>
+void
+Queue<Item>::NotifyDequeue (Ptr<Item> item)
+{
+  NS_ASSERT (m_nBytes.Get () >= item->GetSize ());
+  NS_ASSERT (m_nPackets.Get () > 0);
+
+  m_nBytes -= item->GetSize ();
+  m_nPackets--;
+
+  NS_LOG_LOGIC ("m_traceDequeue (p)");
+  m_traceDequeue (item);
 }
 
 template <typename Item>
@@ -543,14 +768,28 @@ Queue<Item>::DoDequeue (ConstIterator pos)
 
   if (item != 0)
     {
-      NS_ASSERT (m_nBytes.Get () >= item->GetSize ());
-      NS_ASSERT (m_nPackets.Get () > 0);
+      NotifyDequeue (item);
+    }
+  return item;
+}
 
-      m_nBytes -= item->GetSize ();
-      m_nPackets--;
+template <typename Item>
+Ptr<Item>
+Queue<Item>::DoDequeueHead (void)
+{
+  NS_LOG_FUNCTION (this);
 
-      NS_LOG_LOGIC ("m_traceDequeue (p)");
-      m_traceDequeue (item);
+  if (m_ring.IsEmpty ())
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  Ptr<Item> item = m_ring.PopFront ();
+
+  if (item != 0)
+    {
+      NotifyDequeue (item);
     }
   return item;
 }
@@ -572,16 +811,31 @@ Queue<Item>::DoRemove (ConstIterator pos)
 
   if (item != 0)
     {
-      NS_ASSERT (m_nBytes.Get () >= item->GetSize ());
-      NS_ASSERT (m_nPackets.Get () > 0);
+      // packets are first dequeued and then dropped
+      NotifyDequeue (item);
+      DropAfterDequeue (item);
+    }
+  return item;
+}
 
-      m_nBytes -= item->GetSize ();
-      m_nPackets--;
+template <typename Item>
+Ptr<Item>
+Queue<Item>::DoRemoveHead (void)
+{
+  NS_LOG_FUNCTION (this);
 
-      // packets are first dequeued and then dropped
-      NS_LOG_LOGIC ("m_traceDequeue (p)");
-      m_traceDequeue (item);
+  if (m_ring.IsEmpty ())
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  Ptr<Item> item = m_ring.PopFront ();
 
+  if (item != 0)
+    {
+      // packets are first dequeued and then dropped
+      NotifyDequeue (item);
       DropAfterDequeue (item);
     }
   return item;
@@ -604,6 +858,7 @@ Queue<Item>::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
   m_packets.clear ();
+  m_ring.Clear ();
   Object::DoDispose ();
 }
 
@@ -622,6 +877,21 @@ Queue<Item>::DoPeek (ConstIterator pos) const
   return *pos;
 }
 
+template <typename Item>
+Ptr<const Item>
+Queue<Item>::DoPeekHead (void) const
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_ring.IsEmpty ())
+    {
+      NS_LOG_LOGIC ("Queue empty");
+      return 0;
+    }
+
+  return m_ring.Front ();
+}
+
 template <typename Item>
 typename Queue<Item>::ConstIterator Queue<Item>::begin (void) const
 {
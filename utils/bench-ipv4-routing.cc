@@ -0,0 +1,170 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program can be used to benchmark the route lookups of the
+// Ipv4GlobalRouting class on large routing tables. The prefix trie lookup
+// is compared with a linear scan over the same routes.
+// Sample usage:  ./waf --run 'bench-ipv4-routing --n=1000000 --routes=10000'
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/random-variable-stream.h"
+#include <iostream>
+#include <stdlib.h> // for exit ()
+#include <limits>
+#include <algorithm>
+#include <list>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * Lookup the longest matching network route with a linear scan.
+ * \param routes the network routes
+ * \param dest the destination address
+ * \return the route, or 0 if there is no route
+ */
+static Ipv4RoutingTableEntry *
+linearLookup (const std::list<Ipv4RoutingTableEntry *> &routes, Ipv4Address dest)
+{
+  Ipv4RoutingTableEntry *best = 0;
+  for (std::list<Ipv4RoutingTableEntry *>::const_iterator i = routes.begin ();
+       i != routes.end (); i++)
+    {
+      Ipv4Mask mask = (*i)->GetDestNetworkMask ();
+      if (mask.IsMatch (dest, (*i)->GetDestNetwork ())
+          && (best == 0 || mask.GetPrefixLength () > best->GetDestNetworkMask ().GetPrefixLength ()))
+        {
+          best = *i;
+        }
+    }
+  return best;
+}
+
+/**
+ * Print the number of lookups per second.
+ * \param n the number of lookups
+ * \param delay the elapsed time in milliseconds
+ * \param name the lookup name
+ */
+static void
+printResult (uint32_t n, uint64_t delay, char const *name)
+{
+  double ops = n;
+  ops *= 1000;
+  ops /= std::max<uint64_t> (delay, 1);
+  std::cout << ops << " lookups/s"
+            << " (" << delay << " ms elapsed)\t"
+            << name << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t nRoutes = 10000;
+  uint32_t minIterations = 1;
+
+  CommandLine cmd (__FILE__);
+  cmd.Usage ("Benchmark Ipv4GlobalRouting lookups");
+  cmd.AddValue ("n", "number of lookups", n);
+  cmd.AddValue ("routes", "number of network routes", nRoutes);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.Parse (argc, argv);
+
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of operations must be specified " <<
+        "by command-line argument --n=(number of operations)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-ipv4-routing with n=" << n
+            << " routes=" << nRoutes << std::endl;
+
+  Ptr<Node> node = CreateObject<Node> ();
+  SimpleNetDeviceHelper simpleHelper;
+  NetDeviceContainer net = simpleHelper.Install (node, CreateObject<SimpleChannel> ());
+  InternetStackHelper internet;
+  Ipv4GlobalRoutingHelper ipv4RoutingHelper;
+  internet.SetRoutingHelper (ipv4RoutingHelper);
+  internet.Install (node);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.0.0.0", "255.255.255.0");
+  ipv4.Assign (net);
+  Ptr<Ipv4GlobalRouting> routing =
+    node->GetObject<Ipv4L3Protocol> ()->GetRoutingProtocol ()->GetObject<Ipv4GlobalRouting> ();
+
+  // Random prefixes from /8 to /28, plus a default route
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  std::list<Ipv4RoutingTableEntry *> routes;
+  std::vector<Ipv4Address> dests;
+  for (uint32_t i = 0; i < nRoutes; i++)
+    {
+      uint32_t prefixLength = rng->GetInteger (8, 28);
+      uint32_t mask = 0xffffffff << (32 - prefixLength);
+      uint32_t network = rng->GetInteger (0, 0xffffffff) & mask;
+      routing->AddNetworkRouteTo (Ipv4Address (network), Ipv4Mask (mask),
+                                  Ipv4Address ("10.0.0.2"), 1);
+      routes.push_back (routing->GetRoute (i));
+      dests.push_back (Ipv4Address (network | (rng->GetInteger (0, 0xffffffff) & ~mask)));
+    }
+  routing->AddNetworkRouteTo ("0.0.0.0", Ipv4Mask::GetZero (), "10.0.0.2", 1);
+  routes.push_back (routing->GetRoute (nRoutes));
+
+  Ipv4Header header;
+  Socket::SocketErrno sockerr;
+  uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+  for (uint32_t j = 0; j < minIterations; j++)
+    {
+      SystemWallClockMs time;
+      time.Start ();
+      for (uint32_t i = 0; i < n; i++)
+        {
+          header.SetDestination (dests[i % nRoutes]);
+          routing->RouteOutput (0, header, 0, sockerr);
+        }
+      uint64_t delay = time.End ();
+      minDelay = std::min (minDelay, delay);
+    }
+  printResult (n, minDelay, "Ipv4GlobalRouting::RouteOutput (prefix trie)");
+
+  minDelay = std::numeric_limits<uint64_t>::max ();
+  uint32_t lookups = std::max<uint32_t> (n / 100, 1);
+  for (uint32_t j = 0; j < minIterations; j++)
+    {
+      SystemWallClockMs time;
+      time.Start ();
+      for (uint32_t i = 0; i < lookups; i++)
+        {
+          linearLookup (routes, dests[i % nRoutes]);
+        }
+      uint64_t delay = time.End ();
+      minDelay = std::min (minDelay, delay);
+    }
+  printResult (lookups, minDelay, "linear scan (n/100 lookups)");
+
+  Simulator::Destroy ();
+  return 0;
+}
@@ -21,6 +21,8 @@
 // This program can be used to benchmark packet serialization/deserialization
 // operations using Headers and Tags, for various numbers of packets 'n'
 // Sample usage:  ./waf --run 'bench-packets --n=10000'
+// Each benchmark can also run in several threads at once, which each
+// simulate n packets:  ./waf --run 'bench-packets --n=10000 --threads=4'
 
 #include "ns3/command-line.h"
 #include "ns3/system-wall-clock-ms.h"
@@ -32,6 +34,9 @@
 #include <stdlib.h> // for exit ()
 #include <limits>
 #include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 using namespace ns3;
 
@@ -328,31 +333,99 @@ benchByteTags (uint32_t n)
     }
 }
 
+static void
+benchVnf (uint32_t n)
+{
+  BenchHeader<8> udp;
+  BenchHeader<20> ipv4;
+  BenchHeader<14> ethernet;
+  BenchTag<16> tag;
+
+  // The headers that a VNF removes from and inserts into each packet it
+  // forwards, with a packet tag and no byte tags. The copy made by the
+  // channel is forwarded once the sender released the original packet.
+  for (uint32_t i = 0; i < n; i++) {
+    Ptr<Packet> p = Create<Packet> (1000);
+    p->AddPacketTag (tag);
+    p->AddHeader (udp);
+    p->AddHeader (ipv4);
+    p->AddHeader (ethernet);
+    Ptr<Packet> o = p->Copy ();
+    p = 0;
+    o->RemoveHeader (ethernet);
+    o->RemoveHeader (ipv4);
+    o->RemoveHeader (udp);
+    o->PeekPacketTag (tag);
+    o->AddHeader (udp);
+    o->AddHeader (ipv4);
+    o->AddHeader (ethernet);
+  }
+}
+
+/// Buffer free list hits of all the threads
+static std::atomic<uint64_t> g_hits (0);
+/// Buffer free list misses of all the threads
+static std::atomic<uint64_t> g_misses (0);
+
+static void
+runBenchThread (void (*bench) (uint32_t), uint32_t n)
+{
+  uint64_t hits = Buffer::GetFreeListHits ();
+  uint64_t misses = Buffer::GetFreeListMisses ();
+  (*bench) (n);
+  g_hits += Buffer::GetFreeListHits () - hits;
+  g_misses += Buffer::GetFreeListMisses () - misses;
+}
+
 static uint64_t
-runBenchOneIteration (void (*bench) (uint32_t), uint32_t n)
+runBenchOneIteration (void (*bench) (uint32_t), uint32_t n, uint32_t threads)
 {
   SystemWallClockMs time;
   time.Start ();
-  (*bench) (n);
+  if (threads == 1)
+    {
+      runBenchThread (bench, n);
+    }
+  else
+    {
+      std::vector<std::thread> workers;
+      for (uint32_t i = 0; i < threads; i++)
+        {
+          workers.push_back (std::thread (&runBenchThread, bench, n));
+        }
+      for (uint32_t i = 0; i < threads; i++)
+        {
+          workers[i].join ();
+        }
+    }
   uint64_t deltaMs = time.End ();
   return deltaMs;
 }
 
 
 static void
-runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, char const *name)
+runBench (void (*bench) (uint32_t), uint32_t n, uint32_t minIterations, uint32_t threads, char const *name)
 {
   uint64_t minDelay = std::numeric_limits<uint64_t>::max();
+  // Register the TypeIds of the headers and tags before the threads use them
+  (*bench) (1);
+  g_hits = 0;
+  g_misses = 0;
   for (uint32_t i = 0; i < minIterations; i++)
     {
-      uint64_t delay = runBenchOneIteration(bench, n);
+      uint64_t delay = runBenchOneIteration(bench, n, threads);
       minDelay = std::min(minDelay, delay);
     }
   double ps = n;
+  ps *= threads;
   ps *= 1000;
-  ps /= minDelay;
+  ps /= std::max<uint64_t> (minDelay, 1);
+  double hitRate = g_hits;
+  hitRate *= 100;
+  hitRate /= std::max<uint64_t> (g_hits + g_misses, 1);
   std::cout << ps << " packets/s"
-            << " (" << minDelay << " ms elapsed)\t"
+            << " (" << minDelay << " ms elapsed, "
+            << hitRate << "% buffer free list hits)\t"
             << name
             << std::endl;
 }
@@ -361,12 +434,14 @@ int main (int argc, char *argv[])
 {
   uint32_t n = 0;
   uint32_t minIterations = 1;
+  uint32_t threads = 1;
   bool enablePrinting = false;
 
   CommandLine cmd (__FILE__);
   cmd.Usage ("Benchmark Packet class");
   cmd.AddValue ("n", "number of iterations", n);
   cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.AddValue ("threads", "number of threads running each benchmark", threads);
   cmd.AddValue ("enable-printing", "enable packet printing", enablePrinting);
   cmd.Parse (argc, argv);
 
@@ -376,15 +451,30 @@ int main (int argc, char *argv[])
         "by command-line argument --n=(number of packets)" << std::endl;
       exit (1);
     }
-  std::cout << "Running bench-packets with n=" << n << std::endl;
+  if (threads == 0 || (threads > 1 && enablePrinting))
+    {
+      std::cerr << "Error-- the number of threads must be positive, " <<
+        "and packet printing is only supported in a single thread" << std::endl;
+      exit (1);
+    }
+  if (enablePrinting)
+    {
+      Packet::EnablePrinting ();
+    }
+  std::cout << "Running bench-packets with n=" << n << " threads=" << threads << std::endl;
   std::cout << "All tests begin by adding UDP and IPv4 headers." << std::endl;
 
-  runBench (&benchA, n, minIterations, "Copy packet, remove headers");
-  runBench (&benchB, n, minIterations, "Just add headers");
-  runBench (&benchC, n, minIterations, "Remove by func call");
-  runBench (&benchD, n, minIterations, "Intermixed add/remove headers and tags");
-  runBench (&benchFragment, n, minIterations, "Fragmentation and concatenation");
-  runBench (&benchByteTags, n, minIterations, "Benchmark byte tags");
+  runBench (&benchA, n, minIterations, threads, "Copy packet, remove headers");
+  runBench (&benchB, n, minIterations, threads, "Just add headers");
+  runBench (&benchC, n, minIterations, threads, "Remove by func call");
+  runBench (&benchD, n, minIterations, threads, "Intermixed add/remove headers and tags");
+  runBench (&benchFragment, n, minIterations, threads, "Fragmentation and concatenation");
+  // The free list of the byte tags is shared by all the threads
+  if (threads == 1)
+    {
+      runBench (&benchByteTags, n, minIterations, threads, "Benchmark byte tags");
+    }
+  runBench (&benchVnf, n, minIterations, threads, "Forward through a VNF with a packet tag");
 
   return 0;
 }
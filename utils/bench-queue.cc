@@ -0,0 +1,152 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program can be used to benchmark the enqueue/dequeue operations of
+// packet queues at several queue depths. The DropTailQueue (ring buffer
+// storage) is compared with an equivalent FIFO queue using the list storage.
+// Sample usage:  ./waf --run 'bench-queue --n=1000000'
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/packet.h"
+#include "ns3/drop-tail-queue.h"
+#include <iostream>
+#include <stdlib.h> // for exit ()
+#include <limits>
+#include <algorithm>
+
+using namespace ns3;
+
+/// FIFO queue using the list (iterator-based) storage of the Queue class
+class ListFifoQueue : public Queue<Packet>
+{
+public:
+  /**
+   * Register this type.
+   * \return The TypeId.
+   */
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("anon::ListFifoQueue")
+      .SetParent<Queue<Packet> > ()
+      .SetGroupName ("Utils")
+      .HideFromDocumentation ()
+      .AddConstructor<ListFifoQueue> ()
+      ;
+    return tid;
+  }
+  virtual bool Enqueue (Ptr<Packet> item)
+  {
+    return DoEnqueue (end (), item);
+  }
+  virtual Ptr<Packet> Dequeue (void)
+  {
+    return DoDequeue (begin ());
+  }
+  virtual Ptr<Packet> Remove (void)
+  {
+    return DoRemove (begin ());
+  }
+  virtual Ptr<const Packet> Peek (void) const
+  {
+    return DoPeek (begin ());
+  }
+};
+
+/**
+ * Run n enqueue/dequeue pairs on a queue holding a constant number of packets.
+ * \param queue the queue
+ * \param depth the number of packets in the queue
+ * \param n the number of enqueue/dequeue pairs
+ */
+static void
+benchQueue (Ptr<Queue<Packet> > queue, uint32_t depth, uint32_t n)
+{
+  queue->SetMaxSize (QueueSize (QueueSizeUnit::PACKETS, depth + 1));
+  Ptr<Packet> p = Create<Packet> (1000);
+  for (uint32_t i = 0; i < depth; i++)
+    {
+      queue->Enqueue (p);
+    }
+  for (uint32_t i = 0; i < n; i++)
+    {
+      queue->Enqueue (p);
+      p = queue->Dequeue ();
+    }
+  queue->Flush ();
+}
+
+/**
+ * Run the benchmark and print the number of queue operations per second.
+ * \param queue the queue
+ * \param depth the number of packets in the queue
+ * \param n the number of enqueue/dequeue pairs
+ * \param minIterations the number of iterations to minimize the time over
+ * \param name the queue name
+ */
+static void
+runBench (Ptr<Queue<Packet> > queue, uint32_t depth, uint32_t n,
+          uint32_t minIterations, char const *name)
+{
+  uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+  for (uint32_t i = 0; i < minIterations; i++)
+    {
+      SystemWallClockMs time;
+      time.Start ();
+      benchQueue (queue, depth, n);
+      uint64_t delay = time.End ();
+      minDelay = std::min (minDelay, delay);
+    }
+  // Each iteration runs one enqueue and one dequeue operation.
+  double ops = 2.0 * n;
+  ops *= 1000;
+  ops /= std::max<uint64_t> (minDelay, 1);
+  std::cout << ops << " ops/s"
+            << " (" << minDelay << " ms elapsed)\t"
+            << name << " depth=" << depth
+            << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t minIterations = 1;
+
+  CommandLine cmd (__FILE__);
+  cmd.Usage ("Benchmark Queue class");
+  cmd.AddValue ("n", "number of enqueue/dequeue pairs", n);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.Parse (argc, argv);
+
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of operations must be specified " <<
+        "by command-line argument --n=(number of operations)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-queue with n=" << n << std::endl;
+
+  uint32_t depths[] = {0, 16, 256, 4096};
+  for (uint32_t depth : depths)
+    {
+      runBench (CreateObject<DropTailQueue<Packet> > (), depth, n, minIterations,
+                "DropTailQueue (ring buffer)");
+      runBench (CreateObject<ListFifoQueue> (), depth, n, minIterations,
+                "FIFO queue (list)");
+    }
+
+  return 0;
+}
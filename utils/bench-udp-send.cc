@@ -0,0 +1,197 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program can be used to benchmark the simulation of UDP senders. A
+// node sends datagrams to another one over a simple channel, and the number
+// of datagrams sent per second of wall clock time is reported for sockets
+// which are connected or not, and bound to an address or not.
+// Sample usage:  ./waf --run 'bench-udp-send --n=1000000'
+
+#include "ns3/command-line.h"
+#include "ns3/system-wall-clock-ms.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/socket.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-interface.h"
+#include "ns3/arp-cache.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/udp-socket-factory.h"
+#include <iostream>
+#include <stdlib.h> // for exit ()
+#include <limits>
+#include <algorithm>
+
+using namespace ns3;
+
+/// Number of datagrams received by the sink
+static uint32_t g_received = 0;
+
+/**
+ * Count the frames received by the device of the sink.
+ * \param device the device
+ * \param p the frame
+ * \param protocol the protocol of the frame
+ * \param from the address of the sender
+ * \return true
+ */
+static bool
+receive (Ptr<NetDevice> device, Ptr<const Packet> p, uint16_t protocol, const Address &from)
+{
+  g_received++;
+  return true;
+}
+
+/**
+ * Send a datagram, and schedule the next one.
+ * \param socket the socket
+ * \param connected true to send on the connected socket
+ * \param to the destination of the datagram
+ * \param size the size of the datagram
+ * \param n the number of datagrams left to send
+ */
+static void
+send (Ptr<Socket> socket, bool connected, InetSocketAddress to, uint32_t size, uint32_t n)
+{
+  if (connected)
+    {
+      socket->Send (Create<Packet> (size));
+    }
+  else
+    {
+      socket->SendTo (Create<Packet> (size), 0, to);
+    }
+  if (n > 1)
+    {
+      Simulator::Schedule (MicroSeconds (1), &send, socket, connected, to, size, n - 1);
+    }
+}
+
+/**
+ * Simulate the transmission of n datagrams.
+ * \param n the number of datagrams
+ * \param size the size of the datagrams
+ * \param connected true to connect the socket of the sender
+ * \param bound true to bind the socket of the sender to its address
+ * \return the elapsed time in milliseconds
+ */
+static uint64_t
+runBench (uint32_t n, uint32_t size, bool connected, bool bound)
+{
+  // Only the sender has an IPv4 stack, the frames are counted by the
+  // device of the sink so that the send path dominates the measure
+  NodeContainer nodes;
+  nodes.Create (2);
+  SimpleNetDeviceHelper simpleHelper;
+  NetDeviceContainer net = simpleHelper.Install (nodes, CreateObject<SimpleChannel> ());
+  InternetStackHelper internet;
+  internet.Install (nodes.Get (0));
+  Ptr<Ipv4L3Protocol> ipv4 = nodes.Get (0)->GetObject<Ipv4L3Protocol> ();
+  uint32_t interface = ipv4->AddInterface (net.Get (0));
+  ipv4->AddAddress (interface, Ipv4InterfaceAddress ("10.0.0.1", "255.255.255.0"));
+  ipv4->SetUp (interface);
+  ipv4->GetInterface (interface)->GetArpCache ()->AddPermanent ("10.0.0.2", net.Get (1)->GetAddress ());
+  net.Get (1)->SetReceiveCallback (MakeCallback (&receive));
+
+  InetSocketAddress to ("10.0.0.2", 9);
+  Ptr<Socket> source = Socket::CreateSocket (nodes.Get (0), UdpSocketFactory::GetTypeId ());
+  source->Bind (InetSocketAddress (bound ? Ipv4Address ("10.0.0.1") : Ipv4Address::GetAny (), 0));
+  if (connected)
+    {
+      source->Connect (to);
+    }
+  Simulator::Schedule (Seconds (1), &send, source, connected, to, size, n);
+
+  g_received = 0;
+  SystemWallClockMs time;
+  time.Start ();
+  Simulator::Run ();
+  uint64_t delay = time.End ();
+  if (g_received != n)
+    {
+      std::cerr << "Error-- " << g_received << " of " << n << " datagrams received" << std::endl;
+      exit (1);
+    }
+  Simulator::Destroy ();
+  return delay;
+}
+
+/**
+ * Print the number of datagrams simulated per second.
+ * \param n the number of datagrams
+ * \param delay the elapsed time in milliseconds
+ * \param name the socket configuration
+ */
+static void
+printResult (uint32_t n, uint64_t delay, char const *name)
+{
+  double ops = n;
+  ops *= 1000;
+  ops /= std::max<uint64_t> (delay, 1);
+  std::cout << ops << " packets/s"
+            << " (" << delay << " ms elapsed)\t"
+            << name << std::endl;
+}
+
+int main (int argc, char *argv[])
+{
+  uint32_t n = 0;
+  uint32_t size = 1000;
+  uint32_t minIterations = 1;
+
+  CommandLine cmd (__FILE__);
+  cmd.Usage ("Benchmark the simulation of UDP senders");
+  cmd.AddValue ("n", "number of datagrams", n);
+  cmd.AddValue ("size", "size of the datagrams", size);
+  cmd.AddValue ("min-iterations", "number of subiterations to minimize iteration time over", minIterations);
+  cmd.Parse (argc, argv);
+
+  if (n == 0)
+    {
+      std::cerr << "Error-- number of operations must be specified " <<
+        "by command-line argument --n=(number of operations)" << std::endl;
+      exit (1);
+    }
+  std::cout << "Running bench-udp-send with n=" << n
+            << " size=" << size << std::endl;
+
+  struct
+  {
+    bool connected;    //!< Connect the socket
+    bool bound;        //!< Bind the socket to the address of the node
+    char const *name;  //!< Name of the configuration
+  } configs[] = {
+    { true, false, "connected socket" },
+    { true, true, "connected socket bound to an address" },
+    { false, false, "SendTo" },
+    { false, true, "SendTo on a socket bound to an address" },
+  };
+  for (uint32_t i = 0; i < sizeof (configs) / sizeof (configs[0]); i++)
+    {
+      uint64_t minDelay = std::numeric_limits<uint64_t>::max ();
+      for (uint32_t j = 0; j < minIterations; j++)
+        {
+          minDelay = std::min (minDelay, runBench (n, size, configs[i].connected, configs[i].bound));
+        }
+      printResult (n, minDelay, configs[i].name);
+    }
+
+  return 0;
+}